@@ -0,0 +1,665 @@
+#ifndef CLUSTERED_LIGHTING_H
+#define CLUSTERED_LIGHTING_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define CLUSTER_SSE 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define CLUSTER_NEON 1
+#endif
+
+#include "pipeline_state.h"
+
+// --------------------- Clustered Forward Lighting ---------------------
+// Point and spot lights on top of the directional light. The view frustum is
+// divided into CLUSTER_X x CLUSTER_Y screen tiles and CLUSTER_Z depth slices
+// (exponential in view depth, so clusters stay roughly cube-shaped); every
+// frame each cluster gets the list of lights whose sphere touches it, and
+// the object shader's CLUSTERED variants only loop over their cluster's list.
+//
+// The assignment runs on the CPU in two passes:
+//   1. per light, 4 lights at a time (SSE / NEON, scalar fallback): view-space
+//      center and a conservative range of tiles and slices from the
+//      projected bounding box of its sphere
+//   2. per depth slice, one band of slices per thread: each light in range
+//      is tested against the view-space boxes of its candidate clusters,
+//      4 tiles of a row at a time, and the hits are sorted into per-cluster
+//      lists with a counting pass
+// Threads own whole slices, so they write disjoint parts of the cluster grid
+// and their own index lists, which are concatenated afterwards. Below
+// CLUSTER_MIN_LIGHTS_PER_THREAD lights per thread the pass stays on the
+// render thread; above it the bands go to worker threads that are started
+// once and then woken every frame.
+//
+// Three texture buffers go to the shader: the lights (3 texels each), the
+// grid (offset, count into the index list per cluster) and the 16-bit light
+// indices.
+
+const int CLUSTER_X = 16;
+const int CLUSTER_Y = 9;
+const int CLUSTER_Z = 24;
+const int CLUSTER_TILES = CLUSTER_X * CLUSTER_Y;
+const int CLUSTER_COUNT = CLUSTER_TILES * CLUSTER_Z;
+const int CLUSTER_MAX_LIGHTS_PER_CLUSTER = 256;      // further lights are dropped (counted as clamped)
+const int CLUSTER_MAX_SCENE_LIGHTS = 65535;          // 16-bit indices
+const int CLUSTER_MIN_LIGHTS_PER_THREAD = 256;
+const int CLUSTER_LIGHT_UNIT = 4;
+const int CLUSTER_GRID_UNIT = 5;
+const int CLUSTER_INDEX_UNIT = 6;
+
+// Exactly the shader's three texels
+struct SceneLight {
+    glm::vec3 position = glm::vec3(0.0f);
+    float radius = 1.0f;                           // influence ends here
+    glm::vec3 color = glm::vec3(1.0f);
+    float spotCosOuter = -2.0f;                    // below -1: point light
+    glm::vec3 direction = glm::vec3(0.0f, -1.0f, 0.0f);
+    float spotCosInner = -1.0f;
+};
+static_assert(sizeof(SceneLight) == 12 * sizeof(float), "SceneLight is uploaded as 3 RGBA32F texels");
+
+// Lights circle around a fixed point so the assignment has work every frame
+struct LightOrbit {
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+    float speed = 0.0f;
+    float phase = 0.0f;
+};
+
+// Candidate clusters of a light, inclusive; z0 > z1 when it is out of view
+struct ClusterRange {
+    int x0, x1, y0, y1, z0, z1;
+};
+
+struct ClusterStats {
+    double assignMs = 0.0;
+    int visibleLights = 0;
+    int indices = 0;
+    int maxPerCluster = 0;
+    int clamped = 0;              // light/cluster pairs dropped by the per-cluster cap
+};
+
+// Slice band workers; thread t takes band t, the render thread band 0
+struct ClusterWorkers {
+    // Guarded by mutex
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    uint64_t job = 0;                // bumped for every frame's pass
+    unsigned int jobThreads = 0;     // bands in the current pass
+    unsigned int pending = 0;        // worker bands not finished yet
+    bool quit = false;
+
+    // Render thread only
+    std::vector<std::thread> threads;
+};
+
+struct ClusteredLighting {
+    std::vector<SceneLight> lights;
+    std::vector<LightOrbit> orbits;
+
+    // Per light this frame, structure-of-arrays for the 4-wide passes
+    std::vector<float> worldX, worldY, worldZ, radius;
+    std::vector<float> viewX, viewY, depth;
+    std::vector<ClusterRange> ranges;
+
+    // Per cluster: view-space box (x, y, depth) and the light list
+    std::vector<float> boxMinX, boxMaxX, boxMinY, boxMaxY;
+    float sliceDepth[CLUSTER_Z + 1] = {};
+    float boxProjection[2] = {};          // projection the boxes were built for
+    std::vector<uint32_t> grid;           // offset, count
+    std::vector<uint16_t> indices;
+    std::vector<std::vector<uint16_t>> threadIndices;
+    std::vector<int> threadMaxPerCluster, threadClamped;
+
+    float nearPlane = 0.1f, farPlane = 100.0f;
+    glm::vec3 viewForward = glm::vec3(0.0f, 0.0f, -1.0f);
+    glm::vec2 tileScale = glm::vec2(0.0f);   // clusters per framebuffer pixel
+    unsigned int threadCount = 0;         // 0 = by light count
+    bool useSimd = true;                  // benchmark switch
+    int maxIndices = 0;                   // limited by GL_MAX_TEXTURE_BUFFER_SIZE
+
+    unsigned int lightBuffer = 0, lightTex = 0;
+    unsigned int gridBuffer = 0, gridTex = 0;
+    unsigned int indexBuffer = 0, indexTex = 0;
+    ClusterStats stats;
+    ClusterWorkers workers;
+};
+
+// --------------------- Light Setup ---------------------
+// count lights scattered over a square of the ground; a quarter are spots
+// pointing down. Fixed seed, so runs and benchmarks see the same scene.
+inline void createSceneLights(ClusteredLighting& c, int count, float halfExtent) {
+    count = std::min(std::max(count, 0), CLUSTER_MAX_SCENE_LIGHTS);
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    c.lights.assign(count, SceneLight());
+    c.orbits.assign(count, LightOrbit());
+    for (int i = 0; i < count; ++i) {
+        SceneLight& l = c.lights[i];
+        LightOrbit& o = c.orbits[i];
+        o.center = glm::vec3((unit(rng) * 2.0f - 1.0f) * halfExtent, 0.3f + 1.7f * unit(rng),
+                             (unit(rng) * 2.0f - 1.0f) * halfExtent);
+        o.radius = 0.5f + 2.0f * unit(rng);
+        o.speed = (unit(rng) < 0.5f ? -1.0f : 1.0f) * (0.2f + 0.8f * unit(rng));
+        o.phase = unit(rng) * 6.2831853f;
+        // Saturated hue, brighter for the spots' narrower footprint
+        float h = unit(rng) * 6.0f;
+        glm::vec3 hue = glm::clamp(glm::vec3(std::abs(h - 3.0f) - 1.0f, 2.0f - std::abs(h - 2.0f),
+                                             2.0f - std::abs(h - 4.0f)), 0.0f, 1.0f);
+        l.radius = 1.5f + 2.0f * unit(rng);
+        l.color = hue * 2.0f;
+        if (i % 4 == 3) {
+            l.color *= 2.0f;
+            l.radius *= 1.5f;
+            l.direction = glm::normalize(glm::vec3(unit(rng) - 0.5f, -2.0f, unit(rng) - 0.5f));
+            l.spotCosInner = std::cos(glm::radians(20.0f));
+            l.spotCosOuter = std::cos(glm::radians(30.0f));
+        }
+    }
+    c.worldX.resize(count);
+    c.worldY.resize(count);
+    c.worldZ.resize(count);
+    c.radius.resize(count);
+    c.viewX.resize(count);
+    c.viewY.resize(count);
+    c.depth.resize(count);
+    c.ranges.resize(count);
+}
+
+inline void updateSceneLights(ClusteredLighting& c, float time) {
+    for (size_t i = 0; i < c.lights.size(); ++i) {
+        const LightOrbit& o = c.orbits[i];
+        float a = o.phase + o.speed * time;
+        SceneLight& l = c.lights[i];
+        l.position = o.center + glm::vec3(std::cos(a), 0.0f, std::sin(a)) * o.radius;
+        c.worldX[i] = l.position.x;
+        c.worldY[i] = l.position.y;
+        c.worldZ[i] = l.position.z;
+        c.radius[i] = l.radius;
+    }
+}
+
+// --------------------- Cluster Boxes ---------------------
+// View space with depth positive into the screen. A tile's x extent over a
+// slice is the wider of its near and far cross sections.
+inline void buildClusterBoxes(ClusteredLighting& c, float projX, float projY) {
+    c.boxProjection[0] = projX;
+    c.boxProjection[1] = projY;
+    for (int z = 0; z <= CLUSTER_Z; ++z)
+        c.sliceDepth[z] = c.nearPlane * std::pow(c.farPlane / c.nearPlane, (float)z / CLUSTER_Z);
+    c.boxMinX.resize(CLUSTER_COUNT);
+    c.boxMaxX.resize(CLUSTER_COUNT);
+    c.boxMinY.resize(CLUSTER_COUNT);
+    c.boxMaxY.resize(CLUSTER_COUNT);
+    for (int z = 0; z < CLUSTER_Z; ++z) {
+        float dn = c.sliceDepth[z], df = c.sliceDepth[z + 1];
+        for (int y = 0; y < CLUSTER_Y; ++y)
+            for (int x = 0; x < CLUSTER_X; ++x) {
+                int i = z * CLUSTER_TILES + y * CLUSTER_X + x;
+                float nx0 = -1.0f + 2.0f * x / CLUSTER_X, nx1 = -1.0f + 2.0f * (x + 1) / CLUSTER_X;
+                float ny0 = -1.0f + 2.0f * y / CLUSTER_Y, ny1 = -1.0f + 2.0f * (y + 1) / CLUSTER_Y;
+                c.boxMinX[i] = std::min(nx0 * dn, nx0 * df) / projX;
+                c.boxMaxX[i] = std::max(nx1 * dn, nx1 * df) / projX;
+                c.boxMinY[i] = std::min(ny0 * dn, ny0 * df) / projY;
+                c.boxMaxY[i] = std::max(ny1 * dn, ny1 * df) / projY;
+            }
+    }
+}
+
+inline int clusterSlice(const ClusteredLighting& c, float depth) {
+    int z = (int)(std::upper_bound(c.sliceDepth, c.sliceDepth + CLUSTER_Z + 1, depth) - c.sliceDepth) - 1;
+    return std::min(std::max(z, 0), CLUSTER_Z - 1);
+}
+
+// --------------------- Pass 1: Light Ranges ---------------------
+// From a light's tile coordinates (fractional, unclamped) and depth
+inline void finishLightRange(ClusteredLighting& c, size_t i, float tx0, float tx1, float ty0, float ty1,
+                             float depth, float r) {
+    ClusterRange& out = c.ranges[i];
+    // Clamped in float first: lights right at the eye project to huge values
+    float fx0 = std::floor(tx0), fx1 = std::floor(tx1);
+    float fy0 = std::floor(ty0), fy1 = std::floor(ty1);
+    out.x0 = (int)std::max(fx0, 0.0f);
+    out.x1 = (int)std::min(fx1, (float)(CLUSTER_X - 1));
+    out.y0 = (int)std::max(fy0, 0.0f);
+    out.y1 = (int)std::min(fy1, (float)(CLUSTER_Y - 1));
+    bool visible = depth + r > c.nearPlane && depth - r < c.farPlane &&
+                   fx1 >= 0.0f && fx0 < CLUSTER_X && fy1 >= 0.0f && fy0 < CLUSTER_Y;
+    out.z0 = visible ? clusterSlice(c, depth - r) : 1;
+    out.z1 = visible ? clusterSlice(c, depth + r) : 0;
+}
+
+// view rows 0..2 (x, y, -depth); projX/Y = projection[0][0], [1][1].
+// Same operations in the same order as the 4-wide version.
+inline void lightRangeScalar(ClusteredLighting& c, size_t i, const float* rows, float projX, float projY) {
+    float px = c.worldX[i], py = c.worldY[i], pz = c.worldZ[i], r = c.radius[i];
+    auto row = [&](const float* m) { return (m[0] * px + m[1] * py) + (m[2] * pz + m[3]); };
+    float vx = row(rows), vy = row(rows + 4), d = 0.0f - row(rows + 8);
+    c.viewX[i] = vx;
+    c.viewY[i] = vy;
+    c.depth[i] = d;
+    float dn = std::max(d - r, c.nearPlane), df = std::max(d + r, c.nearPlane);
+    auto tiles = [&](float v, float proj, int count, float& lo, float& hi) {
+        float a = v - r, b = v + r;
+        lo = ((std::min(a / dn, a / df) * proj) * 0.5f + 0.5f) * (float)count;
+        hi = ((std::max(b / dn, b / df) * proj) * 0.5f + 0.5f) * (float)count;
+    };
+    float tx0, tx1, ty0, ty1;
+    tiles(vx, projX, CLUSTER_X, tx0, tx1);
+    tiles(vy, projY, CLUSTER_Y, ty0, ty1);
+    finishLightRange(c, i, tx0, tx1, ty0, ty1, d, r);
+}
+
+#if CLUSTER_SSE || CLUSTER_NEON
+#if CLUSTER_SSE
+typedef __m128 ClusterLanes;
+inline ClusterLanes clusterSet(float v) { return _mm_set1_ps(v); }
+inline ClusterLanes clusterLoad(const float* p) { return _mm_loadu_ps(p); }
+inline void clusterStore(float* p, ClusterLanes a) { _mm_storeu_ps(p, a); }
+inline ClusterLanes clusterAdd(ClusterLanes a, ClusterLanes b) { return _mm_add_ps(a, b); }
+inline ClusterLanes clusterSub(ClusterLanes a, ClusterLanes b) { return _mm_sub_ps(a, b); }
+inline ClusterLanes clusterMul(ClusterLanes a, ClusterLanes b) { return _mm_mul_ps(a, b); }
+inline ClusterLanes clusterDiv(ClusterLanes a, ClusterLanes b) { return _mm_div_ps(a, b); }
+inline ClusterLanes clusterMin(ClusterLanes a, ClusterLanes b) { return _mm_min_ps(a, b); }
+inline ClusterLanes clusterMax(ClusterLanes a, ClusterLanes b) { return _mm_max_ps(a, b); }
+// Bit k set where lane k of a <= b
+inline int clusterLessEqualMask(ClusterLanes a, ClusterLanes b) { return _mm_movemask_ps(_mm_cmple_ps(a, b)); }
+#else
+typedef float32x4_t ClusterLanes;
+inline ClusterLanes clusterSet(float v) { return vdupq_n_f32(v); }
+inline ClusterLanes clusterLoad(const float* p) { return vld1q_f32(p); }
+inline void clusterStore(float* p, ClusterLanes a) { vst1q_f32(p, a); }
+inline ClusterLanes clusterAdd(ClusterLanes a, ClusterLanes b) { return vaddq_f32(a, b); }
+inline ClusterLanes clusterSub(ClusterLanes a, ClusterLanes b) { return vsubq_f32(a, b); }
+inline ClusterLanes clusterMul(ClusterLanes a, ClusterLanes b) { return vmulq_f32(a, b); }
+inline ClusterLanes clusterDiv(ClusterLanes a, ClusterLanes b) { return vdivq_f32(a, b); }
+inline ClusterLanes clusterMin(ClusterLanes a, ClusterLanes b) { return vminq_f32(a, b); }
+inline ClusterLanes clusterMax(ClusterLanes a, ClusterLanes b) { return vmaxq_f32(a, b); }
+inline int clusterLessEqualMask(ClusterLanes a, ClusterLanes b) {
+    static const uint32_t bits[4] = { 1, 2, 4, 8 };
+    return (int)vaddvq_u32(vandq_u32(vcleq_f32(a, b), vld1q_u32(bits)));
+}
+#endif
+
+// Four lights from i: the transforms and projected bounds 4-wide, then the
+// slice lookups per light
+inline void lightRanges4(ClusteredLighting& c, size_t i, const float* rows, float projX, float projY) {
+    ClusterLanes px = clusterLoad(&c.worldX[i]), py = clusterLoad(&c.worldY[i]), pz = clusterLoad(&c.worldZ[i]);
+    ClusterLanes r = clusterLoad(&c.radius[i]);
+    auto row = [&](const float* m) {
+        return clusterAdd(clusterAdd(clusterMul(clusterSet(m[0]), px), clusterMul(clusterSet(m[1]), py)),
+                          clusterAdd(clusterMul(clusterSet(m[2]), pz), clusterSet(m[3])));
+    };
+    ClusterLanes vx = row(rows), vy = row(rows + 4);
+    ClusterLanes d = clusterSub(clusterSet(0.0f), row(rows + 8));
+    ClusterLanes nearPlane = clusterSet(c.nearPlane);
+    ClusterLanes dn = clusterMax(clusterSub(d, r), nearPlane), df = clusterMax(clusterAdd(d, r), nearPlane);
+    ClusterLanes half = clusterSet(0.5f);
+    auto tiles = [&](ClusterLanes v, float proj, int count, ClusterLanes& lo, ClusterLanes& hi) {
+        ClusterLanes a = clusterSub(v, r), b = clusterAdd(v, r);
+        ClusterLanes scale = clusterSet(proj);
+        ClusterLanes ndc0 = clusterMul(clusterMin(clusterDiv(a, dn), clusterDiv(a, df)), scale);
+        ClusterLanes ndc1 = clusterMul(clusterMax(clusterDiv(b, dn), clusterDiv(b, df)), scale);
+        ClusterLanes toTile = clusterSet((float)count);
+        lo = clusterMul(clusterAdd(clusterMul(ndc0, half), half), toTile);
+        hi = clusterMul(clusterAdd(clusterMul(ndc1, half), half), toTile);
+    };
+    ClusterLanes tx0, tx1, ty0, ty1;
+    tiles(vx, projX, CLUSTER_X, tx0, tx1);
+    tiles(vy, projY, CLUSTER_Y, ty0, ty1);
+    clusterStore(&c.viewX[i], vx);
+    clusterStore(&c.viewY[i], vy);
+    clusterStore(&c.depth[i], d);
+    float lanes[4][4], radii[4];
+    clusterStore(lanes[0], tx0);
+    clusterStore(lanes[1], tx1);
+    clusterStore(lanes[2], ty0);
+    clusterStore(lanes[3], ty1);
+    clusterStore(radii, r);
+    for (int k = 0; k < 4; ++k)
+        finishLightRange(c, i + k, lanes[0][k], lanes[1][k], lanes[2][k], lanes[3][k], c.depth[i + k], radii[k]);
+}
+#endif
+
+// --------------------- Pass 2: Cluster Lists ---------------------
+// Sphere against the view-space boxes of tiles [x0, x1] of one row; calls
+// hit(x) for each overlap. Four tiles at a time where SIMD is available.
+template <typename Hit>
+inline void testLightRow(const ClusteredLighting& c, int rowStart, int x0, int x1,
+                         float vx, float vy, float rest, float r2, Hit hit) {
+    int x = x0;
+#if CLUSTER_SSE || CLUSTER_NEON
+    if (c.useSimd) {
+        ClusterLanes cx = clusterSet(vx), cy = clusterSet(vy), zero = clusterSet(0.0f);
+        ClusterLanes limit = clusterSet(r2 - rest);
+        for (; x + 3 <= x1; x += 4) {
+            int i = rowStart + x;
+            ClusterLanes dx = clusterMax(clusterMax(clusterSub(clusterLoad(&c.boxMinX[i]), cx),
+                                                    clusterSub(cx, clusterLoad(&c.boxMaxX[i]))), zero);
+            ClusterLanes dy = clusterMax(clusterMax(clusterSub(clusterLoad(&c.boxMinY[i]), cy),
+                                                    clusterSub(cy, clusterLoad(&c.boxMaxY[i]))), zero);
+            int mask = clusterLessEqualMask(clusterAdd(clusterMul(dx, dx), clusterMul(dy, dy)), limit);
+            for (int k = 0; k < 4; ++k)
+                if (mask & (1 << k))
+                    hit(x + k);
+        }
+    }
+#endif
+    for (; x <= x1; ++x) {
+        int i = rowStart + x;
+        float dx = std::max(std::max(c.boxMinX[i] - vx, vx - c.boxMaxX[i]), 0.0f);
+        float dy = std::max(std::max(c.boxMinY[i] - vy, vy - c.boxMaxY[i]), 0.0f);
+        if (dx * dx + dy * dy + rest <= r2)
+            hit(x);
+    }
+}
+
+// Slices [z0, z1) into thread slot t: grid entries get offsets into the
+// slot's own index list
+inline void assignClusterSlices(ClusteredLighting& c, int z0, int z1, int t) {
+    std::vector<uint16_t>& out = c.threadIndices[t];
+    out.clear();
+    int maxPerCluster = 0, clamped = 0;
+    std::vector<uint32_t> hits;          // tile << 16 | light
+    for (int z = z0; z < z1; ++z) {
+        hits.clear();
+        float dn = c.sliceDepth[z], df = c.sliceDepth[z + 1];
+        for (size_t l = 0; l < c.ranges.size(); ++l) {
+            const ClusterRange& range = c.ranges[l];
+            if (z < range.z0 || z > range.z1)
+                continue;
+            float d = c.depth[l], r = c.radius[l];
+            float dz = std::max(std::max(dn - d, d - df), 0.0f);
+            float r2 = r * r;
+            for (int y = range.y0; y <= range.y1; ++y)
+                testLightRow(c, z * CLUSTER_TILES + y * CLUSTER_X, range.x0, range.x1, c.viewX[l], c.viewY[l],
+                             dz * dz, r2, [&](int x) { hits.push_back((uint32_t)(y * CLUSTER_X + x) << 16 | (uint32_t)l); });
+        }
+        // Counting sort by tile; hits are in light order, so lists are too
+        int counts[CLUSTER_TILES] = {};
+        for (uint32_t h : hits)
+            counts[h >> 16]++;
+        int starts[CLUSTER_TILES];
+        int base = (int)out.size();
+        for (int tile = 0; tile < CLUSTER_TILES; ++tile) {
+            int n = std::min(counts[tile], CLUSTER_MAX_LIGHTS_PER_CLUSTER);
+            clamped += counts[tile] - n;
+            maxPerCluster = std::max(maxPerCluster, counts[tile]);
+            uint32_t* g = &c.grid[(size_t)(z * CLUSTER_TILES + tile) * 2];
+            g[0] = (uint32_t)base;
+            g[1] = (uint32_t)n;
+            starts[tile] = base;
+            base += n;
+        }
+        out.resize(base);
+        for (uint32_t h : hits) {
+            int tile = h >> 16;
+            uint32_t* g = &c.grid[(size_t)(z * CLUSTER_TILES + tile) * 2];
+            if (starts[tile] < (int)(g[0] + g[1]))
+                out[starts[tile]++] = (uint16_t)(h & 0xFFFF);
+        }
+    }
+    c.threadMaxPerCluster[t] = maxPerCluster;
+    c.threadClamped[t] = clamped;
+}
+
+// Worker thread t: sleeps until a pass with a band for it is posted
+inline void clusterWorkerLoop(ClusteredLighting* c, unsigned int t, uint64_t seen) {
+    ClusterWorkers& w = c->workers;
+    std::unique_lock<std::mutex> lock(w.mutex);
+    while (true) {
+        w.wake.wait(lock, [&] { return w.quit || w.job != seen; });
+        if (w.quit)
+            return;
+        seen = w.job;
+        unsigned int threads = w.jobThreads;
+        if (t >= threads)
+            continue;
+        lock.unlock();
+        assignClusterSlices(*c, CLUSTER_Z * t / threads, CLUSTER_Z * (t + 1) / threads, t);
+        lock.lock();
+        if (--w.pending == 0)
+            w.done.notify_one();
+    }
+}
+
+// Split the slices into `threads` bands; band 0 runs on the calling thread.
+// Workers are started the first time they are needed.
+inline void runClusterWorkers(ClusteredLighting& c, unsigned int threads) {
+    ClusterWorkers& w = c.workers;
+    while (w.threads.size() + 1 < threads)
+        w.threads.emplace_back(clusterWorkerLoop, &c, (unsigned int)w.threads.size() + 1, w.job);
+    {
+        std::lock_guard<std::mutex> lock(w.mutex);
+        w.job++;
+        w.jobThreads = threads;
+        w.pending = threads - 1;
+    }
+    w.wake.notify_all();
+    assignClusterSlices(c, 0, CLUSTER_Z / threads, 0);
+    std::unique_lock<std::mutex> lock(w.mutex);
+    w.done.wait(lock, [&] { return w.pending == 0; });
+}
+
+inline void stopClusterWorkers(ClusteredLighting& c) {
+    ClusterWorkers& w = c.workers;
+    {
+        std::lock_guard<std::mutex> lock(w.mutex);
+        w.quit = true;
+    }
+    w.wake.notify_all();
+    for (std::thread& t : w.threads)
+        t.join();
+    w.threads.clear();
+    w.quit = false;
+}
+
+// Build this frame's cluster lists on the CPU (no GL calls)
+inline void assignLightClusters(ClusteredLighting& c, const glm::mat4& view, const glm::mat4& projection) {
+    auto start = std::chrono::high_resolution_clock::now();
+    float projX = projection[0][0], projY = projection[1][1];
+    if (projX != c.boxProjection[0] || projY != c.boxProjection[1])
+        buildClusterBoxes(c, projX, projY);
+    c.viewForward = -glm::vec3(view[0][2], view[1][2], view[2][2]);
+
+    float rows[12];
+    for (int r = 0; r < 3; ++r)
+        for (int k = 0; k < 4; ++k)
+            rows[r * 4 + k] = view[k][r];
+    size_t count = c.lights.size(), i = 0;
+#if CLUSTER_SSE || CLUSTER_NEON
+    if (c.useSimd)
+        for (; i + 4 <= count; i += 4)
+            lightRanges4(c, i, rows, projX, projY);
+#endif
+    for (; i < count; ++i)
+        lightRangeScalar(c, i, rows, projX, projY);
+
+    unsigned int threads = c.threadCount;
+    if (threads == 0) {
+        unsigned int hw = std::max(1u, std::thread::hardware_concurrency());
+        threads = (unsigned int)std::min<size_t>(hw, count / CLUSTER_MIN_LIGHTS_PER_THREAD);
+    }
+    threads = std::max(1u, std::min(threads, (unsigned int)CLUSTER_Z));
+    c.threadIndices.resize(threads);
+    c.threadMaxPerCluster.assign(threads, 0);
+    c.threadClamped.assign(threads, 0);
+    c.grid.resize((size_t)CLUSTER_COUNT * 2);
+    if (threads > 1)
+        runClusterWorkers(c, threads);
+    else
+        assignClusterSlices(c, 0, CLUSTER_Z, 0);
+
+    // Concatenate the slots' lists and rebase their grid entries
+    c.stats = ClusterStats();
+    size_t total = 0;
+    for (unsigned int t = 0; t < threads; ++t)
+        total += c.threadIndices[t].size();
+    c.indices.resize(total);
+    size_t base = 0;
+    for (unsigned int t = 0; t < threads; ++t) {
+        std::copy(c.threadIndices[t].begin(), c.threadIndices[t].end(), c.indices.begin() + base);
+        for (int z = CLUSTER_Z * t / threads; z < (int)(CLUSTER_Z * (t + 1) / threads); ++z)
+            for (int tile = 0; tile < CLUSTER_TILES; ++tile)
+                c.grid[(size_t)(z * CLUSTER_TILES + tile) * 2] += (uint32_t)base;
+        base += c.threadIndices[t].size();
+        c.stats.maxPerCluster = std::max(c.stats.maxPerCluster, c.threadMaxPerCluster[t]);
+        c.stats.clamped += c.threadClamped[t];
+    }
+    for (const ClusterRange& range : c.ranges)
+        c.stats.visibleLights += range.z0 <= range.z1;
+    c.stats.indices = (int)total;
+    c.stats.assignMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// --------------------- GL Side ---------------------
+inline void createClusterBuffer(unsigned int& buffer, unsigned int& texture, int unit, GLenum format) {
+    glGenBuffers(1, &buffer);
+    glGenTextures(1, &texture);
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    glBufferData(GL_TEXTURE_BUFFER, 0, nullptr, GL_STREAM_DRAW);
+    bindTexture(unit, GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+}
+
+inline void initClusteredLighting(ClusteredLighting& c, int lightCount, float nearPlane, float farPlane) {
+    c.nearPlane = nearPlane;
+    c.farPlane = farPlane;
+    GLint maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    c.maxIndices = maxTexels;
+    if ((long long)lightCount * 3 > maxTexels) {
+        lightCount = maxTexels / 3;
+        std::cout << "Clustered lights: limited to " << lightCount << " by GL_MAX_TEXTURE_BUFFER_SIZE" << std::endl;
+    }
+    createSceneLights(c, lightCount, 40.0f);
+    createClusterBuffer(c.lightBuffer, c.lightTex, CLUSTER_LIGHT_UNIT, GL_RGBA32F);
+    createClusterBuffer(c.gridBuffer, c.gridTex, CLUSTER_GRID_UNIT, GL_RG32UI);
+    createClusterBuffer(c.indexBuffer, c.indexTex, CLUSTER_INDEX_UNIT, GL_R16UI);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+// Move the lights, assign them and upload the three buffers
+inline void updateClusteredLighting(ClusteredLighting& c, float time, const glm::mat4& view, const glm::mat4& projection,
+                                    int fbWidth, int fbHeight) {
+    c.tileScale = glm::vec2((float)CLUSTER_X / fbWidth, (float)CLUSTER_Y / fbHeight);
+    updateSceneLights(c, time);
+    assignLightClusters(c, view, projection);
+    if ((int)c.indices.size() > c.maxIndices) {
+        // Past the texel limit: cut the lists that reach beyond it
+        for (int i = 0; i < CLUSTER_COUNT; ++i) {
+            uint32_t* g = &c.grid[(size_t)i * 2];
+            uint32_t end = std::min<uint32_t>(g[0] + g[1], (uint32_t)c.maxIndices);
+            c.stats.clamped += (int)(g[0] + g[1] - std::max(end, g[0]));
+            g[1] = end > g[0] ? end - g[0] : 0;
+        }
+        c.indices.resize(c.maxIndices);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, c.lightBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, c.lights.size() * sizeof(SceneLight), c.lights.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, c.gridBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, c.grid.size() * sizeof(uint32_t), c.grid.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, c.indexBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, c.indices.size() * sizeof(uint16_t), c.indices.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+// For programs built with CLUSTERED; the program must be current
+inline void setClusterUniforms(unsigned int program, const ClusteredLighting& c) {
+    bindTexture(CLUSTER_LIGHT_UNIT, GL_TEXTURE_BUFFER, c.lightTex);
+    bindTexture(CLUSTER_GRID_UNIT, GL_TEXTURE_BUFFER, c.gridTex);
+    bindTexture(CLUSTER_INDEX_UNIT, GL_TEXTURE_BUFFER, c.indexTex);
+    glUniform1i(glGetUniformLocation(program, "clusterLights"), CLUSTER_LIGHT_UNIT);
+    glUniform1i(glGetUniformLocation(program, "clusterGrid"), CLUSTER_GRID_UNIT);
+    glUniform1i(glGetUniformLocation(program, "clusterLightIndices"), CLUSTER_INDEX_UNIT);
+    glUniform3i(glGetUniformLocation(program, "clusterDims"), CLUSTER_X, CLUSTER_Y, CLUSTER_Z);
+    glUniform2f(glGetUniformLocation(program, "clusterTileScale"), c.tileScale.x, c.tileScale.y);
+    glUniform3f(glGetUniformLocation(program, "clusterViewForward"), c.viewForward.x, c.viewForward.y, c.viewForward.z);
+    // slice = log(depth) * scale + bias, the inverse of sliceDepth[]
+    float scale = CLUSTER_Z / std::log(c.farPlane / c.nearPlane);
+    glUniform2f(glGetUniformLocation(program, "clusterSliceParams"), scale, -std::log(c.nearPlane) * scale);
+}
+
+inline void destroyClusteredLighting(ClusteredLighting& c) {
+    stopClusterWorkers(c);
+    glDeleteTextures(1, &c.lightTex);
+    glDeleteTextures(1, &c.gridTex);
+    glDeleteTextures(1, &c.indexTex);
+    glDeleteBuffers(1, &c.lightBuffer);
+    glDeleteBuffers(1, &c.gridBuffer);
+    glDeleteBuffers(1, &c.indexBuffer);
+}
+
+// --------------------- Light Assignment Benchmark ---------------------
+// CPU cost of assigning 10 to 10k lights from a fixed camera over the light
+// field, scalar and SIMD on one thread and SIMD threaded; best of N runs.
+// Also reports how many lights a cluster sees, which is what the fragment
+// shader pays per pixel.
+inline void benchmarkClusteredLighting() {
+    using Clock = std::chrono::high_resolution_clock;
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 6.0f, 30.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+    auto bestMs = [&](ClusteredLighting& c) {
+        double best = 1e30, total = 0.0;
+        for (int run = 0; run < 200 && (run < 3 || total < 200.0); ++run) {
+            auto begin = Clock::now();
+            assignLightClusters(c, view, projection);
+            double ms = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+            best = std::min(best, ms);
+            total += ms;
+        }
+        return best;
+    };
+
+    unsigned int hw = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "Clustered light assignment, " << CLUSTER_X << "x" << CLUSTER_Y << "x" << CLUSTER_Z
+              << " clusters (best of N, ms) - " << hw << " hardware threads" << std::endl;
+    std::cout << std::setw(8) << "lights" << std::setw(10) << "visible" << std::setw(10) << "scalar"
+              << std::setw(10) << "SIMD" << std::setw(10) << "threaded" << std::setw(10) << "speedup"
+              << std::setw(12) << "avg/cluster" << std::setw(12) << "max/cluster" << std::setw(10) << "clamped"
+              << std::endl;
+    for (int count = 10; count <= 10000; count *= 10) {
+        ClusteredLighting c;
+        createSceneLights(c, count, 40.0f);
+        updateSceneLights(c, 0.0f);
+        c.threadCount = 1;
+        c.useSimd = false;
+        double scalarMs = bestMs(c);
+        std::vector<uint32_t> scalarGrid = c.grid;
+        std::vector<uint16_t> scalarIndices = c.indices;
+        c.useSimd = true;
+        double simdMs = bestMs(c);
+        c.threadCount = hw;
+        double threadedMs = bestMs(c);
+        if (c.grid != scalarGrid || c.indices != scalarIndices)
+            std::cout << "ERROR::CLUSTERS::MISMATCH: SIMD/threaded lists differ from scalar at " << count << " lights" << std::endl;
+        std::cout << std::fixed << std::setprecision(3)
+                  << std::setw(8) << count << std::setw(10) << c.stats.visibleLights
+                  << std::setw(10) << scalarMs << std::setw(10) << simdMs << std::setw(10) << threadedMs
+                  << std::setw(9) << std::setprecision(1) << scalarMs / threadedMs << "x"
+                  << std::setw(12) << std::setprecision(2) << (double)c.stats.indices / CLUSTER_COUNT
+                  << std::setw(12) << c.stats.maxPerCluster << std::setw(10) << c.stats.clamped << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+        stopClusterWorkers(c);
+    }
+}
+
+#endif
@@ -0,0 +1,165 @@
+#ifndef DEFERRED_RENDERER_H
+#define DEFERRED_RENDERER_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <iostream>
+#include <string>
+
+#include "pipeline_state.h"
+#include "shader_permutations.h"
+
+// Defined in main.cpp
+unsigned int createShaderProgram(const char* vertSrc, const char* fragSrc);
+
+// --------------------- Deferred Shading ---------------------
+// With --deferred the object shader variants are built from gbuffer.frag
+// instead of object.frag, so every draw path (render queue, indirect,
+// tessellation, terrain) writes a compact G-buffer rather than lit color:
+//   0      RGBA8     albedo; alpha holds the material bits (lighting model)
+//   1      RG16      normal, octahedral encoding
+//   depth  DEPTH24   position is reconstructed from it with the inverse
+//                    view-projection, so there is no position target
+// 8 bytes of color per pixel. The lighting pass is one fullscreen triangle
+// that shades each pixel once however much overdraw the geometry had: the
+// sun with the pixel's lighting model, shadows, IBL, fog, and the point and
+// spot lights of its tile.
+//
+// GL 3.3 has no compute shaders to cull lights per screen tile on the GPU,
+// so the tile light lists are the CPU ones of clustered_lighting.h, whose
+// tiles are also split in depth; no per-tile depth bounds are needed.
+// Pixels nothing was drawn on are shaded with the skybox in the same pass,
+// so the sky isn't drawn separately. The pass also writes the G-buffer depth
+// to the framebuffer it shades into, for Hi-Z and anything drawn after it.
+
+const int GBUFFER_ALBEDO_UNIT = 8;
+const int GBUFFER_NORMAL_UNIT = 9;
+const int GBUFFER_DEPTH_UNIT = 10;
+
+struct DeferredRenderer {
+    unsigned int fbo = 0;
+    unsigned int albedoTex = 0, normalTex = 0, depthTex = 0;
+    int width = 0, height = 0;
+    unsigned int program = 0;
+    unsigned int vao = 0;            // empty, the triangle comes from gl_VertexID
+    PipelineState pipeline;
+    GLint targetFBO = 0;             // bound when the geometry pass started
+};
+
+// The lighting pass with the scene features of the forward variants
+// (fog, shadows, IBL, clustered lights) and their registered sources
+inline std::string deferredLightingSource(const ShaderPermutations& objectShaders, const char* src,
+                                          uint32_t sceneFeatures) {
+    uint32_t key = supportedVariantKey(objectShaders, shaderVariantKey(sceneFeatures, LIGHTING_PHONG));
+    return shaderVariantSource(src, key, variantExtraSource(objectShaders, key));
+}
+
+inline unsigned int createGBufferTexture(int unit, GLenum internalFormat, GLenum format, GLenum type,
+                                         int width, int height) {
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    bindTexture(unit, GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+    // Read with texelFetch only
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
+inline void createGBuffer(DeferredRenderer& d, int width, int height) {
+    d.width = width;
+    d.height = height;
+    d.albedoTex = createGBufferTexture(GBUFFER_ALBEDO_UNIT, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, width, height);
+    d.normalTex = createGBufferTexture(GBUFFER_NORMAL_UNIT, GL_RG16, GL_RG, GL_UNSIGNED_SHORT, width, height);
+    d.depthTex = createGBufferTexture(GBUFFER_DEPTH_UNIT, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_FLOAT,
+                                      width, height);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, d.fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, d.albedoTex, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, d.normalTex, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, d.depthTex, 0);
+    const GLenum buffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, buffers);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR::DEFERRED::GBUFFER_INCOMPLETE" << std::endl;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+inline void destroyGBuffer(DeferredRenderer& d) {
+    glDeleteTextures(1, &d.albedoTex);
+    glDeleteTextures(1, &d.normalTex);
+    glDeleteTextures(1, &d.depthTex);
+    d.albedoTex = d.normalTex = d.depthTex = 0;
+}
+
+// Take over a linked lighting program (shader hot reload swaps in rebuilt
+// ones); the previous one is deleted
+inline void setDeferredProgram(DeferredRenderer& d, unsigned int program) {
+    if (d.program != program)
+        glDeleteProgram(d.program);
+    d.program = program;
+    d.pipeline.program = program;
+}
+
+inline void initDeferredRenderer(DeferredRenderer& d, const char* vertexSrc, const char* lightingSrc,
+                                 int width, int height) {
+    setDeferredProgram(d, createShaderProgram(vertexSrc, lightingSrc));
+    glGenVertexArrays(1, &d.vao);
+    glGenFramebuffers(1, &d.fbo);
+    createGBuffer(d, width, height);
+    // Every pixel is written, including its depth
+    d.pipeline.vao = d.vao;
+    d.pipeline.depthFunc = GL_ALWAYS;
+}
+
+// Follow the framebuffer size; the old textures may still be bound
+inline void resizeDeferredRenderer(DeferredRenderer& d, int width, int height) {
+    if (width == d.width && height == d.height)
+        return;
+    destroyGBuffer(d);
+    invalidateGLState();
+    createGBuffer(d, width, height);
+}
+
+// Redirect the frame's geometry into the G-buffer
+inline void beginGeometryPass(DeferredRenderer& d) {
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &d.targetFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, d.fbo);
+    glViewport(0, 0, d.width, d.height);
+    // Color needs no clear: background pixels are told apart by depth
+    glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+// Shade into the framebuffer the geometry pass started from. The frame
+// uniforms (camera, sun, fog, IBL, shadows, clusters) are already set.
+inline void shadeDeferred(DeferredRenderer& d, const glm::mat4& view, const glm::mat4& projection,
+                          unsigned int skyboxTexture) {
+    glBindFramebuffer(GL_FRAMEBUFFER, d.targetFBO);
+    bindPipeline(d.pipeline);
+    bindTexture(0, GL_TEXTURE_CUBE_MAP, skyboxTexture);
+    bindTexture(GBUFFER_ALBEDO_UNIT, GL_TEXTURE_2D, d.albedoTex);
+    bindTexture(GBUFFER_NORMAL_UNIT, GL_TEXTURE_2D, d.normalTex);
+    bindTexture(GBUFFER_DEPTH_UNIT, GL_TEXTURE_2D, d.depthTex);
+    glUniform1i(glGetUniformLocation(d.program, "skybox"), 0);
+    glUniform1i(glGetUniformLocation(d.program, "gAlbedo"), GBUFFER_ALBEDO_UNIT);
+    glUniform1i(glGetUniformLocation(d.program, "gNormal"), GBUFFER_NORMAL_UNIT);
+    glUniform1i(glGetUniformLocation(d.program, "gDepth"), GBUFFER_DEPTH_UNIT);
+    glm::mat4 inverseViewProjection = glm::inverse(projection * view);
+    glUniformMatrix4fv(glGetUniformLocation(d.program, "inverseViewProjection"), 1, GL_FALSE,
+                       glm::value_ptr(inverseViewProjection));
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+inline void destroyDeferredRenderer(DeferredRenderer& d) {
+    destroyGBuffer(d);
+    glDeleteFramebuffers(1, &d.fbo);
+    glDeleteVertexArrays(1, &d.vao);
+    glDeleteProgram(d.program);
+}
+
+#endif
@@ -0,0 +1,601 @@
+#ifndef ENVIRONMENT_LIGHTING_H
+#define ENVIRONMENT_LIGHTING_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <sys/stat.h>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define ENV_LIGHTING_SSE 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define ENV_LIGHTING_NEON 1
+#endif
+
+// stb_image.h is included before this header, with its implementation, by main.cpp
+#include "pipeline_state.h"
+
+// --------------------- Image-Based Lighting ---------------------
+// Lighting from the skybox, precomputed once from its six faces:
+//   - diffuse: the irradiance as 9 spherical-harmonic coefficients (order 2).
+//     Every face texel is projected, weighted by its solid angle, four texels
+//     at a time (SSE / NEON, scalar fallback). The cosine-lobe convolution and
+//     the basis constants are folded into the coefficients, so the shader
+//     only evaluates a 9-term polynomial in the normal.
+//   - specular: a cube map whose mips hold the sky convolved with a GGX lobe
+//     of increasing roughness (0 at mip 0, 1 at the last). Each texel takes
+//     ENV_PREFILTER_SAMPLES importance samples, read from a box-filtered mip
+//     of the source picked by the sample's solid angle, so few samples are
+//     needed without aliasing.
+// Both phases run one thread per face, on a worker started during loading.
+// The result is cached next to the faces and rebuilt when their size or
+// modification time changes; a cache hit is a file read and an upload.
+//
+// Texels are used as stored, like every other texture in the renderer.
+
+const int ENV_PREFILTER_SIZE = 128;       // face size of mip 0
+const int ENV_PREFILTER_MIPS = 6;         // 128 .. 4
+const int ENV_PREFILTER_SAMPLES = 128;
+const int ENV_TEXTURE_UNIT = 2;
+const uint32_t ENV_CACHE_VERSION = 1;
+
+struct EnvironmentBake {
+    float sh[9][3] = {};                  // ready for the shader
+    std::vector<unsigned char> mips[ENV_PREFILTER_MIPS];   // 6 RGB8 faces per mip
+};
+
+struct EnvironmentJob {
+    std::thread worker;
+    std::vector<std::string> faces;       // +X, -X, +Y, -Y, +Z, -Z
+    std::string cachePath;
+    EnvironmentBake bake;
+    bool ok = false;
+    bool fromCache = false;
+    double ms = 0.0;
+};
+
+struct EnvironmentLighting {
+    float sh[9][3] = {};
+    unsigned int prefiltered = 0;
+};
+
+// One cube face as float planes, with its box-filtered mip chain
+struct EnvironmentFace {
+    struct Level {
+        int size = 0;
+        std::vector<float> r, g, b;
+    };
+    std::vector<Level> levels;
+};
+
+// --------------------- 4-wide helpers ---------------------
+#if ENV_LIGHTING_SSE
+typedef __m128 EnvLanes;
+inline EnvLanes lanesSet(float v) { return _mm_set1_ps(v); }
+inline EnvLanes lanesLoad(const float* p) { return _mm_loadu_ps(p); }
+inline EnvLanes lanesAdd(EnvLanes a, EnvLanes b) { return _mm_add_ps(a, b); }
+inline EnvLanes lanesSub(EnvLanes a, EnvLanes b) { return _mm_sub_ps(a, b); }
+inline EnvLanes lanesMul(EnvLanes a, EnvLanes b) { return _mm_mul_ps(a, b); }
+inline EnvLanes lanesRsqrt(EnvLanes a) { return _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(a)); }
+inline float lanesSum(EnvLanes a) {
+    float v[4];
+    _mm_storeu_ps(v, a);
+    return (v[0] + v[1]) + (v[2] + v[3]);
+}
+#elif ENV_LIGHTING_NEON
+typedef float32x4_t EnvLanes;
+inline EnvLanes lanesSet(float v) { return vdupq_n_f32(v); }
+inline EnvLanes lanesLoad(const float* p) { return vld1q_f32(p); }
+inline EnvLanes lanesAdd(EnvLanes a, EnvLanes b) { return vaddq_f32(a, b); }
+inline EnvLanes lanesSub(EnvLanes a, EnvLanes b) { return vsubq_f32(a, b); }
+inline EnvLanes lanesMul(EnvLanes a, EnvLanes b) { return vmulq_f32(a, b); }
+inline EnvLanes lanesRsqrt(EnvLanes a) { return vdivq_f32(vdupq_n_f32(1.0f), vsqrtq_f32(a)); }
+inline float lanesSum(EnvLanes a) { return vaddvq_f32(a); }
+#else
+struct EnvLanes { float v[4]; };
+inline EnvLanes lanesSet(float x) { return { { x, x, x, x } }; }
+inline EnvLanes lanesLoad(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+inline EnvLanes lanesAdd(EnvLanes a, EnvLanes b) { for (int k = 0; k < 4; ++k) a.v[k] += b.v[k]; return a; }
+inline EnvLanes lanesSub(EnvLanes a, EnvLanes b) { for (int k = 0; k < 4; ++k) a.v[k] -= b.v[k]; return a; }
+inline EnvLanes lanesMul(EnvLanes a, EnvLanes b) { for (int k = 0; k < 4; ++k) a.v[k] *= b.v[k]; return a; }
+inline EnvLanes lanesRsqrt(EnvLanes a) { for (int k = 0; k < 4; ++k) a.v[k] = 1.0f / std::sqrt(a.v[k]); return a; }
+inline float lanesSum(EnvLanes a) { return (a.v[0] + a.v[1]) + (a.v[2] + a.v[3]); }
+#endif
+
+// --------------------- Cube Face Geometry ---------------------
+// GL cube map layout: direction = major + s * sAxis + t * tAxis, with s and t
+// in [-1, 1] across the face (row 0 at t = -1)
+const float ENV_FACE_AXES[6][3][3] = {
+    { {  1, 0, 0 }, { 0, 0, -1 }, { 0, -1, 0 } },
+    { { -1, 0, 0 }, { 0, 0,  1 }, { 0, -1, 0 } },
+    { { 0,  1, 0 }, { 1, 0, 0 }, { 0, 0,  1 } },
+    { { 0, -1, 0 }, { 1, 0, 0 }, { 0, 0, -1 } },
+    { { 0, 0,  1 }, {  1, 0, 0 }, { 0, -1, 0 } },
+    { { 0, 0, -1 }, { -1, 0, 0 }, { 0, -1, 0 } },
+};
+
+inline glm::vec3 faceTexelDirection(int face, float s, float t) {
+    const float (*a)[3] = ENV_FACE_AXES[face];
+    return glm::normalize(glm::vec3(a[0][0] + s * a[1][0] + t * a[2][0],
+                                    a[0][1] + s * a[1][1] + t * a[2][1],
+                                    a[0][2] + s * a[1][2] + t * a[2][2]));
+}
+
+// Face and face coordinates in [-1, 1] of a direction
+inline int directionFace(const glm::vec3& d, float& s, float& t) {
+    glm::vec3 a = glm::abs(d);
+    if (a.x >= a.y && a.x >= a.z) {
+        s = (d.x > 0 ? -d.z : d.z) / a.x;
+        t = -d.y / a.x;
+        return d.x > 0 ? 0 : 1;
+    }
+    if (a.y >= a.z) {
+        s = d.x / a.y;
+        t = (d.y > 0 ? d.z : -d.z) / a.y;
+        return d.y > 0 ? 2 : 3;
+    }
+    s = (d.z > 0 ? d.x : -d.x) / a.z;
+    t = -d.y / a.z;
+    return d.z > 0 ? 4 : 5;
+}
+
+// --------------------- Source Faces ---------------------
+inline bool decodeEnvironmentFace(const std::string& path, EnvironmentFace& face) {
+    int width, height, channels;
+    unsigned char* data = stbi_load(path.c_str(), &width, &height, &channels, 3);
+    if (!data || width != height) {
+        std::cout << "ERROR::ENVIRONMENT::FACE_NOT_LOADED: " << path << std::endl;
+        stbi_image_free(data);
+        return false;
+    }
+    EnvironmentFace::Level base;
+    base.size = width;
+    size_t count = (size_t)width * height;
+    base.r.resize(count);
+    base.g.resize(count);
+    base.b.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        base.r[i] = data[i * 3 + 0] * (1.0f / 255.0f);
+        base.g[i] = data[i * 3 + 1] * (1.0f / 255.0f);
+        base.b[i] = data[i * 3 + 2] * (1.0f / 255.0f);
+    }
+    stbi_image_free(data);
+    face.levels.clear();
+    face.levels.push_back(std::move(base));
+    return true;
+}
+
+// 2x2 box filter down to 1x1
+inline void buildEnvironmentFaceMips(EnvironmentFace& face) {
+    while (face.levels.back().size > 1) {
+        const EnvironmentFace::Level& src = face.levels.back();
+        EnvironmentFace::Level dst;
+        dst.size = std::max(1, src.size / 2);
+        size_t count = (size_t)dst.size * dst.size;
+        dst.r.resize(count);
+        dst.g.resize(count);
+        dst.b.resize(count);
+        const std::vector<float>* srcPlanes[3] = { &src.r, &src.g, &src.b };
+        std::vector<float>* dstPlanes[3] = { &dst.r, &dst.g, &dst.b };
+        for (int c = 0; c < 3; ++c) {
+            const float* in = srcPlanes[c]->data();
+            float* out = dstPlanes[c]->data();
+            for (int y = 0; y < dst.size; ++y) {
+                const float* row0 = in + (size_t)(y * 2) * src.size;
+                const float* row1 = in + (size_t)std::min(y * 2 + 1, src.size - 1) * src.size;
+                for (int x = 0; x < dst.size; ++x) {
+                    int x1 = std::min(x * 2 + 1, src.size - 1);
+                    out[(size_t)y * dst.size + x] = 0.25f * (row0[x * 2] + row0[x1] + row1[x * 2] + row1[x1]);
+                }
+            }
+        }
+        face.levels.push_back(std::move(dst));
+    }
+}
+
+// --------------------- Spherical Harmonics ---------------------
+// Sums color * P_k(direction) * solidAngle over a face, where P_k are the
+// polynomial parts of the order-2 basis:
+//   1, y, z, x, xy, yz, 3z^2 - 1, xz, x^2 - y^2
+// A texel at (s, t) covers 4/size^2 * r^3 steradians, r = 1/sqrt(1+s^2+t^2),
+// and its direction is (major + s*sAxis + t*tAxis) * r.
+inline void projectFaceSH(const EnvironmentFace& face, int faceIndex, double sums[9][3]) {
+    const EnvironmentFace::Level& level = face.levels[0];
+    const int size = level.size;
+    const float (*a)[3] = ENV_FACE_AXES[faceIndex];
+    const float step = 2.0f / size;
+    const float texelArea = step * step;
+    const float laneOffsets[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+    const EnvLanes laneS = lanesMul(lanesLoad(laneOffsets), lanesSet(step));
+    const EnvLanes one = lanesSet(1.0f), three = lanesSet(3.0f);
+    const int simdEnd = size & ~3;
+
+    for (int y = 0; y < size; ++y) {
+        float t = (y + 0.5f) * step - 1.0f;
+        const float* planes[3] = { level.r.data() + (size_t)y * size, level.g.data() + (size_t)y * size,
+                                   level.b.data() + (size_t)y * size };
+        // Per row: the parts of the direction that don't depend on s
+        EnvLanes baseX = lanesSet(a[0][0] + t * a[2][0]);
+        EnvLanes baseY = lanesSet(a[0][1] + t * a[2][1]);
+        EnvLanes baseZ = lanesSet(a[0][2] + t * a[2][2]);
+        EnvLanes sAxisX = lanesSet(a[1][0]), sAxisY = lanesSet(a[1][1]), sAxisZ = lanesSet(a[1][2]);
+        EnvLanes tt1 = lanesSet(1.0f + t * t);
+        EnvLanes area = lanesSet(texelArea);
+
+        EnvLanes acc[9][3];
+        for (int k = 0; k < 9; ++k)
+            for (int c = 0; c < 3; ++c)
+                acc[k][c] = lanesSet(0.0f);
+
+        for (int x = 0; x < simdEnd; x += 4) {
+            EnvLanes s = lanesAdd(lanesSet((x + 0.5f) * step - 1.0f), laneS);
+            EnvLanes r = lanesRsqrt(lanesAdd(tt1, lanesMul(s, s)));
+            EnvLanes dx = lanesMul(lanesAdd(baseX, lanesMul(s, sAxisX)), r);
+            EnvLanes dy = lanesMul(lanesAdd(baseY, lanesMul(s, sAxisY)), r);
+            EnvLanes dz = lanesMul(lanesAdd(baseZ, lanesMul(s, sAxisZ)), r);
+            EnvLanes w = lanesMul(area, lanesMul(r, lanesMul(r, r)));
+            EnvLanes basis[9] = {
+                one, dy, dz, dx,
+                lanesMul(dx, dy), lanesMul(dy, dz), lanesSub(lanesMul(three, lanesMul(dz, dz)), one),
+                lanesMul(dx, dz), lanesSub(lanesMul(dx, dx), lanesMul(dy, dy)),
+            };
+            for (int c = 0; c < 3; ++c) {
+                EnvLanes wc = lanesMul(w, lanesLoad(planes[c] + x));
+                for (int k = 0; k < 9; ++k)
+                    acc[k][c] = lanesAdd(acc[k][c], lanesMul(basis[k], wc));
+            }
+        }
+        for (int k = 0; k < 9; ++k)
+            for (int c = 0; c < 3; ++c)
+                sums[k][c] += lanesSum(acc[k][c]);
+
+        for (int x = simdEnd; x < size; ++x) {
+            float s = (x + 0.5f) * step - 1.0f;
+            float r = 1.0f / std::sqrt(1.0f + s * s + t * t);
+            glm::vec3 d = faceTexelDirection(faceIndex, s, t);
+            float w = texelArea * r * r * r;
+            float basis[9] = { 1.0f, d.y, d.z, d.x, d.x * d.y, d.y * d.z, 3.0f * d.z * d.z - 1.0f,
+                               d.x * d.z, d.x * d.x - d.y * d.y };
+            for (int c = 0; c < 3; ++c)
+                for (int k = 0; k < 9; ++k)
+                    sums[k][c] += basis[k] * w * planes[c][x];
+        }
+    }
+}
+
+// Irradiance / pi = sum over k of A_l/pi * K_k^2 * sums_k * P_k(n), with the
+// basis constants K_k and the cosine-lobe factors A_0 = pi, A_1 = 2pi/3,
+// A_2 = pi/4
+inline void finishSHCoefficients(const double sums[9][3], float sh[9][3]) {
+    const double K[9] = { 0.282095, 0.488603, 0.488603, 0.488603, 1.092548, 1.092548, 0.315392, 1.092548, 0.546274 };
+    const double A[9] = { 1.0, 2.0 / 3.0, 2.0 / 3.0, 2.0 / 3.0, 0.25, 0.25, 0.25, 0.25, 0.25 };
+    for (int k = 0; k < 9; ++k)
+        for (int c = 0; c < 3; ++c)
+            sh[k][c] = (float)(A[k] * K[k] * K[k] * sums[k][c]);
+}
+
+// --------------------- Prefiltered Specular ---------------------
+struct EnvironmentSample {
+    glm::vec3 dir;        // around +Z
+    float weight;         // N.L
+    float mip;            // source mip for the sample's solid angle
+};
+
+inline float radicalInverse(uint32_t bits) {
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    return (float)bits * 2.3283064365386963e-10f;
+}
+
+// GGX samples with N = V = +Z. They don't depend on the texel, so each mip
+// builds its table once and rotates it per texel.
+inline std::vector<EnvironmentSample> environmentSamples(float roughness, int sourceSize) {
+    const float PI = 3.14159265359f;
+    float alpha = roughness * roughness;
+    float texelSolidAngle = 4.0f * PI / (6.0f * sourceSize * sourceSize);
+    std::vector<EnvironmentSample> samples;
+    for (int i = 0; i < ENV_PREFILTER_SAMPLES; ++i) {
+        float u = (float)i / ENV_PREFILTER_SAMPLES;
+        float v = radicalInverse((uint32_t)i);
+        float phi = 2.0f * PI * u;
+        float cosTheta = std::sqrt((1.0f - v) / (1.0f + (alpha * alpha - 1.0f) * v));
+        float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+        glm::vec3 h(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+        glm::vec3 l = 2.0f * cosTheta * h - glm::vec3(0.0f, 0.0f, 1.0f);
+        if (l.z <= 0.0f)
+            continue;
+        // pdf of l is D(h) / 4 when N = V
+        float d = alpha * alpha / (PI * std::pow(cosTheta * cosTheta * (alpha * alpha - 1.0f) + 1.0f, 2.0f));
+        float sampleSolidAngle = 1.0f / (ENV_PREFILTER_SAMPLES * d * 0.25f + 1e-6f);
+        float mip = std::max(0.0f, 0.5f * std::log2(sampleSolidAngle / texelSolidAngle) + 1.0f);
+        samples.push_back({ l, l.z, mip });
+    }
+    return samples;
+}
+
+inline glm::vec3 sampleFaceLevel(const EnvironmentFace::Level& level, float s, float t) {
+    float u = std::min(std::max((s + 1.0f) * 0.5f * level.size - 0.5f, 0.0f), (float)(level.size - 1));
+    float v = std::min(std::max((t + 1.0f) * 0.5f * level.size - 0.5f, 0.0f), (float)(level.size - 1));
+    int x0 = (int)u, y0 = (int)v;
+    int x1 = std::min(x0 + 1, level.size - 1), y1 = std::min(y0 + 1, level.size - 1);
+    float fx = u - x0, fy = v - y0;
+    size_t i00 = (size_t)y0 * level.size + x0, i01 = (size_t)y0 * level.size + x1;
+    size_t i10 = (size_t)y1 * level.size + x0, i11 = (size_t)y1 * level.size + x1;
+    auto lerp2 = [&](const std::vector<float>& p) {
+        float top = p[i00] + (p[i01] - p[i00]) * fx;
+        float bottom = p[i10] + (p[i11] - p[i10]) * fx;
+        return top + (bottom - top) * fy;
+    };
+    return glm::vec3(lerp2(level.r), lerp2(level.g), lerp2(level.b));
+}
+
+// Trilinear lookup in the source faces
+inline glm::vec3 sampleEnvironment(const EnvironmentFace* faces, const glm::vec3& dir, float mip) {
+    float s, t;
+    const EnvironmentFace& face = faces[directionFace(dir, s, t)];
+    mip = std::min(std::max(mip, 0.0f), (float)(face.levels.size() - 1));
+    int m0 = (int)mip;
+    int m1 = std::min(m0 + 1, (int)face.levels.size() - 1);
+    glm::vec3 a = sampleFaceLevel(face.levels[m0], s, t);
+    if (m1 == m0)
+        return a;
+    return a + (sampleFaceLevel(face.levels[m1], s, t) - a) * (mip - m0);
+}
+
+inline void prefilterFace(const EnvironmentFace* faces, int faceIndex, int mip,
+                          const std::vector<EnvironmentSample>& samples, unsigned char* out) {
+    int size = ENV_PREFILTER_SIZE >> mip;
+    // Source level as dense as this mip; sources smaller than it are magnified from level 0
+    float baseMip = std::max(0.0f, std::log2((float)faces[0].levels[0].size / size));
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            glm::vec3 n = faceTexelDirection(faceIndex, (x + 0.5f) * 2.0f / size - 1.0f, (y + 0.5f) * 2.0f / size - 1.0f);
+            glm::vec3 color(0.0f);
+            if (mip == 0) {
+                color = sampleEnvironment(faces, n, baseMip);
+            } else {
+                glm::vec3 up = std::abs(n.z) < 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+                glm::vec3 tangent = glm::normalize(glm::cross(up, n));
+                glm::vec3 bitangent = glm::cross(n, tangent);
+                float total = 0.0f;
+                for (const EnvironmentSample& smp : samples) {
+                    glm::vec3 l = tangent * smp.dir.x + bitangent * smp.dir.y + n * smp.dir.z;
+                    color += sampleEnvironment(faces, l, std::max(smp.mip, baseMip)) * smp.weight;
+                    total += smp.weight;
+                }
+                color /= std::max(total, 1e-6f);
+            }
+            unsigned char* texel = out + ((size_t)y * size + x) * 3;
+            for (int c = 0; c < 3; ++c)
+                texel[c] = (unsigned char)std::min(255.0f, color[c] * 255.0f + 0.5f);
+        }
+    }
+}
+
+// --------------------- Bake ---------------------
+// Phase 1 (per face): decode, project onto SH, build the box mips.
+// Phase 2 (per face): prefilter; its samples may fall on any face.
+inline bool bakeEnvironment(const std::vector<std::string>& paths, EnvironmentBake& bake) {
+    EnvironmentFace faces[6];
+    double sums[6][9][3] = {};
+    bool decoded[6] = {};
+    std::vector<std::thread> threads;
+    for (int f = 0; f < 6; ++f)
+        threads.emplace_back([&, f]() {
+            decoded[f] = decodeEnvironmentFace(paths[f], faces[f]);
+            if (!decoded[f])
+                return;
+            projectFaceSH(faces[f], f, sums[f]);
+            buildEnvironmentFaceMips(faces[f]);
+        });
+    for (std::thread& t : threads)
+        t.join();
+    threads.clear();
+    for (int f = 0; f < 6; ++f) {
+        if (!decoded[f])
+            return false;
+        if (faces[f].levels[0].size != faces[0].levels[0].size) {
+            std::cout << "ERROR::ENVIRONMENT::FACE_SIZE_MISMATCH: " << paths[f] << std::endl;
+            return false;
+        }
+    }
+
+    double total[9][3] = {};
+    for (int f = 0; f < 6; ++f)
+        for (int k = 0; k < 9; ++k)
+            for (int c = 0; c < 3; ++c)
+                total[k][c] += sums[f][k][c];
+    finishSHCoefficients(total, bake.sh);
+
+    std::vector<EnvironmentSample> samples[ENV_PREFILTER_MIPS];
+    for (int m = 0; m < ENV_PREFILTER_MIPS; ++m) {
+        int size = ENV_PREFILTER_SIZE >> m;
+        bake.mips[m].assign((size_t)size * size * 3 * 6, 0);
+        if (m > 0)
+            samples[m] = environmentSamples((float)m / (ENV_PREFILTER_MIPS - 1), faces[0].levels[0].size);
+    }
+    for (int f = 0; f < 6; ++f)
+        threads.emplace_back([&, f]() {
+            for (int m = 0; m < ENV_PREFILTER_MIPS; ++m) {
+                size_t faceBytes = (size_t)(ENV_PREFILTER_SIZE >> m) * (ENV_PREFILTER_SIZE >> m) * 3;
+                prefilterFace(faces, f, m, samples[m], bake.mips[m].data() + faceBytes * f);
+            }
+        });
+    for (std::thread& t : threads)
+        t.join();
+    return true;
+}
+
+// --------------------- Cache File ---------------------
+// Header, then each mip's six RGB8 faces. Rebuilt when a face's size or
+// modification time changes.
+struct EnvironmentCacheHeader {
+    char magic[4];             // "IBLC"
+    uint32_t version;
+    uint32_t faceSize;         // ENV_PREFILTER_SIZE
+    uint32_t mipCount;         // ENV_PREFILTER_MIPS
+    uint32_t sampleCount;      // ENV_PREFILTER_SAMPLES
+    uint32_t reserved;
+    uint64_t sourceSize[6];
+    int64_t  sourceTime[6];
+    float sh[9][3];
+};
+
+inline bool environmentSourceStamps(const std::vector<std::string>& paths, EnvironmentCacheHeader& h) {
+    for (int f = 0; f < 6; ++f) {
+        struct stat st;
+        if (stat(paths[f].c_str(), &st) != 0)
+            return false;
+        h.sourceSize[f] = (uint64_t)st.st_size;
+        h.sourceTime[f] = (int64_t)st.st_mtime;
+    }
+    return true;
+}
+
+inline void initEnvironmentCacheHeader(EnvironmentCacheHeader& h) {
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, "IBLC", 4);
+    h.version = ENV_CACHE_VERSION;
+    h.faceSize = ENV_PREFILTER_SIZE;
+    h.mipCount = ENV_PREFILTER_MIPS;
+    h.sampleCount = ENV_PREFILTER_SAMPLES;
+}
+
+inline bool readEnvironmentCache(const std::string& path, const std::vector<std::string>& faces, EnvironmentBake& bake) {
+    EnvironmentCacheHeader expected, h;
+    initEnvironmentCacheHeader(expected);
+    if (!environmentSourceStamps(faces, expected))
+        return false;
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f)
+        return false;
+    bool ok = std::fread(&h, sizeof(h), 1, f) == 1 &&
+              std::memcmp(&h, &expected, offsetof(EnvironmentCacheHeader, sh)) == 0;
+    for (int m = 0; ok && m < ENV_PREFILTER_MIPS; ++m) {
+        size_t bytes = (size_t)(ENV_PREFILTER_SIZE >> m) * (ENV_PREFILTER_SIZE >> m) * 3 * 6;
+        bake.mips[m].resize(bytes);
+        ok = std::fread(bake.mips[m].data(), 1, bytes, f) == bytes;
+    }
+    ok = ok && std::fgetc(f) == EOF;
+    std::fclose(f);
+    if (ok)
+        std::memcpy(bake.sh, h.sh, sizeof(bake.sh));
+    return ok;
+}
+
+inline bool writeEnvironmentCache(const std::string& path, const std::vector<std::string>& faces,
+                                  const EnvironmentBake& bake) {
+    EnvironmentCacheHeader h;
+    initEnvironmentCacheHeader(h);
+    if (!environmentSourceStamps(faces, h))
+        return false;
+    std::memcpy(h.sh, bake.sh, sizeof(h.sh));
+
+    // Write to a temporary name and rename, so a crash never leaves a torn cache
+    std::string temp = path + ".tmp";
+    FILE* f = std::fopen(temp.c_str(), "wb");
+    if (!f) {
+        std::cout << "ERROR::ENVIRONMENT::CACHE_WRITE_FAILED: " << path << std::endl;
+        return false;
+    }
+    bool ok = std::fwrite(&h, sizeof(h), 1, f) == 1;
+    for (int m = 0; ok && m < ENV_PREFILTER_MIPS; ++m)
+        ok = std::fwrite(bake.mips[m].data(), 1, bake.mips[m].size(), f) == bake.mips[m].size();
+    ok = std::fclose(f) == 0 && ok;
+#ifdef _WIN32
+    // rename() replaces the old cache atomically elsewhere, but not on Windows
+    if (ok)
+        std::remove(path.c_str());
+#endif
+    if (!ok || std::rename(temp.c_str(), path.c_str()) != 0) {
+        std::remove(temp.c_str());
+        std::cout << "ERROR::ENVIRONMENT::CACHE_WRITE_FAILED: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// --------------------- Loading ---------------------
+inline void environmentJobMain(EnvironmentJob* job) {
+    using Clock = std::chrono::high_resolution_clock;
+    auto start = Clock::now();
+    job->fromCache = readEnvironmentCache(job->cachePath, job->faces, job->bake);
+    job->ok = job->fromCache || bakeEnvironment(job->faces, job->bake);
+    if (job->ok && !job->fromCache)
+        writeEnvironmentCache(job->cachePath, job->faces, job->bake);
+    job->ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Start loading or baking on a worker; finishEnvironmentLighting() collects it
+inline void startEnvironmentLighting(EnvironmentJob& job, const std::vector<std::string>& faces) {
+    job.faces = faces;
+    size_t slash = faces[0].find_last_of("/\\");
+    job.cachePath = (slash == std::string::npos ? std::string(".") : faces[0].substr(0, slash)) + "/environment.ibl";
+    job.worker = std::thread(environmentJobMain, &job);
+}
+
+// Wait for the job and upload the prefiltered cube map. Without a result the
+// ambient falls back to a flat 0.6 (0.3 after the shader's IBL_DIFFUSE_STRENGTH,
+// as without IBL) and there are no reflections.
+inline bool finishEnvironmentLighting(EnvironmentJob& job, EnvironmentLighting& env) {
+    job.worker.join();
+    if (!job.ok) {
+        std::cout << "ERROR::ENVIRONMENT::BAKE_FAILED: using a flat ambient" << std::endl;
+        env.sh[0][0] = env.sh[0][1] = env.sh[0][2] = 0.6f;
+        return false;
+    }
+    std::memcpy(env.sh, job.bake.sh, sizeof(env.sh));
+    glGenTextures(1, &env.prefiltered);
+    bindTexture(ENV_TEXTURE_UNIT, GL_TEXTURE_CUBE_MAP, env.prefiltered);
+    for (int m = 0; m < ENV_PREFILTER_MIPS; ++m) {
+        int size = ENV_PREFILTER_SIZE >> m;
+        size_t faceBytes = (size_t)size * size * 3;
+        for (int f = 0; f < 6; ++f)
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + f, m, GL_RGB8, size, size, 0, GL_RGB, GL_UNSIGNED_BYTE,
+                         job.bake.mips[m].data() + faceBytes * f);
+    }
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, ENV_PREFILTER_MIPS - 1);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    // Blurry mips show face edges unless filtering crosses them
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+    job.bake = EnvironmentBake();
+    std::cout << "Environment lighting: " << (job.fromCache ? "loaded from " : "baked and cached to ")
+              << job.cachePath << " in " << (int)job.ms << " ms" << std::endl;
+    return true;
+}
+
+// For programs built with IBL; the program must be current
+inline void setEnvironmentUniforms(unsigned int program, const EnvironmentLighting& env) {
+    bindTexture(ENV_TEXTURE_UNIT, GL_TEXTURE_CUBE_MAP, env.prefiltered);
+    glUniform3fv(glGetUniformLocation(program, "shIrradiance"), 9, &env.sh[0][0]);
+    glUniform1i(glGetUniformLocation(program, "prefilteredEnv"), ENV_TEXTURE_UNIT);
+    glUniform1f(glGetUniformLocation(program, "prefilteredMaxLod"), (float)(ENV_PREFILTER_MIPS - 1));
+}
+
+inline void destroyEnvironmentLighting(EnvironmentLighting& env) {
+    glDeleteTextures(1, &env.prefiltered);
+    env.prefiltered = 0;
+}
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+// --------------------- View Frustum ---------------------
+// Six planes (ax + by + cz + d >= 0 inside) extracted from a view-projection
+// matrix (Gribb & Hartmann). Planes are normalised so sphere tests can use
+// the signed distance directly.
+
+struct Frustum {
+    glm::vec4 planes[6];   // left, right, bottom, top, near, far
+};
+
+inline Frustum extractFrustum(const glm::mat4& viewProjection) {
+    const glm::mat4& m = viewProjection;
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    Frustum f;
+    f.planes[0] = row3 + row0;
+    f.planes[1] = row3 - row0;
+    f.planes[2] = row3 + row1;
+    f.planes[3] = row3 - row1;
+    f.planes[4] = row3 + row2;
+    f.planes[5] = row3 - row2;
+    for (glm::vec4& p : f.planes)
+        p = p / glm::length(glm::vec3(p));
+    return f;
+}
+
+// Conservative: may accept boxes that are just outside near a frustum corner
+inline bool aabbInFrustum(const Frustum& f, const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    for (const glm::vec4& p : f.planes) {
+        // Corner farthest along the plane normal
+        glm::vec3 v(p.x >= 0.0f ? boxMax.x : boxMin.x,
+                    p.y >= 0.0f ? boxMax.y : boxMin.y,
+                    p.z >= 0.0f ? boxMax.z : boxMin.z);
+        if (p.x * v.x + p.y * v.y + p.z * v.z + p.w < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+inline bool sphereInFrustum(const Frustum& f, const glm::vec3& center, float radius) {
+    for (const glm::vec4& p : f.planes)
+        if (p.x * center.x + p.y * center.y + p.z * center.z + p.w < -radius)
+            return false;
+    return true;
+}
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef GL_EXT_H
+#define GL_EXT_H
+
+#include <glad/glad.h>
+
+#include <cstring>
+
+// --------------------- Post-3.3 GL Entry Points ---------------------
+// glad was generated for the 3.3 core profile only. Newer entry points are
+// declared here the same way glad does it (glad_glX pointer + glX macro) and
+// are only called after checking the context version or extension string.
+
+#ifndef GL_VERSION_4_0
+#define GL_PATCHES                        0x000E
+#define GL_PATCH_VERTICES                 0x8E72
+#define GL_TESS_EVALUATION_SHADER         0x8E87
+#define GL_TESS_CONTROL_SHADER            0x8E88
+typedef void (APIENTRYP PFNGLPATCHPARAMETERIPROC)(GLenum pname, GLint value);
+PFNGLPATCHPARAMETERIPROC glad_glPatchParameteri = nullptr;
+#define glPatchParameteri glad_glPatchParameteri
+#endif
+
+#ifndef GL_VERSION_4_1
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH          0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS     0x87FE
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+PFNGLGETPROGRAMBINARYPROC glad_glGetProgramBinary = nullptr;
+PFNGLPROGRAMBINARYPROC glad_glProgramBinary = nullptr;
+PFNGLPROGRAMPARAMETERIPROC glad_glProgramParameteri = nullptr;
+#define glGetProgramBinary glad_glGetProgramBinary
+#define glProgramBinary glad_glProgramBinary
+#define glProgramParameteri glad_glProgramParameteri
+#endif
+
+#ifndef GL_VERSION_4_3
+#define GL_DRAW_INDIRECT_BUFFER           0x8F3F
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC glad_glMultiDrawElementsIndirect = nullptr;
+#define glMultiDrawElementsIndirect glad_glMultiDrawElementsIndirect
+#endif
+
+#ifndef GL_KHR_parallel_shader_compile
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR          0x91B1
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glad_glMaxShaderCompilerThreadsKHR = nullptr;
+#define glMaxShaderCompilerThreadsKHR glad_glMaxShaderCompilerThreadsKHR
+#endif
+
+// Capabilities of the current context, filled by loadGLExtensions()
+struct GLCapabilities {
+    int  major = 0;
+    int  minor = 0;
+    bool tessellation = false;   // GL 4.0 (the stages are GLSL 4.00)
+    bool multiDrawIndirect = false; // GL 4.3 / ARB_multi_draw_indirect + ARB_base_instance
+    bool programBinary = false;  // GL 4.1 / ARB_get_program_binary with at least one binary format
+    bool parallelShaderCompile = false; // KHR/ARB_parallel_shader_compile
+};
+
+GLCapabilities glCaps;
+
+inline bool hasGLExtension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        const char* ext = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+        if (ext && std::strcmp(ext, name) == 0)
+            return true;
+    }
+    return false;
+}
+
+inline bool glVersionAtLeast(int major, int minor) {
+    return glCaps.major > major || (glCaps.major == major && glCaps.minor >= minor);
+}
+
+// Call once after gladLoadGLLoader with the same loader
+inline void loadGLExtensions(GLADloadproc load) {
+    glGetIntegerv(GL_MAJOR_VERSION, &glCaps.major);
+    glGetIntegerv(GL_MINOR_VERSION, &glCaps.minor);
+
+    glad_glPatchParameteri = (PFNGLPATCHPARAMETERIPROC)load("glPatchParameteri");
+    // ARB_tessellation_shader alone isn't enough: the stages are written as
+    // #version 400, which a 3.3 context rejects
+    glCaps.tessellation = glVersionAtLeast(4, 0) && glad_glPatchParameteri != nullptr;
+
+    // baseInstance in the indirect command carries the draw id, so base_instance is required too
+    glad_glMultiDrawElementsIndirect = (PFNGLMULTIDRAWELEMENTSINDIRECTPROC)load("glMultiDrawElementsIndirect");
+    glCaps.multiDrawIndirect = (glVersionAtLeast(4, 3) ||
+                                (hasGLExtension("GL_ARB_multi_draw_indirect") && hasGLExtension("GL_ARB_base_instance")))
+                               && glad_glMultiDrawElementsIndirect != nullptr;
+
+    // Some drivers (macOS) expose the entry points but no binary formats
+    glad_glGetProgramBinary = (PFNGLGETPROGRAMBINARYPROC)load("glGetProgramBinary");
+    glad_glProgramBinary = (PFNGLPROGRAMBINARYPROC)load("glProgramBinary");
+    glad_glProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC)load("glProgramParameteri");
+    if ((glVersionAtLeast(4, 1) || hasGLExtension("GL_ARB_get_program_binary")) &&
+        glad_glGetProgramBinary && glad_glProgramBinary && glad_glProgramParameteri) {
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        glCaps.programBinary = formats > 0;
+    }
+
+    // The ARB extension is the same API with an ARB-suffixed entry point
+    if (hasGLExtension("GL_KHR_parallel_shader_compile"))
+        glad_glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load("glMaxShaderCompilerThreadsKHR");
+    else if (hasGLExtension("GL_ARB_parallel_shader_compile"))
+        glad_glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load("glMaxShaderCompilerThreadsARB");
+    glCaps.parallelShaderCompile = glad_glMaxShaderCompilerThreadsKHR != nullptr;
+}
+
+#endif
@@ -0,0 +1,232 @@
+#ifndef GROUND_STREAMING_H
+#define GROUND_STREAMING_H
+
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <cmath>
+
+#include "mesh_buffer.h"
+#include "mesh_optimizer.h"
+#include "procedural_mesh.h"
+
+// --------------------- Streamed Ground Tiles ---------------------
+// The ground is split into square tiles around the camera. Tile meshes are
+// built on a background thread (generation + vertex cache optimisation) and
+// handed back to the render thread, which uploads them into the shared mesh
+// buffer; all GL calls stay on the render thread. Tiles outside the load
+// radius are released again, and the number of resident tiles is capped by a
+// fixed byte budget, so vertex memory stays bounded however far the camera
+// travels. Tiles are positioned by their model matrix, so vertex data stays
+// small-valued (and precise) far from the origin.
+
+const float GROUND_TILE_SIZE      = 16.0f;   // world units per tile side
+const int   GROUND_TILE_DIVISIONS = 16;      // quads per tile side
+const int   GROUND_LOAD_RADIUS    = 5;       // tiles around the camera tile
+const size_t GROUND_BUDGET_BYTES  = 2 * 1024 * 1024;
+
+struct GroundTile {
+    glm::ivec2 coord;
+    MeshHandle mesh;
+};
+
+struct GroundTileData {
+    glm::ivec2 coord;
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+};
+
+struct GroundStreamer {
+    // Shared with the worker, guarded by mutex
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<glm::ivec2> requests;      // nearest last, popped from the back
+    std::vector<glm::ivec2> building;      // taken by the worker, not yet finished
+    std::vector<GroundTileData> finished;
+    bool quit = false;
+
+    // Render thread only
+    std::thread worker;
+    std::vector<GroundTile> resident;
+    size_t tileBytes = 0;
+    size_t residentBytes = 0;
+    size_t budgetBytes = GROUND_BUDGET_BYTES;
+    int maxTiles = 0;
+    long long tilesLoaded = 0;
+    long long tilesEvicted = 0;
+};
+
+inline glm::ivec2 groundTileAt(const glm::vec3& position) {
+    return glm::ivec2((int)std::floor(position.x / GROUND_TILE_SIZE), (int)std::floor(position.z / GROUND_TILE_SIZE));
+}
+
+inline glm::vec3 groundTileCenter(const glm::ivec2& coord) {
+    return glm::vec3((coord.x + 0.5f) * GROUND_TILE_SIZE, 0.0f, (coord.y + 0.5f) * GROUND_TILE_SIZE);
+}
+
+// Chebyshev distance in tiles
+inline int groundTileDistance(const glm::ivec2& a, const glm::ivec2& b) {
+    return std::max(std::abs(a.x - b.x), std::abs(a.y - b.y));
+}
+
+// Runs on the worker thread. UVs repeat every 2 units like the original
+// ground quad; a tile spans a whole number of repeats, so the texture lines
+// up across tile borders without world-space UVs.
+inline void buildGroundTile(GroundTileData& tile) {
+    generatePlane(tile.vertices, tile.indices, GROUND_TILE_SIZE, GROUND_TILE_SIZE,
+                  GROUND_TILE_DIVISIONS, GROUND_TILE_DIVISIONS);
+    for (size_t v = 0; v < tile.vertices.size(); v += MESH_VERTEX_FLOATS) {
+        tile.vertices[v + 6] *= GROUND_TILE_SIZE * 0.5f;
+        tile.vertices[v + 7] *= GROUND_TILE_SIZE * 0.5f;
+    }
+    optimizeVertexCache(tile.indices, (unsigned int)(tile.vertices.size() / MESH_VERTEX_FLOATS));
+    optimizeVertexFetch(tile.vertices, tile.indices);
+}
+
+inline void groundWorkerLoop(GroundStreamer* gs) {
+    std::unique_lock<std::mutex> lock(gs->mutex);
+    while (true) {
+        gs->wake.wait(lock, [gs] { return gs->quit || !gs->requests.empty(); });
+        if (gs->quit)
+            return;
+        GroundTileData tile;
+        tile.coord = gs->requests.back();
+        gs->requests.pop_back();
+        gs->building.push_back(tile.coord);
+
+        lock.unlock();
+        buildGroundTile(tile);
+        lock.lock();
+
+        gs->building.erase(std::find(gs->building.begin(), gs->building.end(), tile.coord));
+        gs->finished.push_back(std::move(tile));
+    }
+}
+
+inline void initGroundStreamer(GroundStreamer& gs, const MeshBuffer& mb) {
+    unsigned int side = GROUND_TILE_DIVISIONS + 1;
+    gs.tileBytes = (size_t)side * side * meshVertexStride(mb) +
+                   (size_t)GROUND_TILE_DIVISIONS * GROUND_TILE_DIVISIONS * 6 * sizeof(unsigned int);
+    gs.maxTiles = (int)(gs.budgetBytes / gs.tileBytes);
+    int wanted = (2 * GROUND_LOAD_RADIUS + 1) * (2 * GROUND_LOAD_RADIUS + 1);
+    if (gs.maxTiles < wanted)
+        std::cout << "Ground streaming: budget holds " << gs.maxTiles << " of " << wanted
+                  << " tiles in the load radius, the farthest stay unloaded" << std::endl;
+    gs.worker = std::thread(groundWorkerLoop, &gs);
+}
+
+inline bool containsTile(const std::vector<glm::ivec2>& tiles, const glm::ivec2& coord) {
+    return std::find(tiles.begin(), tiles.end(), coord) != tiles.end();
+}
+
+// Call once per frame on the render thread: upload finished tiles, drop far
+// ones and queue the missing ones nearest first.
+inline void updateGroundStreamer(GroundStreamer& gs, MeshBuffer& mb, const glm::vec3& cameraPos) {
+    glm::ivec2 center = groundTileAt(cameraPos);
+
+    // Tiles to keep: everything in the radius, nearest first, up to the budget
+    std::vector<glm::ivec2> wanted;
+    for (int z = -GROUND_LOAD_RADIUS; z <= GROUND_LOAD_RADIUS; ++z)
+        for (int x = -GROUND_LOAD_RADIUS; x <= GROUND_LOAD_RADIUS; ++x)
+            wanted.push_back(center + glm::ivec2(x, z));
+    auto distance2 = [&](const glm::ivec2& coord) {
+        glm::ivec2 d = coord - center;
+        return d.x * d.x + d.y * d.y;
+    };
+    std::stable_sort(wanted.begin(), wanted.end(), [&](const glm::ivec2& a, const glm::ivec2& b) {
+        return distance2(a) < distance2(b);
+    });
+    if ((int)wanted.size() > gs.maxTiles)
+        wanted.resize(gs.maxTiles);
+
+    // Tiles are kept one ring past the load radius, so moving back and forth
+    // across a tile border doesn't reload a whole row each time
+    auto evict = [&](size_t i) {
+        releaseMesh(mb, gs.resident[i].mesh);
+        gs.residentBytes -= gs.tileBytes;
+        gs.tilesEvicted++;
+        gs.resident[i] = gs.resident.back();
+        gs.resident.pop_back();
+    };
+    for (size_t i = 0; i < gs.resident.size();) {
+        if (groundTileDistance(gs.resident[i].coord, center) > GROUND_LOAD_RADIUS + 1)
+            evict(i);
+        else
+            ++i;
+    }
+
+    std::vector<GroundTileData> finished;
+    std::vector<glm::ivec2> building;
+    {
+        std::lock_guard<std::mutex> lock(gs.mutex);
+        finished.swap(gs.finished);
+        building = gs.building;
+    }
+
+    auto isResident = [&](const glm::ivec2& coord) {
+        for (const GroundTile& t : gs.resident)
+            if (t.coord == coord)
+                return true;
+        return false;
+    };
+    for (GroundTileData& data : finished) {
+        // The camera may have moved on while it was being built
+        if (!containsTile(wanted, data.coord) || isResident(data.coord))
+            continue;
+        // Over budget: make room by dropping the farthest resident tile, if it is farther
+        if (gs.residentBytes + gs.tileBytes > gs.budgetBytes) {
+            size_t farthest = 0;
+            for (size_t i = 1; i < gs.resident.size(); ++i)
+                if (distance2(gs.resident[i].coord) > distance2(gs.resident[farthest].coord))
+                    farthest = i;
+            if (gs.resident.empty() || distance2(gs.resident[farthest].coord) <= distance2(data.coord))
+                continue;
+            evict(farthest);
+        }
+        GroundTile tile;
+        tile.coord = data.coord;
+        tile.mesh = uploadMesh(mb, data.vertices.data(), (unsigned int)(data.vertices.size() / MESH_VERTEX_FLOATS),
+                               data.indices.data(), (unsigned int)data.indices.size());
+        gs.resident.push_back(tile);
+        gs.residentBytes += gs.tileBytes;
+        gs.tilesLoaded++;
+    }
+
+    // Replace the request list; stale requests from earlier frames are dropped
+    std::vector<glm::ivec2> requests;
+    for (auto it = wanted.rbegin(); it != wanted.rend(); ++it)
+        if (!isResident(*it) && !containsTile(building, *it))
+            requests.push_back(*it);
+    {
+        std::lock_guard<std::mutex> lock(gs.mutex);
+        gs.requests.swap(requests);
+    }
+    gs.wake.notify_one();
+}
+
+inline void printGroundStreamerStats(const GroundStreamer& gs) {
+    std::cout << "Ground streaming: " << gs.resident.size() << " tiles resident, "
+              << gs.residentBytes / 1024 << " / " << gs.budgetBytes / 1024 << " KB, "
+              << gs.tilesLoaded << " loaded, " << gs.tilesEvicted << " evicted" << std::endl;
+}
+
+inline void destroyGroundStreamer(GroundStreamer& gs, MeshBuffer& mb) {
+    {
+        std::lock_guard<std::mutex> lock(gs.mutex);
+        gs.quit = true;
+    }
+    gs.wake.notify_one();
+    if (gs.worker.joinable())
+        gs.worker.join();
+    for (const GroundTile& t : gs.resident)
+        releaseMesh(mb, t.mesh);
+    gs.resident.clear();
+    gs.residentBytes = 0;
+}
+
+#endif
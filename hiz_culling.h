@@ -0,0 +1,420 @@
+#ifndef HIZ_CULLING_H
+#define HIZ_CULLING_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "pipeline_state.h"
+
+// Defined in main.cpp
+unsigned int createShaderProgram(const char* vertSrc, const char* fragSrc);
+
+// --------------------- Hierarchical-Z Occlusion Culling ---------------------
+// The frame is rendered into an offscreen target so its depth can be sampled.
+// At the end of the frame the depth is reduced into a max-depth mip pyramid with
+// fragment passes (no compute shaders in GL 3.3), then every object's screen
+// rectangle is tested against it in a point-draw pass that writes one visibility
+// texel per object. The result is read back through a PBO ring and used by the
+// draw submission of a later frame, so the CPU never waits on the GPU.
+
+// World-space bounding box of a cullable object
+struct HiZBounds {
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+const int HIZ_READBACK_FRAMES = 2;   // PBO ring size (frames of latency)
+const int HIZ_VIS_WIDTH       = 1024; // Objects per row in the visibility target
+
+struct HiZCuller {
+    int width  = 0;
+    int height = 0;
+    int levels = 0;
+
+    // Offscreen scene target
+    unsigned int sceneFBO = 0;
+    unsigned int sceneColorRBO = 0;
+    unsigned int sceneDepthTex = 0;
+
+    // Max-depth pyramid
+    unsigned int hizFBO = 0;
+    unsigned int hizTex = 0;
+
+    // Per-object visibility target and readback ring
+    unsigned int visFBO = 0;
+    unsigned int visTex = 0;
+    int visCapacity = 0;
+    unsigned int pbo[HIZ_READBACK_FRAMES] = {0};
+    int pboCount[HIZ_READBACK_FRAMES] = {0};
+    int frameIndex = 0;
+
+    // Test input: one point per object (uv rect + nearest depth)
+    unsigned int testVAO = 0, testVBO = 0;
+    unsigned int emptyVAO = 0;
+
+    unsigned int copyProgram = 0;
+    unsigned int downsampleProgram = 0;
+    unsigned int testProgram = 0;
+    PipelineState copyPipeline, downsamplePipeline, testPipeline;   // no depth test
+
+    // Latest visibility result, indexed by object id (1 = visible)
+    std::vector<unsigned char> visibility;
+    int culledCount = 0;
+};
+
+// --------------------- Hi-Z Shader Sources ---------------------
+// Fullscreen triangle generated from gl_VertexID
+const char* hizFullscreenVertexShaderSrc = R"(
+#version 330 core
+void main() {
+    vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+// Copies the scene depth into level 0 of the pyramid
+const char* hizCopyFragmentShaderSrc = R"(
+#version 330 core
+out float FragDepth;
+uniform sampler2D depthMap;
+void main() {
+    FragDepth = texelFetch(depthMap, ivec2(gl_FragCoord.xy), 0).r;
+}
+)";
+
+// Max-reduces the previous level. The source level is exposed as level 0 by
+// restricting BASE/MAX_LEVEL, so reading and writing never touch the same level.
+const char* hizDownsampleFragmentShaderSrc = R"(
+#version 330 core
+out float FragDepth;
+uniform sampler2D prevLevel;
+void main() {
+    ivec2 prevSize = textureSize(prevLevel, 0);
+    ivec2 src = ivec2(gl_FragCoord.xy) * 2;
+    float d = max(max(texelFetch(prevLevel, src, 0).r,
+                      texelFetch(prevLevel, src + ivec2(1, 0), 0).r),
+                  max(texelFetch(prevLevel, src + ivec2(0, 1), 0).r,
+                      texelFetch(prevLevel, src + ivec2(1, 1), 0).r));
+    // Odd-sized levels: the last row/column also covers the extra texel
+    bool extraX = ((prevSize.x & 1) != 0) && (src.x + 2 == prevSize.x - 1);
+    bool extraY = ((prevSize.y & 1) != 0) && (src.y + 2 == prevSize.y - 1);
+    if (extraX) {
+        d = max(d, texelFetch(prevLevel, src + ivec2(2, 0), 0).r);
+        d = max(d, texelFetch(prevLevel, src + ivec2(2, 1), 0).r);
+    }
+    if (extraY) {
+        d = max(d, texelFetch(prevLevel, src + ivec2(0, 2), 0).r);
+        d = max(d, texelFetch(prevLevel, src + ivec2(1, 2), 0).r);
+    }
+    if (extraX && extraY)
+        d = max(d, texelFetch(prevLevel, src + ivec2(2, 2), 0).r);
+    FragDepth = d;
+}
+)";
+
+// One point per object. Picks the mip where the rectangle covers at most 2x2
+// texels and compares the object's nearest depth with the farthest occluder.
+const char* hizTestVertexShaderSrc = R"(
+#version 330 core
+layout (location = 0) in vec4 aRect;   // uv min (xy), uv max (zw)
+layout (location = 1) in float aDepth; // nearest window-space depth
+uniform sampler2D hizMap;
+uniform int maxLevel;
+uniform ivec2 visSize;
+flat out float visible;
+void main() {
+    vec2 sizePx = (aRect.zw - aRect.xy) * vec2(textureSize(hizMap, 0));
+    int level = clamp(int(ceil(log2(max(max(sizePx.x, sizePx.y), 1.0)))), 0, maxLevel);
+    ivec2 levelSize = textureSize(hizMap, level);
+    ivec2 lo = clamp(ivec2(aRect.xy * vec2(levelSize)), ivec2(0), levelSize - 1);
+    ivec2 hi = clamp(ivec2(aRect.zw * vec2(levelSize)), ivec2(0), levelSize - 1);
+    float d = max(max(texelFetch(hizMap, lo, level).r,
+                      texelFetch(hizMap, ivec2(hi.x, lo.y), level).r),
+                  max(texelFetch(hizMap, ivec2(lo.x, hi.y), level).r,
+                      texelFetch(hizMap, hi, level).r));
+    visible = (aDepth <= d) ? 1.0 : 0.0;
+
+    vec2 texel = vec2(gl_VertexID % visSize.x, gl_VertexID / visSize.x) + 0.5;
+    gl_Position = vec4(texel / vec2(visSize) * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+const char* hizTestFragmentShaderSrc = R"(
+#version 330 core
+out float FragVisible;
+flat in float visible;
+void main() {
+    FragVisible = visible;
+}
+)";
+
+// --------------------- Hi-Z Helpers ---------------------
+// Transform a local-space box by a model matrix and return its world AABB
+inline HiZBounds transformBounds(const glm::mat4& model, const glm::vec3& localMin, const glm::vec3& localMax) {
+    HiZBounds b;
+    b.min = glm::vec3( 1e30f);
+    b.max = glm::vec3(-1e30f);
+    for (int i = 0; i < 8; ++i) {
+        glm::vec3 corner((i & 1) ? localMax.x : localMin.x,
+                         (i & 2) ? localMax.y : localMin.y,
+                         (i & 4) ? localMax.z : localMin.z);
+        glm::vec3 p = glm::vec3(model * glm::vec4(corner, 1.0f));
+        b.min = glm::min(b.min, p);
+        b.max = glm::max(b.max, p);
+    }
+    return b;
+}
+
+inline void allocateHiZTargets(HiZCuller& c, int width, int height) {
+    c.width  = width;
+    c.height = height;
+    c.levels = 1 + (int)std::floor(std::log2((float)std::max(width, height)));
+
+    // Scene target: color renderbuffer + sampleable depth texture
+    glBindRenderbuffer(GL_RENDERBUFFER, c.sceneColorRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    bindTexture(0, GL_TEXTURE_2D, c.sceneDepthTex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+    glBindFramebuffer(GL_FRAMEBUFFER, c.sceneFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, c.sceneColorRBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, c.sceneDepthTex, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR::HIZ::SCENE_FRAMEBUFFER_INCOMPLETE" << std::endl;
+
+    // Pyramid: full mip chain of R32F
+    bindTexture(0, GL_TEXTURE_2D, c.hizTex);
+    int w = width, h = height;
+    for (int level = 0; level < c.levels; ++level) {
+        glTexImage2D(GL_TEXTURE_2D, level, GL_R32F, w, h, 0, GL_RED, GL_FLOAT, nullptr);
+        w = std::max(1, w / 2);
+        h = std::max(1, h / 2);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, c.levels - 1);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+inline void allocateHiZVisibility(HiZCuller& c, int capacity) {
+    c.visCapacity = capacity;
+    int rows = (capacity + HIZ_VIS_WIDTH - 1) / HIZ_VIS_WIDTH;
+
+    bindTexture(0, GL_TEXTURE_2D, c.visTex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, HIZ_VIS_WIDTH, rows, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, c.visFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, c.visTex, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    for (int i = 0; i < HIZ_READBACK_FRAMES; ++i) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, c.pbo[i]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, HIZ_VIS_WIDTH * rows, nullptr, GL_STREAM_READ);
+        c.pboCount[i] = 0; // results sized for the old capacity are dropped
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+// --------------------- Hi-Z Culler Interface ---------------------
+inline void initHiZCuller(HiZCuller& c, int width, int height) {
+    c.copyProgram       = createShaderProgram(hizFullscreenVertexShaderSrc, hizCopyFragmentShaderSrc);
+    c.downsampleProgram = createShaderProgram(hizFullscreenVertexShaderSrc, hizDownsampleFragmentShaderSrc);
+    c.testProgram       = createShaderProgram(hizTestVertexShaderSrc, hizTestFragmentShaderSrc);
+
+    glGenFramebuffers(1, &c.sceneFBO);
+    glGenRenderbuffers(1, &c.sceneColorRBO);
+    glGenTextures(1, &c.sceneDepthTex);
+    glGenFramebuffers(1, &c.hizFBO);
+    glGenTextures(1, &c.hizTex);
+    glGenFramebuffers(1, &c.visFBO);
+    glGenTextures(1, &c.visTex);
+    glGenBuffers(HIZ_READBACK_FRAMES, c.pbo);
+
+    glGenVertexArrays(1, &c.emptyVAO);
+    glGenVertexArrays(1, &c.testVAO);
+    glGenBuffers(1, &c.testVBO);
+    bindVertexArray(c.testVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, c.testVBO);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(4 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    c.copyPipeline.program = c.copyProgram;
+    c.copyPipeline.vao = c.emptyVAO;
+    c.copyPipeline.depthTest = false;
+    c.downsamplePipeline = c.copyPipeline;
+    c.downsamplePipeline.program = c.downsampleProgram;
+    c.testPipeline = c.copyPipeline;
+    c.testPipeline.program = c.testProgram;
+    c.testPipeline.vao = c.testVAO;
+
+    allocateHiZTargets(c, width, height);
+    allocateHiZVisibility(c, HIZ_VIS_WIDTH);
+}
+
+inline void resizeHiZCuller(HiZCuller& c, int width, int height) {
+    if (width == c.width && height == c.height)
+        return;
+    allocateHiZTargets(c, width, height);
+}
+
+// Bind the offscreen scene target and pick up the newest finished readback.
+inline void beginHiZFrame(HiZCuller& c) {
+    // This frame's slot was last written HIZ_READBACK_FRAMES frames ago
+    int slot = c.frameIndex % HIZ_READBACK_FRAMES;
+    if (c.pboCount[slot] > 0) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, c.pbo[slot]);
+        const unsigned char* data = (const unsigned char*)glMapBufferRange(
+            GL_PIXEL_PACK_BUFFER, 0, c.pboCount[slot], GL_MAP_READ_BIT);
+        if (data) {
+            c.visibility.assign(data, data + c.pboCount[slot]);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            c.culledCount = (int)std::count(c.visibility.begin(), c.visibility.end(), 0);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, c.sceneFBO);
+    glViewport(0, 0, c.width, c.height);
+}
+
+// Objects without a result yet (new ids, first frames) are treated as visible.
+inline bool isHiZVisible(const HiZCuller& c, unsigned int objectId) {
+    return objectId >= c.visibility.size() || c.visibility[objectId] != 0;
+}
+
+// Project a world AABB with the view-projection that produced the depth buffer.
+// Returns uv rect + nearest depth; boxes crossing the near plane or leaving the
+// screen are given depth 0 so they always pass (frustum culling is not our job).
+inline void projectHiZBounds(const HiZBounds& b, const glm::mat4& viewProj, float* out) {
+    glm::vec3 ndcMin( 1e30f);
+    glm::vec3 ndcMax(-1e30f);
+    bool conservative = false;
+    for (int i = 0; i < 8; ++i) {
+        glm::vec4 clip = viewProj * glm::vec4((i & 1) ? b.max.x : b.min.x,
+                                              (i & 2) ? b.max.y : b.min.y,
+                                              (i & 4) ? b.max.z : b.min.z, 1.0f);
+        if (clip.w <= 1e-4f) {
+            conservative = true;
+            break;
+        }
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        ndcMin = glm::min(ndcMin, ndc);
+        ndcMax = glm::max(ndcMax, ndc);
+    }
+    if (!conservative && (ndcMax.x < -1.0f || ndcMin.x > 1.0f || ndcMax.y < -1.0f || ndcMin.y > 1.0f))
+        conservative = true;
+
+    out[0] = glm::clamp(ndcMin.x * 0.5f + 0.5f, 0.0f, 1.0f);
+    out[1] = glm::clamp(ndcMin.y * 0.5f + 0.5f, 0.0f, 1.0f);
+    out[2] = glm::clamp(ndcMax.x * 0.5f + 0.5f, 0.0f, 1.0f);
+    out[3] = glm::clamp(ndcMax.y * 0.5f + 0.5f, 0.0f, 1.0f);
+    out[4] = conservative ? 0.0f : glm::clamp(ndcMin.z * 0.5f + 0.5f, 0.0f, 1.0f);
+}
+
+inline void buildHiZPyramid(HiZCuller& c) {
+    glBindFramebuffer(GL_FRAMEBUFFER, c.hizFBO);
+
+    // Level 0: copy of the scene depth
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, c.hizTex, 0);
+    glViewport(0, 0, c.width, c.height);
+    bindPipeline(c.copyPipeline);
+    bindTexture(0, GL_TEXTURE_2D, c.sceneDepthTex);
+    glUniform1i(glGetUniformLocation(c.copyProgram, "depthMap"), 0);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    // Remaining levels: max of the level above
+    bindPipeline(c.downsamplePipeline);
+    glUniform1i(glGetUniformLocation(c.downsampleProgram, "prevLevel"), 0);
+    bindTexture(0, GL_TEXTURE_2D, c.hizTex);
+    int w = c.width, h = c.height;
+    for (int level = 1; level < c.levels; ++level) {
+        w = std::max(1, w / 2);
+        h = std::max(1, h / 2);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level - 1);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, c.hizTex, level);
+        glViewport(0, 0, w, h);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, c.levels - 1);
+}
+
+// Build the pyramid from this frame's depth, test all bounds against it, queue
+// the async readback and present the scene target to the default framebuffer.
+inline void endHiZFrame(HiZCuller& c, const glm::mat4& viewProj, const std::vector<HiZBounds>& bounds,
+                        int windowWidth, int windowHeight) {
+    buildHiZPyramid(c);
+
+    int count = (int)bounds.size();
+    if (count > c.visCapacity)
+        allocateHiZVisibility(c, (count + HIZ_VIS_WIDTH - 1) / HIZ_VIS_WIDTH * HIZ_VIS_WIDTH);
+
+    int slot = c.frameIndex % HIZ_READBACK_FRAMES;
+    if (count > 0) {
+        std::vector<float> points(count * 5);
+        for (int i = 0; i < count; ++i)
+            projectHiZBounds(bounds[i], viewProj, &points[i * 5]);
+        glBindBuffer(GL_ARRAY_BUFFER, c.testVBO);
+        glBufferData(GL_ARRAY_BUFFER, points.size() * sizeof(float), points.data(), GL_STREAM_DRAW);
+
+        int rows = (count + HIZ_VIS_WIDTH - 1) / HIZ_VIS_WIDTH;
+        int visRows = c.visCapacity / HIZ_VIS_WIDTH;
+        glBindFramebuffer(GL_FRAMEBUFFER, c.visFBO);
+        glViewport(0, 0, HIZ_VIS_WIDTH, visRows);
+        bindPipeline(c.testPipeline);
+        bindTexture(0, GL_TEXTURE_2D, c.hizTex);
+        glUniform1i(glGetUniformLocation(c.testProgram, "hizMap"), 0);
+        glUniform1i(glGetUniformLocation(c.testProgram, "maxLevel"), c.levels - 1);
+        glUniform2i(glGetUniformLocation(c.testProgram, "visSize"), HIZ_VIS_WIDTH, visRows);
+        glDrawArrays(GL_POINTS, 0, count);
+
+        // Whole rows are read back; only the first `count` bytes are consumed
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, c.pbo[slot]);
+        glReadPixels(0, 0, HIZ_VIS_WIDTH, rows, GL_RED, GL_UNSIGNED_BYTE, (void*)0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+    c.pboCount[slot] = count;
+    c.frameIndex++;
+
+    // Present
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, c.sceneFBO);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, c.width, c.height, 0, 0, windowWidth, windowHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+inline void destroyHiZCuller(HiZCuller& c) {
+    glDeleteFramebuffers(1, &c.sceneFBO);
+    glDeleteRenderbuffers(1, &c.sceneColorRBO);
+    glDeleteTextures(1, &c.sceneDepthTex);
+    glDeleteFramebuffers(1, &c.hizFBO);
+    glDeleteTextures(1, &c.hizTex);
+    glDeleteFramebuffers(1, &c.visFBO);
+    glDeleteTextures(1, &c.visTex);
+    glDeleteBuffers(HIZ_READBACK_FRAMES, c.pbo);
+    glDeleteVertexArrays(1, &c.emptyVAO);
+    glDeleteVertexArrays(1, &c.testVAO);
+    glDeleteBuffers(1, &c.testVBO);
+    glDeleteProgram(c.copyProgram);
+    glDeleteProgram(c.downsampleProgram);
+    glDeleteProgram(c.testProgram);
+}
+
+#endif
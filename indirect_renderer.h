@@ -0,0 +1,355 @@
+#ifndef INDIRECT_RENDERER_H
+#define INDIRECT_RENDERER_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include "gl_ext.h"
+#include "mesh_buffer.h"
+#include "render_queue.h"
+#include "shader_permutations.h"
+
+// Defined in main.cpp
+unsigned int createShaderProgram(const char* vertexSrc, const char* fragmentSrc);
+
+// --------------------- Indirect Submission ---------------------
+// Draws from the shared mesh buffer with the object shader are collapsed into
+// a few multi-draw calls. Each draw's model matrix and color go into a texture
+// buffer (5 RGBA32F texels per draw), and the vertex shader fetches them by a
+// draw id taken from an instanced attribute:
+//
+//   GL 4.3 / ARB_multi_draw_indirect:
+//     one glMultiDrawElementsIndirect per texture run; every command's
+//     baseInstance is its draw id, so the divisor-1 attribute reads it back.
+//
+//   GL 3.3:
+//     there is no way to get a per-draw id into glMultiDrawElementsBaseVertex,
+//     so consecutive draws of the same mesh become one
+//     glDrawElementsInstancedBaseVertex, with the id of the first draw in a
+//     uniform and gl_InstanceID (via the same attribute) selecting the rest.
+//
+// Everything else in the queue (tessellation patches, other VAOs) is submitted
+// one draw at a time as before. Each object variant is batched with the
+// DYNAMIC_TEXTURE variant of the same lighting model and scene features, so
+// textured and colored draws share a program but keep their lighting; runs
+// are split where the batch program or the texture changes.
+
+const int INDIRECT_DRAW_TEXELS = 5;   // model matrix columns + color
+
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint  baseVertex;
+    GLuint baseInstance;
+};
+
+// Batch program standing in for the object variants that differ only in texturing
+struct IndirectProgram {
+    uint32_t key = 0;                   // DYNAMIC_TEXTURE variant key
+    unsigned int program = 0;
+    GLint drawIdBaseLoc = -1;           // stays 0 on the multi-draw path
+};
+
+struct IndirectRenderer {
+    std::vector<IndirectProgram> programs;
+    const ShaderPermutations* sourceShaders = nullptr;   // draws using its variants are batched
+    unsigned int vao = 0;
+    unsigned int boundGeneration = 0;   // mesh buffer generation the VAO was set up for
+    unsigned int commandBuffer = 0;
+    unsigned int drawDataBuffer = 0, drawDataTex = 0;
+    unsigned int drawIdBuffer = 0;
+    unsigned int drawIdCapacity = 0;
+    int  maxDraws = 0;                  // limited by GL_MAX_TEXTURE_BUFFER_SIZE
+    bool multiDrawIndirect = false;
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<glm::vec4> drawData;
+    std::vector<uint32_t> batched;      // queue index of every batched draw, in draw id order
+    std::vector<uint32_t> batchedProgram;   // index into programs, per draw id
+};
+
+const char* indirectVertexShaderSrc = R"(
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in uint aDrawId;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoord;
+flat out vec3 objectColor;
+
+uniform samplerBuffer drawData;
+uniform int drawIdBase;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main() {
+    int base = (drawIdBase + int(aDrawId)) * 5;
+    mat4 model = mat4(texelFetch(drawData, base + 0),
+                      texelFetch(drawData, base + 1),
+                      texelFetch(drawData, base + 2),
+                      texelFetch(drawData, base + 3));
+    objectColor = texelFetch(drawData, base + 4).rgb;
+    FragPos = vec3(model * vec4(aPos, 1.0));
+    Normal = mat3(transpose(inverse(model))) * aNormal;
+    TexCoord = aTexCoord;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
+)";
+
+// The object fragment shader with objectColor coming from the vertex stage
+inline std::string makeIndirectFragmentSource(const char* objFragSrc) {
+    std::string src = objFragSrc;
+    const std::string uniformDecl = "uniform vec3 objectColor;";
+    size_t pos = src.find(uniformDecl);
+    if (pos != std::string::npos)
+        src.replace(pos, uniformDecl.size(), "flat in vec3 objectColor;");
+    return src;
+}
+
+// Attribute 3 holds 0, 1, 2, ... so with divisor 1 it yields the instance
+// index plus baseInstance
+inline void ensureDrawIdCapacity(IndirectRenderer& r, unsigned int count) {
+    if (count <= r.drawIdCapacity)
+        return;
+    unsigned int capacity = std::max(count, r.drawIdCapacity * 2);
+    std::vector<GLuint> ids(capacity);
+    for (unsigned int i = 0; i < capacity; ++i)
+        ids[i] = i;
+    glBindBuffer(GL_ARRAY_BUFFER, r.drawIdBuffer);
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(GLuint), ids.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    r.drawIdCapacity = capacity;
+}
+
+// (Re)build the VAO when the mesh buffer's GL buffers were replaced by a grow
+inline void setupIndirectVAO(IndirectRenderer& r, const MeshBuffer& mb) {
+    if (r.boundGeneration == mb.generation)
+        return;
+    bindVertexArray(r.vao);
+    bindMeshBufferAttribs(mb);
+    glBindBuffer(GL_ARRAY_BUFFER, r.drawIdBuffer);
+    glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void*)0);
+    glEnableVertexAttribArray(3);
+    glVertexAttribDivisor(3, 1);
+    r.boundGeneration = mb.generation;
+}
+
+inline uint32_t indirectProgramKey(uint32_t variantKey) {
+    return (variantKey & ~SHADER_TEXTURE_MASK) | SHADER_DYNAMIC_TEXTURE;
+}
+
+inline int findIndirectProgram(const IndirectRenderer& r, uint32_t key) {
+    for (size_t i = 0; i < r.programs.size(); ++i)
+        if (r.programs[i].key == key)
+            return (int)i;
+    return -1;
+}
+
+// Fragment source of a batch program, from the variant sources of `p`
+inline std::string indirectFragmentSource(const ShaderPermutations& p, uint32_t key) {
+    return makeIndirectFragmentSource(variantFragmentSource(p, key).c_str());
+}
+
+inline void addIndirectProgram(IndirectRenderer& r, uint32_t key, unsigned int program) {
+    IndirectProgram p;
+    p.key = key;
+    p.program = program;
+    useProgram(p.program);
+    glUniform1i(glGetUniformLocation(p.program, "texture1"), 0);
+    glUniform1i(glGetUniformLocation(p.program, "drawData"), 1);
+    p.drawIdBaseLoc = glGetUniformLocation(p.program, "drawIdBase");
+    glUniform1i(p.drawIdBaseLoc, 0);
+    r.programs.push_back(p);
+}
+
+// Build the batch programs the ready object variants need. Call before the
+// frame uniforms are set, so every program a flush can use has them.
+inline void updateIndirectPrograms(IndirectRenderer& r) {
+    for (const ShaderVariant& v : r.sourceShaders->variants) {
+        uint32_t key = indirectProgramKey(v.key);
+        if (!v.ready || findIndirectProgram(r, key) >= 0)
+            continue;
+        std::string fragSrc = indirectFragmentSource(*r.sourceShaders, key);
+        addIndirectProgram(r, key, createShaderProgram(indirectVertexShaderSrc, fragSrc.c_str()));
+    }
+}
+
+// Swap in batch programs rebuilt from new source text (shader hot reload).
+// Keys the rebuild didn't cover are built again by the next update.
+inline void reloadIndirectPrograms(IndirectRenderer& r, const std::vector<uint32_t>& keys,
+                                   const std::vector<unsigned int>& programs) {
+    for (const IndirectProgram& p : r.programs)
+        glDeleteProgram(p.program);
+    r.programs.clear();
+    for (size_t i = 0; i < keys.size(); ++i)
+        addIndirectProgram(r, keys[i], programs[i]);
+}
+
+// Batch program for a draw's object variant; -1 if it has none yet
+inline int indirectProgramFor(const IndirectRenderer& r, unsigned int program) {
+    for (const ShaderVariant& v : r.sourceShaders->variants)
+        if (v.ready && v.program == program)
+            return findIndirectProgram(r, indirectProgramKey(v.key));
+    return -1;
+}
+
+inline void initIndirectRenderer(IndirectRenderer& r, const ShaderPermutations& objectShaders) {
+    r.sourceShaders = &objectShaders;
+    r.multiDrawIndirect = glCaps.multiDrawIndirect;
+
+    GLint maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    r.maxDraws = maxTexels / INDIRECT_DRAW_TEXELS;
+
+    glGenVertexArrays(1, &r.vao);
+    glGenBuffers(1, &r.drawIdBuffer);
+    glGenBuffers(1, &r.drawDataBuffer);
+    glGenBuffers(1, &r.commandBuffer);
+    glGenTextures(1, &r.drawDataTex);
+    ensureDrawIdCapacity(r, 1024);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, r.drawDataBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, 0, nullptr, GL_STREAM_DRAW);
+    bindTexture(1, GL_TEXTURE_BUFFER, r.drawDataTex);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, r.drawDataBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+inline bool isIndirectBatchable(const MeshBuffer& mb, const DrawCommand& cmd) {
+    return cmd.vao == mb.vao && cmd.indexed && cmd.mode == GL_TRIANGLES;
+}
+
+// Upload the per-draw data and indirect commands for the batched draws
+inline void uploadIndirectBatch(IndirectRenderer& r) {
+    glBindBuffer(GL_TEXTURE_BUFFER, r.drawDataBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, r.drawData.size() * sizeof(glm::vec4), r.drawData.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    if (r.multiDrawIndirect) {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, r.commandBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, r.commands.size() * sizeof(DrawElementsIndirectCommand),
+                     r.commands.data(), GL_STREAM_DRAW);
+    }
+}
+
+// Issue draw ids [first, first + count), all sharing program, VAO and texture
+inline void drawIndirectRun(RenderQueue& q, IndirectRenderer& r, const IndirectProgram& p, size_t first,
+                            size_t count) {
+    if (r.multiDrawIndirect) {
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                    (void*)(first * sizeof(DrawElementsIndirectCommand)), (GLsizei)count, 0);
+        q.stats.drawCalls++;
+        return;
+    }
+    // Same mesh back to back -> one instanced draw
+    size_t i = first, end = first + count;
+    while (i < end) {
+        const DrawElementsIndirectCommand& c = r.commands[i];
+        size_t j = i + 1;
+        while (j < end && r.commands[j].firstIndex == c.firstIndex && r.commands[j].count == c.count &&
+               r.commands[j].baseVertex == c.baseVertex)
+            ++j;
+        glUniform1i(p.drawIdBaseLoc, (GLint)i);
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, (GLsizei)c.count, GL_UNSIGNED_INT,
+                                          (void*)(c.firstIndex * sizeof(unsigned int)), (GLsizei)(j - i), c.baseVertex);
+        q.stats.drawCalls++;
+        i = j;
+    }
+}
+
+// Sort, then submit: batchable draws go through multi-draw runs, the rest one by one.
+// Draw order is the queue's sorted order either way.
+inline void flushRenderQueueIndirect(RenderQueue& q, IndirectRenderer& r, const MeshBuffer& mb, float maxDepth) {
+    sortRenderQueue(q, maxDepth);
+
+    r.commands.clear();
+    r.drawData.clear();
+    r.batched.clear();
+    r.batchedProgram.clear();
+    unsigned int lastSource = 0;
+    int lastProgram = -1;
+    for (size_t i = 0; i < q.order.size(); ++i) {
+        const DrawCommand& cmd = q.commands[q.order[i]];
+        if (!isIndirectBatchable(mb, cmd) || (int)r.batched.size() >= r.maxDraws)
+            continue;
+        // The queue is sorted by program, so the lookup rarely runs
+        if (cmd.program != lastSource) {
+            lastSource = cmd.program;
+            lastProgram = indirectProgramFor(r, cmd.program);
+        }
+        if (lastProgram < 0)
+            continue;
+        GLuint drawId = (GLuint)r.batched.size();
+        r.commands.push_back({ (GLuint)cmd.count, 1, (GLuint)(cmd.indexOffset / sizeof(unsigned int)),
+                               cmd.baseVertex, drawId });
+        for (int c = 0; c < 4; ++c)
+            r.drawData.push_back(cmd.model[c]);
+        r.drawData.push_back(glm::vec4(cmd.color, 1.0f));
+        r.batched.push_back(q.order[i]);
+        r.batchedProgram.push_back((uint32_t)lastProgram);
+    }
+    uploadIndirectBatch(r);
+    ensureDrawIdCapacity(r, (unsigned int)r.batched.size());
+    setupIndirectVAO(r, mb);
+
+    bindTexture(1, GL_TEXTURE_BUFFER, r.drawDataTex);
+
+    for (const IndirectProgram& p : r.programs)
+        programState(q, p.program);
+    SubmitState st;
+    beginSubmit(st);
+    size_t next = 0;   // next draw id to issue
+    size_t i = 0;
+    while (i < q.order.size()) {
+        const DrawCommand& cmd = q.commands[q.order[i]];
+        if (next >= r.batched.size() || r.batched[next] != q.order[i]) {
+            submitDrawCommand(q, st, cmd);
+            ++i;
+            continue;
+        }
+
+        // Consecutive batched draws with the same batch program and texture form one run
+        size_t first = next;
+        uint32_t program = r.batchedProgram[first];
+        while (i < q.order.size() && next < r.batched.size() && r.batched[next] == q.order[i] &&
+               r.batchedProgram[next] == program && q.commands[q.order[i]].texture == cmd.texture) {
+            ++i;
+            ++next;
+        }
+        size_t count = next - first;
+
+        const IndirectProgram& p = r.programs[program];
+        DrawCommand runState = cmd;
+        runState.program = p.program;
+        runState.vao = r.vao;
+        applyDrawState(q, st, runState);
+        q.stats.stateRequested += 3 * (int)(count - 1);  // the draws folded into the run
+        q.stats.draws += (int)count;
+        drawIndirectRun(q, r, p, first, count);
+    }
+
+    if (r.multiDrawIndirect)
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+inline void destroyIndirectRenderer(IndirectRenderer& r) {
+    for (const IndirectProgram& p : r.programs)
+        glDeleteProgram(p.program);
+    r.programs.clear();
+    glDeleteVertexArrays(1, &r.vao);
+    glDeleteBuffers(1, &r.drawIdBuffer);
+    glDeleteBuffers(1, &r.drawDataBuffer);
+    glDeleteBuffers(1, &r.commandBuffer);
+    glDeleteTextures(1, &r.drawDataTex);
+}
+
+#endif
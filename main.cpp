@@ -14,6 +14,29 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+#include "gl_ext.h"
+#include "pipeline_state.h"
+#include "shader_cache.h"
+#include "shader_permutations.h"
+#include "shader_reload.h"
+#include "environment_lighting.h"
+#include "shadow_maps.h"
+#include "clustered_lighting.h"
+#include "deferred_renderer.h"
+#include "hiz_culling.h"
+#include "sphere_generator.h"
+#include "procedural_mesh.h"
+#include "sphere_lod.h"
+#include "ground_streaming.h"
+#include "terrain_cdlod.h"
+#include "tessellation.h"
+#include "mesh_optimizer.h"
+#include "render_queue.h"
+#include "indirect_renderer.h"
+#include "meshlets.h"
+#include "mesh_import.h"
+#include "obj_parser.h"
+
 // --------------------- Global Settings ---------------------
 const unsigned int SCR_WIDTH  = 1000;
 const unsigned int SCR_HEIGHT = 800;
@@ -32,6 +55,28 @@ bool  firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+// Rendering options (set from the command line)
+bool useHiZCulling = false;   // --hiz : occlusion-cull objects against last frame's depth pyramid
+bool useSphereLod = true;     // --no-lod : always draw spheres at the finest level
+int  sphereFieldCount = 0;    // --sphere-field N : add N spheres on a grid (LOD benchmark)
+bool useTessellation = false; // --tess : GPU tessellation of sphere/ground (GL 4.0+, else discrete LODs)
+bool useIndirectDraw = false; // --indirect : multi-draw submission with per-draw data in a texture buffer
+bool useTerrain = false;      // --terrain : CDLOD heightmap terrain instead of the ground quad
+bool useStreamedGround = false; // --streamed-ground : ground tiles streamed around the camera
+bool showShapes = false;      // --shapes : add a row of procedural shapes behind the cube
+bool usePackedVertices = false; // --packed-vertices : 16-byte half/10:10:10:2 vertices instead of 32-byte floats
+bool useMeshlets = false;     // --meshlets : high-poly selected sphere, cluster-culled on the CPU every frame
+bool useShaderCache = true;   // --no-shader-cache : always compile shaders from source
+bool benchShaderCache = false; // --bench-shader-cache : time compile vs. cached program binaries, then exit
+bool useFog = false;          // --fog : distance fog compiled into every object shader variant
+bool useHotReload = false;    // --hot-reload : rebuild programs when their files in shaders/ change
+bool useSkyTriangle = false;  // --sky-triangle : skybox as one fullscreen triangle instead of a cube
+bool useIBL = false;          // --ibl : ambient and reflections from the prefiltered skybox
+bool useShadows = false;      // --shadows : cascaded shadow maps for the directional light
+int  clusteredLightCount = 0; // --lights N : N moving point/spot lights, clustered forward shading
+bool useDeferred = false;     // --deferred : G-buffer geometry pass and one fullscreen lighting pass
+std::string modelPath;        // --model FILE : OBJ/glTF/.mesh model shown next to the pyramid
+
 // --------------------- Global Variables for Object Transformations ---------------------
 // 1 = cube, 2 = pyramid, 3 = sphere
 int selectedObject = 1;
@@ -240,39 +285,11 @@ void processInput(GLFWwindow* window) {
 }
  
 // --------------------- Utility Shader Functions ---------------------
-unsigned int compileShader(unsigned int type, const char* source) {
-    unsigned int shader = glCreateShader(type);
-    glShaderSource(shader, 1, &source, nullptr);
-    glCompileShader(shader);
-
-    int success;
-    char infoLog[512];
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(shader, 512, nullptr, infoLog);
-        std::cout << "ERROR::SHADER_COMPILATION_ERROR:\n" << infoLog << std::endl;
-    }
-    return shader;
-}
- 
+// Compiled once per driver and shader source, then loaded from the program binary cache.
+// Inside a program batch the result may still be compiling when this returns.
 unsigned int createShaderProgram(const char* vertSrc, const char* fragSrc) {
-    unsigned int vertexShader = compileShader(GL_VERTEX_SHADER, vertSrc);
-    unsigned int fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragSrc);
-    unsigned int program = glCreateProgram();
-    glAttachShader(program, vertexShader);
-    glAttachShader(program, fragmentShader);
-    glLinkProgram(program);
-
-    int success;
-    char infoLog[512];
-    glGetProgramiv(program, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(program, 512, nullptr, infoLog);
-        std::cout << "ERROR::PROGRAM_LINKING_ERROR:\n" << infoLog << std::endl;
-    }
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-    return program;
+    ShaderStageSource stages[] = { { GL_VERTEX_SHADER, vertSrc }, { GL_FRAGMENT_SHADER, fragSrc } };
+    return createCachedProgram(programCache, stages, 2);
 }
  
 // --------------------- Texture Loading Functions ---------------------
@@ -287,7 +304,7 @@ unsigned int loadTexture(const char* path) {
         if (nrChannels == 1)       format = GL_RED;
         else if (nrChannels == 4)  format = GL_RGBA;
  
-        glBindTexture(GL_TEXTURE_2D, textureID);
+        bindTexture(0, GL_TEXTURE_2D, textureID);
         glTexImage2D(GL_TEXTURE_2D, 0, (GLint)format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
         glGenerateMipmap(GL_TEXTURE_2D);
  
@@ -307,7 +324,7 @@ unsigned int loadTexture(const char* path) {
 unsigned int loadCubemap(std::vector<std::string> faces) {
     unsigned int textureID;
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+    bindTexture(0, GL_TEXTURE_CUBE_MAP, textureID);
  
     int width, height, nrChannels;
     for (unsigned int i = 0; i < faces.size(); i++) {
@@ -444,7 +461,8 @@ float pyramidVertices[] = {
 };
  
 // --------------------- Sphere Generation ---------------------
-void generateSphere(std::vector<float>& vertices, std::vector<unsigned int>& indices, float radius, unsigned int sectorCount, unsigned int stackCount) {
+// Original per-vertex generator, kept as the reference for --bench-sphere
+void generateSphereReference(std::vector<float>& vertices, std::vector<unsigned int>& indices, float radius, unsigned int sectorCount, unsigned int stackCount) {
     const float PI = 3.14159265359f;
     for (unsigned int i = 0; i <= stackCount; ++i) {
         float stackAngle = PI / 2 - i * (PI / stackCount);
@@ -484,104 +502,347 @@ void generateSphere(std::vector<float>& vertices, std::vector<unsigned int>& ind
         }
     }
 }
+
+void generateSphere(std::vector<float>& vertices, std::vector<unsigned int>& indices, float radius, unsigned int sectorCount, unsigned int stackCount) {
+    generateSphereFast(vertices, indices, radius, sectorCount, stackCount);
+}
  
 // --------------------- Shader Sources ---------------------
-// Object Shader
-const char* objVertexShaderSrc = R"(
-#version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
-layout (location = 2) in vec2 aTexCoord;
- 
-out vec3 FragPos;
-out vec3 Normal;
-out vec2 TexCoord;
- 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
- 
-void main() {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
-    TexCoord = aTexCoord;
-    gl_Position = projection * view * vec4(FragPos, 1.0);
+// Read from disk at startup; --hot-reload rebuilds their programs on change
+const char* OBJECT_VERTEX_SHADER   = "shaders/object.vert";
+const char* OBJECT_FRAGMENT_SHADER = "shaders/object.frag";
+const char* SKYBOX_VERTEX_SHADER   = "shaders/skybox.vert";
+const char* SKYBOX_FRAGMENT_SHADER = "shaders/skybox.frag";
+const char* SKYBOX_TRIANGLE_VERTEX_SHADER = "shaders/skybox_triangle.vert";
+const char* SHADOW_DEPTH_VERTEX_SHADER   = "shaders/shadow_depth.vert";
+const char* SHADOW_DEPTH_FRAGMENT_SHADER = "shaders/shadow_depth.frag";
+const char* SHADOW_SAMPLING_SHADER       = "shaders/shadows.glsl";
+const char* CLUSTERED_LIGHTS_SHADER      = "shaders/clustered_lights.glsl";
+const char* GBUFFER_FRAGMENT_SHADER      = "shaders/gbuffer.frag";
+const char* FULLSCREEN_VERTEX_SHADER     = "shaders/fullscreen.vert";
+const char* DEFERRED_LIGHTING_SHADER     = "shaders/deferred_lighting.frag";
+
+// The cube and the fullscreen triangle share the skybox fragment shader
+const char* skyboxVertexShader() {
+    return useSkyTriangle ? SKYBOX_TRIANGLE_VERTEX_SHADER : SKYBOX_VERTEX_SHADER;
 }
-)";
-   
-const char* objFragmentShaderSrc = R"(
-#version 330 core
-out vec4 FragColor;
- 
-in vec3 FragPos;
-in vec3 Normal;
-in vec2 TexCoord;
- 
-uniform sampler2D texture1;
-uniform bool useTexture;
-uniform vec3 objectColor;
- 
-uniform vec3 lightDir;
-uniform vec3 lightColor;
-uniform vec3 viewPos;
- 
-void main() {
-    float ambientStrength = 0.3;
-    vec3 ambient = ambientStrength * lightColor;
-    vec3 norm = normalize(Normal);
-    vec3 invLight = normalize(-lightDir);
-    float diff = max(dot(norm, invLight), 0.0);
-    vec3 diffuse = diff * lightColor;
-    float specularStrength = 0.5;
-    vec3 viewDir = normalize(viewPos - FragPos);
-    vec3 reflectDir = reflect(lightDir, norm);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
-    vec3 specular = specularStrength * spec * lightColor;
-     
-    vec3 texColor = useTexture ? texture(texture1, TexCoord).rgb : objectColor;
-    vec3 result = (ambient + diffuse + specular) * texColor;
-    FragColor = vec4(result, 1.0);
+
+// The deferred path builds the object variants as G-buffer writers
+const char* objectFragmentShader() {
+    return useDeferred ? GBUFFER_FRAGMENT_SHADER : OBJECT_FRAGMENT_SHADER;
 }
-)";
    
-// Skybox Shader
-const char* skyboxVertexShaderSrc = R"(
-#version 330 core
-layout (location = 0) in vec3 aPos;
-out vec3 TexCoords;
-uniform mat4 view;
-uniform mat4 projection;
-void main() {
-    TexCoords = aPos;
-    vec4 pos = projection * view * vec4(aPos, 1.0);
-    gl_Position = pos.xyww;
+// --------------------- Per-Frame Uniforms ---------------------
+const glm::vec3 LIGHT_DIRECTION(-0.2f, -1.0f, -0.3f);
+EnvironmentLighting environment;   // --ibl
+ShadowMaps shadowMaps;             // --shadows
+ClusteredLighting clusteredLights; // --lights
+
+// Camera and light uniforms shared by every program using the object lighting model
+void setFrameUniforms(unsigned int program, const glm::mat4& view, const glm::mat4& projection) {
+    useProgram(program);
+    glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform3fv(glGetUniformLocation(program, "lightDir"), 1, glm::value_ptr(LIGHT_DIRECTION));
+    glUniform3fv(glGetUniformLocation(program, "lightColor"), 1, glm::value_ptr(glm::vec3(1.0f)));
+    glUniform3fv(glGetUniformLocation(program, "viewPos"), 1, glm::value_ptr(cameraPos));
+    // Only variants built with FOG have these
+    glUniform3fv(glGetUniformLocation(program, "fogColor"), 1, glm::value_ptr(glm::vec3(0.55f, 0.6f, 0.65f)));
+    glUniform1f(glGetUniformLocation(program, "fogDensity"), useTerrain ? 0.0006f : 0.04f);
+    if (useIBL)
+        setEnvironmentUniforms(program, environment);
+    if (useShadows)
+        setShadowUniforms(program, shadowMaps);
+    if (clusteredLightCount > 0)
+        setClusterUniforms(program, clusteredLights);
 }
-)";
-   
-const char* skyboxFragmentShaderSrc = R"(
-#version 330 core
-out vec4 FragColor;
-in vec3 TexCoords;
-uniform samplerCube skybox;
-void main() {
-    FragColor = texture(skybox, TexCoords);
+
+// Procedural shape row (--shapes), behind the cube
+glm::vec3 shapePosition(size_t i) {
+    return glm::vec3(-4.5f + 1.5f * i, 0.6f, -3.0f);
 }
-)";
-   
+
+// Shadow caster with the bounding sphere of its transformed local box
+ShadowCaster makeShadowCaster(const MeshHandle& mesh, const glm::mat4& model, const glm::vec3& localMin,
+                              const glm::vec3& localMax) {
+    HiZBounds b = transformBounds(model, localMin, localMax);
+    ShadowCaster caster;
+    caster.mesh = mesh;
+    caster.model = model;
+    caster.center = (b.min + b.max) * 0.5f;
+    caster.radius = glm::length(b.max - b.min) * 0.5f;
+    return caster;
+}
+ 
+// --------------------- Shader Hot Reload ---------------------
+// Every program built from a file in shaders/ is rebuilt when one of its
+// files changes, one job per set of programs that share their sources:
+//   object    object vertex and fragment shader, shadow and cluster
+//             functions: the object variants and the programs made from
+//             them (tessellation, terrain, indirect batches)
+//   deferred  fullscreen triangle and lighting pass, shadow and cluster functions
+//   shadow    cascade depth pass
+//   skybox
+// Variants are tagged with their key; the object job's other builds with
+// their kind, above every key.
+const uint32_t RELOAD_TESS_SPHERE = 1u << 16;
+const uint32_t RELOAD_TESS_GROUND = 2u << 16;
+const uint32_t RELOAD_TERRAIN     = 3u << 16;
+const uint32_t RELOAD_INDIRECT    = 4u << 16;   // | batch program key
+const uint32_t RELOAD_KIND_MASK   = 0xFFFF0000u;
+
+// Scene features of the forward variants, and of the deferred lighting pass
+uint32_t sceneShaderFeatures() {
+    return (useFog ? (uint32_t)SHADER_FOG : 0u) | (useIBL ? (uint32_t)SHADER_IBL : 0u) |
+           (useShadows ? (uint32_t)SHADER_SHADOWS : 0u) | (clusteredLightCount > 0 ? (uint32_t)SHADER_CLUSTERED : 0u);
+}
+
+// The ground material's variant, shared by the tessellated and terrain ground
+uint32_t groundVariantKey(const ShaderPermutations& objectShaders) {
+    return shaderVariantKey(SHADER_TEXTURED | objectShaders.sceneFeatures, LIGHTING_LAMBERT);
+}
+
+// Files of the programs this run builds
+std::vector<std::string> hotReloadShaderFiles() {
+    std::vector<std::string> files = { OBJECT_VERTEX_SHADER, objectFragmentShader(),
+                                       skyboxVertexShader(), SKYBOX_FRAGMENT_SHADER };
+    if (useShadows)
+        files.insert(files.end(), { SHADOW_SAMPLING_SHADER, SHADOW_DEPTH_VERTEX_SHADER, SHADOW_DEPTH_FRAGMENT_SHADER });
+    if (clusteredLightCount > 0)
+        files.push_back(CLUSTERED_LIGHTS_SHADER);
+    if (useDeferred)
+        files.insert(files.end(), { FULLSCREEN_VERTEX_SHADER, DEFERRED_LIGHTING_SHADER });
+    return files;
+}
+
+// The shadow and cluster functions the variants include, read again
+bool readIncludedShaders(ShaderPermutations& sources) {
+    std::string shadowSrc;
+    if (useShadows) {
+        if (!readShaderFile(SHADOW_SAMPLING_SHADER, shadowSrc))
+            return false;
+        sources.shadowSource = shadowSamplingSource(shadowSrc);
+    }
+    return clusteredLightCount == 0 || readShaderFile(CLUSTERED_LIGHTS_SHADER, sources.clusterSource);
+}
+
+ShaderBuild makeShaderBuild(uint32_t tag, const std::string& vertexSrc, const std::string& fragmentSrc) {
+    ShaderBuild b;
+    b.tag = tag;
+    b.vertexSrc = vertexSrc;
+    b.fragmentSrc = fragmentSrc;
+    return b;
+}
+
+ShaderBuild makeTessShaderBuild(uint32_t tag, const char* surfaceSrc, const std::string& fragmentSrc) {
+    ShaderBuild b = makeShaderBuild(tag, tessVertexShaderSrc, fragmentSrc);
+    b.tessControlSrc = tessControlSource(surfaceSrc);
+    b.tessEvaluationSrc = tessEvaluationSource(surfaceSrc);
+    return b;
+}
+
+// Queue rebuilds of every program set with a changed file
+void queueShaderReloads(ShaderWatcher& watcher, const ShaderPermutations& objectShaders,
+                        const IndirectRenderer& indirect) {
+    bool objectChanged = false, includesChanged = false, deferredChanged = false;
+    bool shadowChanged = false, skyboxChanged = false;
+    for (const std::string& path : takeChangedShaderFiles(watcher)) {
+        objectChanged = objectChanged || path == OBJECT_VERTEX_SHADER || path == objectFragmentShader();
+        includesChanged = includesChanged || path == SHADOW_SAMPLING_SHADER || path == CLUSTERED_LIGHTS_SHADER;
+        deferredChanged = deferredChanged || path == FULLSCREEN_VERTEX_SHADER || path == DEFERRED_LIGHTING_SHADER;
+        shadowChanged = shadowChanged || path == SHADOW_DEPTH_VERTEX_SHADER || path == SHADOW_DEPTH_FRAGMENT_SHADER;
+        skyboxChanged = skyboxChanged || path == skyboxVertexShader() || path == SKYBOX_FRAGMENT_SHADER;
+    }
+    // Variant sources with the new file text; the live set keeps the old until the swap
+    ShaderPermutations sources;
+    sources.sceneFeatures = objectShaders.sceneFeatures;
+    if ((objectChanged || includesChanged || deferredChanged) && !readIncludedShaders(sources))
+        objectChanged = includesChanged = deferredChanged = false;
+
+    ShaderReloadJob object;
+    if ((objectChanged || includesChanged) && readShaderFile(OBJECT_VERTEX_SHADER, object.vertexSrc) &&
+        readShaderFile(objectFragmentShader(), object.fragmentSrc)) {
+        object.name = "object";
+        object.includeSrc = { sources.shadowSource, sources.clusterSource };
+        sources.fragmentSrc = object.fragmentSrc.c_str();
+        for (const ShaderVariant& v : objectShaders.variants)
+            object.builds.push_back(makeShaderBuild(v.key, object.vertexSrc, variantFragmentSource(sources, v.key)));
+        uint32_t groundVariant = groundVariantKey(objectShaders);
+        if (useTessellation) {
+            uint32_t sphereVariant = shaderVariantKey(objectShaders.sceneFeatures, LIGHTING_PHONG);
+            object.builds.push_back(makeTessShaderBuild(RELOAD_TESS_SPHERE, tessSphereSurfaceSrc,
+                                                        variantFragmentSource(sources, sphereVariant)));
+            object.builds.push_back(makeTessShaderBuild(RELOAD_TESS_GROUND, tessGroundSurfaceSrc,
+                                                        variantFragmentSource(sources, groundVariant)));
+        }
+        if (useTerrain)
+            object.builds.push_back(makeShaderBuild(RELOAD_TERRAIN, terrainVertexShaderSrc,
+                                                    variantFragmentSource(sources, groundVariant)));
+        for (const IndirectProgram& p : indirect.programs)
+            object.builds.push_back(makeShaderBuild(RELOAD_INDIRECT | p.key, indirectVertexShaderSrc,
+                                                    indirectFragmentSource(sources, p.key)));
+        submitShaderReload(watcher, object);
+    }
+    ShaderReloadJob deferredLighting;
+    if (useDeferred && (deferredChanged || includesChanged) &&
+        readShaderFile(FULLSCREEN_VERTEX_SHADER, deferredLighting.vertexSrc) &&
+        readShaderFile(DEFERRED_LIGHTING_SHADER, deferredLighting.fragmentSrc)) {
+        deferredLighting.name = "deferred";
+        deferredLighting.builds.push_back(makeShaderBuild(0, deferredLighting.vertexSrc,
+            deferredLightingSource(sources, deferredLighting.fragmentSrc.c_str(), sceneShaderFeatures())));
+        submitShaderReload(watcher, deferredLighting);
+    }
+    ShaderReloadJob shadowDepth;
+    if (useShadows && shadowChanged && readShaderFile(SHADOW_DEPTH_VERTEX_SHADER, shadowDepth.vertexSrc) &&
+        readShaderFile(SHADOW_DEPTH_FRAGMENT_SHADER, shadowDepth.fragmentSrc)) {
+        shadowDepth.name = "shadow";
+        shadowDepth.builds.push_back(makeShaderBuild(0, shadowDepth.vertexSrc, shadowDepth.fragmentSrc));
+        submitShaderReload(watcher, shadowDepth);
+    }
+    ShaderReloadJob skybox;
+    if (skyboxChanged && readShaderFile(skyboxVertexShader(), skybox.vertexSrc) &&
+        readShaderFile(SKYBOX_FRAGMENT_SHADER, skybox.fragmentSrc)) {
+        skybox.name = "skybox";
+        skybox.builds.push_back(makeShaderBuild(0, skybox.vertexSrc, skybox.fragmentSrc));
+        submitShaderReload(watcher, skybox);
+    }
+}
+
+// Swap in a finished rebuild; on failure the old programs stay. Returns true
+// if programs were replaced.
+bool applyShaderReload(ShaderReloadJob& job, ShaderPermutations& objectShaders, std::string& objVertexSrc,
+                       std::string& objFragmentSrc, unsigned int& skyboxShader, TessellationRenderer& tess,
+                       TerrainRenderer& terrain, IndirectRenderer& indirect, DeferredRenderer& deferred) {
+    if (!job.ok) {
+        std::cout << "ERROR::SHADER::RELOAD: " << job.name << " shaders failed, keeping the previous programs\n"
+                  << job.log << std::endl;
+        return false;
+    }
+    if (job.name == "object") {
+        objVertexSrc = job.vertexSrc;
+        objFragmentSrc = job.fragmentSrc;
+        objectShaders.shadowSource = job.includeSrc[0];
+        objectShaders.clusterSource = job.includeSrc[1];
+        std::vector<uint32_t> keys, indirectKeys;
+        std::vector<unsigned int> programs, indirectPrograms;
+        for (const ShaderBuild& b : job.builds) {
+            uint32_t kind = b.tag & RELOAD_KIND_MASK;
+            if (kind == 0) {
+                keys.push_back(b.tag);
+                programs.push_back(b.program);
+            } else if (kind == RELOAD_TESS_SPHERE) {
+                glDeleteProgram(tess.sphereProgram);
+                tess.sphereProgram = b.program;
+            } else if (kind == RELOAD_TESS_GROUND) {
+                glDeleteProgram(tess.groundProgram);
+                tess.groundProgram = b.program;
+            } else if (kind == RELOAD_TERRAIN) {
+                setTerrainProgram(terrain, b.program);
+            } else {
+                indirectKeys.push_back(b.tag & ~RELOAD_KIND_MASK);
+                indirectPrograms.push_back(b.program);
+            }
+        }
+        reloadVariantPrograms(objectShaders, objVertexSrc.c_str(), objFragmentSrc.c_str(), keys, programs);
+        if (useIndirectDraw)
+            reloadIndirectPrograms(indirect, indirectKeys, indirectPrograms);
+    } else if (job.name == "deferred") {
+        setDeferredProgram(deferred, job.builds[0].program);
+    } else if (job.name == "shadow") {
+        setShadowDepthProgram(shadowMaps, job.builds[0].program);
+    } else {
+        glDeleteProgram(skyboxShader);
+        skyboxShader = job.builds[0].program;
+    }
+    std::cout << "Reloaded " << job.name << " shaders (" << job.builds.size() << " programs, "
+              << (int)job.ms << " ms)" << std::endl;
+    return true;
+}
+ 
 // --------------------- Main Function ---------------------
-int main() {
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--hiz")
+            useHiZCulling = true;
+        else if (arg == "--tess")
+            useTessellation = true;
+        else if (arg == "--indirect")
+            useIndirectDraw = true;
+        else if (arg == "--terrain")
+            useTerrain = true;
+        else if (arg == "--streamed-ground")
+            useStreamedGround = true;
+        else if (arg == "--shapes")
+            showShapes = true;
+        else if (arg == "--packed-vertices")
+            usePackedVertices = true;
+        else if (arg == "--meshlets")
+            useMeshlets = true;
+        else if (arg == "--bench-sphere") {
+            benchmarkSphereGeneration(generateSphereReference);
+            return 0;
+        } else if (arg == "--bench-lights") {
+            benchmarkClusteredLighting();
+            return 0;
+        } else if (arg == "--bench-meshlets") {
+            benchmarkMeshlets();
+            return 0;
+        } else if (arg == "--bench-obj" && i + 1 < argc) {
+            benchmarkObjParsing(argv[++i]);
+            return 0;
+        } else if (arg == "--convert-mesh" && i + 1 < argc) {
+            return convertMeshFile(argv[++i]) ? 0 : 1;
+        } else if (arg == "--model" && i + 1 < argc)
+            modelPath = argv[++i];
+        else if (arg == "--no-shader-cache")
+            useShaderCache = false;
+        else if (arg == "--bench-shader-cache")
+            benchShaderCache = true;
+        else if (arg == "--fog")
+            useFog = true;
+        else if (arg == "--hot-reload")
+            useHotReload = true;
+        else if (arg == "--sky-triangle")
+            useSkyTriangle = true;
+        else if (arg == "--ibl")
+            useIBL = true;
+        else if (arg == "--shadows")
+            useShadows = true;
+        else if (arg == "--deferred")
+            useDeferred = true;
+        else if (arg == "--lights" && i + 1 < argc)
+            clusteredLightCount = std::max(0, std::min(atoi(argv[++i]), CLUSTER_MAX_SCENE_LIGHTS));
+        else if (arg == "--no-lod")
+            useSphereLod = false;
+        else if (arg == "--sphere-field" && i + 1 < argc)
+            sphereFieldCount = std::max(0, atoi(argv[++i]));
+        else
+            std::cout << "Unknown option: " << arg << std::endl;
+    }
+
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW\n";
         return -1;
     }
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    // Tessellation needs a 4.0 context and multi-draw indirect 4.3; everything
+    // else runs on 3.3 core
+    int contextMinor = useIndirectDraw ? 3 : (useTessellation ? 0 : 3);
+    bool wantsGL4 = useTessellation || useIndirectDraw;
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, wantsGL4 ? 4 : 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, contextMinor);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
  
     GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "3D Interactive Scene", nullptr, nullptr);
+    if (!window && wantsGL4) {
+        std::cout << "GL 4." << contextMinor << " context unavailable, retrying with 3.3 core\n";
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "3D Interactive Scene", nullptr, nullptr);
+    }
     if (!window) {
         std::cerr << "Failed to create GLFW window\n";
         glfwTerminate();
@@ -597,90 +858,148 @@ int main() {
         std::cerr << "Failed to initialize GLAD\n";
         return -1;
     }
-    glEnable(GL_DEPTH_TEST);
+    loadGLExtensions((GLADloadproc)glfwGetProcAddress);
+    if (useTessellation && !glCaps.tessellation) {
+        std::cout << "Tessellation shaders unavailable, using discrete sphere LODs\n";
+        useTessellation = false;
+    }
+    invalidateGLState();
+    setDepthTest(true);
+    std::string fullscreenVertexSrc, deferredLightingSrc;
+    if (useDeferred)
+        useDeferred = readShaderFile(FULLSCREEN_VERTEX_SHADER, fullscreenVertexSrc) &&
+                      readShaderFile(DEFERRED_LIGHTING_SHADER, deferredLightingSrc);
+    std::string objVertexShaderSrc, objFragmentShaderSrc, skyboxVertexShaderSrc, skyboxFragmentShaderSrc;
+    if (!readShaderFile(OBJECT_VERTEX_SHADER, objVertexShaderSrc) || !readShaderFile(objectFragmentShader(), objFragmentShaderSrc) ||
+        !readShaderFile(skyboxVertexShader(), skyboxVertexShaderSrc) || !readShaderFile(SKYBOX_FRAGMENT_SHADER, skyboxFragmentShaderSrc)) {
+        glfwTerminate();
+        return -1;
+    }
+    initProgramCache(programCache, useShaderCache);
+    if (benchShaderCache) {
+        benchmarkProgramCache(objVertexShaderSrc.c_str(), objFragmentShaderSrc.c_str());
+        glfwTerminate();
+        return 0;
+    }
  
-    // Build shader programs
-    unsigned int objShader = createShaderProgram(objVertexShaderSrc, objFragmentShaderSrc);
-    unsigned int skyboxShader = createShaderProgram(skyboxVertexShaderSrc, skyboxFragmentShaderSrc);
+    // Build shader programs. Everything up to endProgramBatch() only submits
+    // compiles, so the driver works on them while geometry is built and
+    // textures are decoded; setup that needs a program's uniforms comes last.
+    beginProgramBatch(programCache);
+    // Object shader variants: the Phong ones every material can fall back on
+    // are built now, the rest compile in the background when first drawn
+    ShaderPermutations objectShaders;
+    std::string shadowSamplingSrc, shadowDepthVertexSrc, shadowDepthFragmentSrc, clusteredLightsSrc;
+    if (useShadows)
+        useShadows = readShaderFile(SHADOW_SAMPLING_SHADER, shadowSamplingSrc) &&
+                     readShaderFile(SHADOW_DEPTH_VERTEX_SHADER, shadowDepthVertexSrc) &&
+                     readShaderFile(SHADOW_DEPTH_FRAGMENT_SHADER, shadowDepthFragmentSrc);
+    if (clusteredLightCount > 0 && !readShaderFile(CLUSTERED_LIGHTS_SHADER, clusteredLightsSrc))
+        clusteredLightCount = 0;
+    uint32_t sceneFeatures = sceneShaderFeatures();
+    // Deferred: the variants only write the G-buffer, the scene features move to the lighting pass
+    initShaderPermutations(objectShaders, objVertexShaderSrc.c_str(), objFragmentShaderSrc.c_str(),
+                           useDeferred ? 0u : sceneFeatures);
+    if (useShadows)
+        objectShaders.shadowSource = shadowSamplingSource(shadowSamplingSrc);
+    objectShaders.clusterSource = clusteredLightsSrc;
+    precompileVariant(objectShaders, SHADER_TEXTURED, LIGHTING_PHONG);
+    precompileVariant(objectShaders, 0, LIGHTING_PHONG);
+    uint32_t groundVariant = groundVariantKey(objectShaders);
+    unsigned int skyboxShader = createShaderProgram(skyboxVertexShaderSrc.c_str(), skyboxFragmentShaderSrc.c_str());
+    TessellationRenderer tess;
+    if (useTessellation)
+        initTessellationRenderer(tess,
+            variantFragmentSource(objectShaders, shaderVariantKey(objectShaders.sceneFeatures, LIGHTING_PHONG)).c_str(),
+            variantFragmentSource(objectShaders, groundVariant).c_str());
  
     // --------------------- Setup Geometry ---------------------
-    // Cube
-    unsigned int cubeVAO, cubeVBO;
-    glGenVertexArrays(1, &cubeVAO);
-    glGenBuffers(1, &cubeVBO);
-    glBindVertexArray(cubeVAO);
-      glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-      glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), cubeVertices, GL_STATIC_DRAW);
-      glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-      glEnableVertexAttribArray(0);
-      glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-      glEnableVertexAttribArray(1);
-      glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-      glEnableVertexAttribArray(2);
-    glBindVertexArray(0);
- 
-    // Ground
-    unsigned int groundVAO, groundVBO;
-    glGenVertexArrays(1, &groundVAO);
-    glGenBuffers(1, &groundVBO);
-    glBindVertexArray(groundVAO);
-      glBindBuffer(GL_ARRAY_BUFFER, groundVBO);
-      glBufferData(GL_ARRAY_BUFFER, sizeof(groundVertices), groundVertices, GL_STATIC_DRAW);
-      glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-      glEnableVertexAttribArray(0);
-      glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-      glEnableVertexAttribArray(1);
-      glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-      glEnableVertexAttribArray(2);
-    glBindVertexArray(0);
- 
-    // Pyramid
-    unsigned int pyramidVAO, pyramidVBO;
-    glGenVertexArrays(1, &pyramidVAO);
-    glGenBuffers(1, &pyramidVBO);
-    glBindVertexArray(pyramidVAO);
-      glBindBuffer(GL_ARRAY_BUFFER, pyramidVBO);
-      glBufferData(GL_ARRAY_BUFFER, sizeof(pyramidVertices), pyramidVertices, GL_STATIC_DRAW);
-      glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-      glEnableVertexAttribArray(0);
-      glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-      glEnableVertexAttribArray(1);
-      glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-      glEnableVertexAttribArray(2);
-    glBindVertexArray(0);
- 
-    // Sphere (generated)
-    std::vector<float> sphereVerts;
-    std::vector<unsigned int> sphereIndices;
-    generateSphere(sphereVerts, sphereIndices, 0.5f, 32, 16);
-    unsigned int sphereVAO, sphereVBO, sphereEBO;
-    glGenVertexArrays(1, &sphereVAO);
-    glGenBuffers(1, &sphereVBO);
-    glGenBuffers(1, &sphereEBO);
-    glBindVertexArray(sphereVAO);
-      glBindBuffer(GL_ARRAY_BUFFER, sphereVBO);
-      glBufferData(GL_ARRAY_BUFFER, sphereVerts.size() * sizeof(float), &sphereVerts[0], GL_STATIC_DRAW);
-      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphereEBO);
-      glBufferData(GL_ELEMENT_ARRAY_BUFFER, sphereIndices.size() * sizeof(unsigned int), &sphereIndices[0], GL_STATIC_DRAW);
-      glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-      glEnableVertexAttribArray(0);
-      glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-      glEnableVertexAttribArray(1);
-      glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-      glEnableVertexAttribArray(2);
-    glBindVertexArray(0);
- 
-    // Skybox
-    unsigned int skyboxVAO, skyboxVBO;
-    glGenVertexArrays(1, &skyboxVAO);
-    glGenBuffers(1, &skyboxVBO);
-    glBindVertexArray(skyboxVAO);
-      glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
-      glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), skyboxVertices, GL_STATIC_DRAW);
-      glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-      glEnableVertexAttribArray(0);
-    glBindVertexArray(0);
+    // All static meshes share one vertex/index buffer and one VAO
+    MeshBuffer meshBuffer;
+    initMeshBuffer(meshBuffer, 65536, 262144, usePackedVertices);
+    // The built-in arrays are plain triangle lists; they are welded into
+    // indexed meshes and reordered for the vertex cache on the way in
+    MeshHandle cubeMesh    = uploadOptimizedMesh(meshBuffer, cubeVertices, 36, "cube");
+    MeshHandle groundMesh  = uploadOptimizedMesh(meshBuffer, groundVertices, 6, "ground");
+    MeshHandle pyramidMesh = uploadOptimizedMesh(meshBuffer, pyramidVertices, 18, "pyramid");
+    std::vector<float> skyboxMeshVertices = expandPositions(skyboxVertices, 36);
+    MeshHandle skyboxMesh  = uploadOptimizedMesh(meshBuffer, skyboxMeshVertices.data(), 36, "skybox");
  
+    // Procedural meshes are shared through the cache by their parameters
+    MeshCache meshCache;
+
+    // Sphere (generated LOD chain, 64x32 down to 8x4)
+    SphereLodChain sphereLods;
+    buildSphereLodChain(sphereLods, meshCache, meshBuffer, 0.5f);
+
+    // Procedural shape row
+    std::vector<ProceduralMeshDesc> shapeDescs;
+    std::vector<MeshHandle> shapeMeshes;
+    if (showShapes) {
+        shapeDescs = {
+            icosphereDesc(0.5f, 3),
+            torusDesc(0.4f, 0.15f, 48, 24),
+            cylinderDesc(0.4f, 1.0f, 32),
+            coneDesc(0.45f, 1.0f, 32),
+            planeDesc(1.0f, 1.0f, 8, 8),
+            roundedBoxDesc(0.9f, 0.9f, 0.9f, 0.2f, 8),
+            sphereDesc(0.5f, 32, 16)   // same as sphere LOD 1, served from the cache
+        };
+        for (const ProceduralMeshDesc& d : shapeDescs)
+            shapeMeshes.push_back(acquireProceduralMesh(meshCache, meshBuffer, d));
+    }
+    printMeshCacheStats(meshCache);
+
+    // High-poly selected sphere split into meshlets
+    MeshletRenderer meshlets;
+    if (useMeshlets && useTessellation) {
+        std::cout << "--tess refines the sphere on the GPU, ignoring --meshlets\n";
+        useMeshlets = false;
+    }
+    if (useMeshlets) {
+        std::vector<float> vertices;
+        std::vector<unsigned int> indices;
+        generateSphere(vertices, indices, 0.5f, 256, 128);
+        initMeshletRenderer(meshlets, meshBuffer, vertices, indices, "meshlet sphere");
+    }
+
+    // Imported model, scaled to 1.5 units and stood on the ground
+    ImportedModel model;
+    bool hasModel = !modelPath.empty() && loadModel(meshBuffer, modelPath, model);
+    glm::mat4 modelMatrix = hasModel ? modelPlacement(model, glm::vec3(2.5f, 0.0f, 2.0f), 1.5f) : glm::mat4(1.0f);
+
+    // Streamed ground tiles replace the single ground quad
+    GroundStreamer groundStreamer;
+    if (useTerrain && useStreamedGround) {
+        std::cout << "--terrain replaces the ground, ignoring --streamed-ground\n";
+        useStreamedGround = false;
+    }
+    if (useStreamedGround)
+        initGroundStreamer(groundStreamer, meshBuffer);
+    TerrainRenderer terrain;
+    if (useTerrain)
+        initTerrainRenderer(terrain, meshBuffer, variantFragmentSource(objectShaders, groundVariant).c_str());
+    int sphereLod = -1;
+    std::cout << "Mesh buffer: " << meshBuffer.meshCount << " meshes, " << meshBuffer.vertices.used << " vertices, "
+              << meshBufferBytesUsed(meshBuffer) / 1024 << " KB (" << meshVertexStride(meshBuffer) << " bytes/vertex)" << std::endl;
+ 
+    // Sphere field: a square grid of extra spheres for measuring the LOD system
+    std::vector<glm::vec3> sphereFieldPos;
+    std::vector<int> sphereFieldLod(sphereFieldCount, -1);
+    int fieldSide = (int)std::ceil(std::sqrt((float)sphereFieldCount));
+    for (int i = 0; i < sphereFieldCount; ++i) {
+        float spacing = 1.5f;
+        float x = (i % fieldSide - fieldSide * 0.5f) * spacing;
+        float z = (i / fieldSide) * -spacing - 4.0f;
+        sphereFieldPos.push_back(glm::vec3(x, 0.5f, z));
+    }
+    long long lodTrianglesSubmitted = 0;
+    long long lodTrianglesFullDetail = 0;
+    int lodFrames = 0;
+    float lodReportTime = 0.0f;
+ 
+    pollProgramBatch(programCache);
+
     // --------------------- Load Textures ---------------------
     unsigned int cubeTexture   = loadTexture("textures/texture.jpg");
     unsigned int groundTexture = loadTexture("textures/stone-texture.jpg");
@@ -692,8 +1011,98 @@ int main() {
         "skybox/posz.jpg",
         "skybox/negz.jpg"
     };
+    // Image-based lighting is read from its cache or baked on a worker meanwhile
+    EnvironmentJob environmentJob;
+    if (useIBL)
+        startEnvironmentLighting(environmentJob, faces);
     unsigned int cubemapTexture = loadCubemap(faces);
+    pollProgramBatch(programCache);
+
+    // --------------------- Materials ---------------------
+    Material groundMaterial;
+    groundMaterial.texture = groundTexture;
+    groundMaterial.lighting = LIGHTING_LAMBERT;
+    Material cubeMaterial;
+    cubeMaterial.texture = cubeTexture;
+    Material pyramidMaterial;
+    pyramidMaterial.color = glm::vec3(0.53f, 0.81f, 0.92f);
+    pyramidMaterial.lighting = LIGHTING_BLINN_PHONG;
+    Material sphereMaterial;
+    sphereMaterial.color = glm::vec3(0.8f, 0.4f, 0.2f);
+    Material modelMaterial;
+    modelMaterial.color = glm::vec3(0.75f);
  
+    // --------------------- Occlusion Culling ---------------------
+    // Object ids: 0 = cube, 1 = pyramid, 2 = sphere. The ground is the main
+    // occluder and the skybox is drawn behind everything, so neither is tested.
+    int fbWidth, fbHeight;
+    glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+    HiZCuller hiz;
+    if (useHiZCulling)
+        initHiZCuller(hiz, fbWidth, fbHeight);
+    std::vector<HiZBounds> cullBounds;
+    float cullReportTime = 0.0f;
+
+    DeferredRenderer deferred;
+    if (useDeferred)
+        initDeferredRenderer(deferred, fullscreenVertexSrc.c_str(),
+                             deferredLightingSource(objectShaders, deferredLightingSrc.c_str(), sceneFeatures).c_str(),
+                             fbWidth, fbHeight);
+
+    // Shadow cascades cover the first 40 units in front of the camera (400 over the terrain)
+    if (useShadows)
+        initShadowMaps(shadowMaps, shadowDepthVertexSrc.c_str(), shadowDepthFragmentSrc.c_str(), meshBuffer.vao,
+                       LIGHT_DIRECTION, useTerrain ? 400.0f : 40.0f);
+    std::vector<ShadowCaster> shadowCasters;
+
+    // Far plane of the projection; the clusters and the draw sort depth span the same range
+    float farPlane = useTerrain ? TERRAIN_FAR_PLANE : 100.0f;
+    if (clusteredLightCount > 0)
+        initClusteredLighting(clusteredLights, clusteredLightCount, 0.1f, farPlane);
+
+    IndirectRenderer indirect;
+    if (useIndirectDraw) {
+        initIndirectRenderer(indirect, objectShaders);
+        if (!indirect.multiDrawIndirect)
+            std::cout << "Multi-draw indirect unavailable, batching repeated meshes with instanced draws\n";
+    }
+    endProgramBatch(programCache);
+    printProgramCacheStats(programCache);
+    if (useIBL)
+        finishEnvironmentLighting(environmentJob, environment);
+
+    ShaderWatcher shaderWatcher;
+    if (useHotReload)
+        useHotReload = startShaderWatcher(shaderWatcher, window, hotReloadShaderFiles());
+ 
+    // The skybox is drawn last, at the far plane: it passes with LEQUAL only
+    // where nothing else was drawn, so covered pixels are rejected before
+    // shading, and it has no depth worth writing. The fullscreen triangle has
+    // no vertex attributes but core profiles still need a VAO bound to draw.
+    unsigned int skyTriangleVAO = 0;
+    if (useSkyTriangle)
+        glGenVertexArrays(1, &skyTriangleVAO);
+    PipelineState skyboxPipeline;
+    skyboxPipeline.program = skyboxShader;
+    skyboxPipeline.vao = useSkyTriangle ? skyTriangleVAO : meshBuffer.vao;
+    skyboxPipeline.depthFunc = GL_LEQUAL;
+    skyboxPipeline.depthWrite = false;
+
+    RenderQueue renderQueue;
+    long long queueDrawCalls = 0;
+    long long queueStateIssued = 0;
+    long long queueStateEliminated = 0;
+    int queueFrames = 0;
+    float queueReportTime = 0.0f;
+    long long glStateIssued = 0;
+    long long glStateAvoided = 0;
+    long long shadowStaticDraws = 0;
+    long long shadowDynamicDraws = 0;
+    int shadowStaticRenders = 0;
+    double clusterAssignMs = 0.0;
+    long long clusterIndices = 0;
+    int clusterMaxPerCluster = 0;
+
     // --------------------- Render Loop ---------------------
     while (!glfwWindowShouldClose(window)) {
         float currentTime = (float)glfwGetTime();
@@ -701,122 +1110,355 @@ int main() {
         lastFrame = currentTime;
  
         processInput(window);
+        updateShaderPermutations(objectShaders);
+        if (useHotReload) {
+            queueShaderReloads(shaderWatcher, objectShaders, indirect);
+            ShaderReloadJob reload;
+            while (takeFinishedShaderReload(shaderWatcher, reload))
+                if (applyShaderReload(reload, objectShaders, objVertexShaderSrc, objFragmentShaderSrc, skyboxShader,
+                                      tess, terrain, indirect, deferred)) {
+                    renderQueue.programs.clear();   // program names may be reused; drop cached locations
+                    skyboxPipeline.program = skyboxShader;
+                }
+        }
+ 
+        glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+        if (useHiZCulling) {
+            resizeHiZCuller(hiz, fbWidth, fbHeight);
+            beginHiZFrame(hiz);
+        }
  
+        beginGLStateFrame();
         glClearColor(0.1f, 0.12f, 0.15f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        if (useDeferred) {
+            resizeDeferredRenderer(deferred, fbWidth, fbHeight);
+            beginGeometryPass(deferred);
+        }
  
         // Setup view and projection matrices
         glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-        glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH/(float)SCR_HEIGHT, 0.1f, 100.0f);
- 
-        // Use object shader for ground, cube, pyramid, sphere
-        glUseProgram(objShader);
-        glUniformMatrix4fv(glGetUniformLocation(objShader, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(glGetUniformLocation(objShader, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        glUniform3fv(glGetUniformLocation(objShader, "lightDir"), 1, glm::value_ptr(glm::vec3(-0.2f, -1.0f, -0.3f)));
-        glUniform3fv(glGetUniformLocation(objShader, "lightColor"), 1, glm::value_ptr(glm::vec3(1.0f)));
-        glUniform3fv(glGetUniformLocation(objShader, "viewPos"), 1, glm::value_ptr(cameraPos));
- 
-        // --- Draw Ground ---
-        {
-            glm::mat4 model = glm::mat4(1.0f);
-            glUniformMatrix4fv(glGetUniformLocation(objShader, "model"), 1, GL_FALSE, glm::value_ptr(model));
-            glUniform1i(glGetUniformLocation(objShader, "useTexture"), true);
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, groundTexture);
-            glUniform1i(glGetUniformLocation(objShader, "texture1"), 0);
-            glBindVertexArray(groundVAO);
-            glDrawArrays(GL_TRIANGLES, 0, 6);
-            glBindVertexArray(0);
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH/(float)SCR_HEIGHT, 0.1f, farPlane);
+ 
+        // Auto-rotate pyramid if enabled
+        if (pyramidAutoRotate) {
+            pyramidRotX += glm::radians(30.0f) * deltaTime;
+        }
+ 
+        // Object model matrices (needed up front for the culling bounds)
+        glm::mat4 cubeModel = glm::mat4(1.0f);
+        // Apply translation, then rotation about Y, then rotation about X, then scale.
+        cubeModel = glm::translate(cubeModel, cubePos);
+        cubeModel = glm::rotate(cubeModel, cubeRotY, glm::vec3(0.0f, 1.0f, 0.0f));
+        cubeModel = glm::rotate(cubeModel, cubeRotX, glm::vec3(1.0f, 0.0f, 0.0f));
+        cubeModel = glm::scale(cubeModel, glm::vec3(cubeScale));
+ 
+        glm::mat4 pyramidModel = glm::mat4(1.0f);
+        pyramidModel = glm::translate(pyramidModel, pyramidPos);
+        pyramidModel = glm::rotate(pyramidModel, pyramidRotY, glm::vec3(0.0f, 1.0f, 0.0f));
+        pyramidModel = glm::rotate(pyramidModel, pyramidRotX, glm::vec3(1.0f, 0.0f, 0.0f));
+        pyramidModel = glm::rotate(pyramidModel, pyramidRotZ, glm::vec3(0.0f, 0.0f, 1.0f));
+        pyramidModel = glm::scale(pyramidModel, glm::vec3(pyramidScale));
+ 
+        glm::mat4 sphereModel = glm::mat4(1.0f);
+        sphereModel = glm::translate(sphereModel, spherePos);
+        sphereModel = glm::rotate(sphereModel, sphereRotY, glm::vec3(0.0f, 1.0f, 0.0f));
+        sphereModel = glm::rotate(sphereModel, sphereRotX, glm::vec3(1.0f, 0.0f, 0.0f));
+        sphereModel = glm::scale(sphereModel, glm::vec3(sphereScale));
+ 
+        cullBounds.clear();
+        cullBounds.push_back(transformBounds(cubeModel, glm::vec3(-0.5f), glm::vec3(0.5f)));
+        cullBounds.push_back(transformBounds(pyramidModel, glm::vec3(-0.5f, 0.0f, -0.5f), glm::vec3(0.5f, 1.0f, 0.5f)));
+        cullBounds.push_back(transformBounds(sphereModel, glm::vec3(-0.5f), glm::vec3(0.5f)));
+        for (int i = 0; i < sphereFieldCount; ++i)
+            cullBounds.push_back({ sphereFieldPos[i] - glm::vec3(0.5f), sphereFieldPos[i] + glm::vec3(0.5f) });
+
+        // --- Shadow maps: cached static depth, redrawn for moving casters or a moved camera ---
+        if (useShadows) {
+            shadowCasters.clear();
+            shadowCasters.push_back(makeShadowCaster(cubeMesh, cubeModel, glm::vec3(-0.5f), glm::vec3(0.5f)));
+            shadowCasters.push_back(makeShadowCaster(pyramidMesh, pyramidModel, glm::vec3(-0.5f, 0.0f, -0.5f),
+                                                     glm::vec3(0.5f, 1.0f, 0.5f)));
+            // Spheres cast at a fixed LOD, whichever way they are drawn
+            const MeshHandle& sphereCaster = sphereLods.levels[1];
+            shadowCasters.push_back(makeShadowCaster(sphereCaster, sphereModel, glm::vec3(-0.5f), glm::vec3(0.5f)));
+            for (int i = 0; i < sphereFieldCount; ++i)
+                shadowCasters.push_back(makeShadowCaster(sphereCaster, glm::translate(glm::mat4(1.0f), sphereFieldPos[i]),
+                                                         glm::vec3(-0.5f), glm::vec3(0.5f)));
+            for (size_t i = 0; i < shapeMeshes.size(); ++i)
+                shadowCasters.push_back(makeShadowCaster(shapeMeshes[i], glm::translate(glm::mat4(1.0f), shapePosition(i)),
+                                                         glm::vec3(-0.5f), glm::vec3(0.5f)));
+            if (hasModel)
+                shadowCasters.push_back(makeShadowCaster(model.mesh, modelMatrix, model.boundsMin, model.boundsMax));
+            renderShadowMaps(shadowMaps, shadowCasters, view, glm::radians(45.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f);
         }
  
-        // --- Draw Cube ---
-        {
-            glm::mat4 model = glm::mat4(1.0f);
-            // Apply translation, then rotation about Y, then rotation about X, then scale.
-            model = glm::translate(model, cubePos);
-            model = glm::rotate(model, cubeRotY, glm::vec3(0.0f, 1.0f, 0.0f));
-            model = glm::rotate(model, cubeRotX, glm::vec3(1.0f, 0.0f, 0.0f));
-            model = glm::scale(model, glm::vec3(cubeScale));
-            glUniformMatrix4fv(glGetUniformLocation(objShader, "model"), 1, GL_FALSE, glm::value_ptr(model));
-            glUniform1i(glGetUniformLocation(objShader, "useTexture"), true);
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, cubeTexture);
-            glUniform1i(glGetUniformLocation(objShader, "texture1"), 0);
-            glBindVertexArray(cubeVAO);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
-            glBindVertexArray(0);
+        // --- Queue opaque draws (ground, cube, pyramid, spheres) ---
+        // Sorted by program/texture/VAO and then front to back before submission
+        beginRenderQueue(renderQueue);
+        if (useTerrain) {
+            // Drawn after the queue with its own shader
+        } else if (useStreamedGround) {
+            updateGroundStreamer(groundStreamer, meshBuffer, cameraPos);
+            for (const GroundTile& tile : groundStreamer.resident) {
+                glm::vec3 center = groundTileCenter(tile.coord);
+                DrawCommand ground;
+                if (!setDrawMaterial(ground, objectShaders, groundMaterial))
+                    break;
+                setDrawMesh(ground, meshBuffer, tile.mesh);
+                ground.model = glm::translate(glm::mat4(1.0f), center);
+                ground.depth = glm::distance(cameraPos, center);
+                pushDraw(renderQueue, ground);
+            }
+        } else {
+            DrawCommand ground;
+            if (useTessellation) {
+                ground.program = tess.groundProgram;
+                ground.texture = groundTexture;
+                ground.vao = tess.groundVAO;
+                ground.mode = GL_PATCHES;
+                ground.count = tess.groundVertexCount;
+            } else {
+                setDrawMaterial(ground, objectShaders, groundMaterial);
+                setDrawMesh(ground, meshBuffer, groundMesh);
+            }
+            ground.depth = glm::abs(cameraPos.y); // nearest point of the plane
+            if (ground.program)
+                pushDraw(renderQueue, ground);
         }
  
-        // --- Draw Pyramid (sky blue color with auto/manual rotation) ---
-        {
-            // Auto-rotate if enabled
-            if (pyramidAutoRotate) {
-                pyramidRotX += glm::radians(30.0f) * deltaTime;
+        // --- Cube ---
+        DrawCommand cube;
+        if ((!useHiZCulling || isHiZVisible(hiz, 0)) && setDrawMaterial(cube, objectShaders, cubeMaterial)) {
+            setDrawMesh(cube, meshBuffer, cubeMesh);
+            cube.model = cubeModel;
+            cube.depth = glm::distance(cameraPos, cubePos);
+            pushDraw(renderQueue, cube);
+        }
+ 
+        // --- Pyramid (sky blue color with auto/manual rotation) ---
+        DrawCommand pyramid;
+        if ((!useHiZCulling || isHiZVisible(hiz, 1)) && setDrawMaterial(pyramid, objectShaders, pyramidMaterial)) {
+            setDrawMesh(pyramid, meshBuffer, pyramidMesh);
+            pyramid.model = pyramidModel;
+            pyramid.depth = glm::distance(cameraPos, pyramidPos);
+            pushDraw(renderQueue, pyramid);
+        }
+ 
+        // --- Spheres (solid color): the selected sphere plus the optional field ---
+        // Tessellated spheres are refined on the GPU; otherwise each instance
+        // picks a discrete LOD from its projected size.
+        for (int i = -1; i < sphereFieldCount; ++i) {
+            bool inField = i >= 0;
+            if (useHiZCulling && !isHiZVisible(hiz, inField ? 3 + i : 2))
+                continue;
+            DrawCommand sphere;
+            if (!setDrawMaterial(sphere, objectShaders, sphereMaterial))
+                continue;
+            sphere.model = inField ? glm::translate(glm::mat4(1.0f), sphereFieldPos[i]) : sphereModel;
+            sphere.depth = glm::distance(cameraPos, inField ? sphereFieldPos[i] : spherePos);
+            if (useTessellation) {
+                sphere.program = tess.sphereProgram;
+                sphere.vao = tess.sphereVAO;
+                sphere.mode = GL_PATCHES;
+                sphere.count = tess.sphereVertexCount;
+            } else if (useMeshlets && !inField) {
+                sphere.vao = meshlets.vao;
+                sphere.indexed = true;
+                sphere.count = updateMeshletRenderer(meshlets, meshBuffer, projection * view, sphere.model, cameraPos);
+                sphere.baseVertex = meshlets.handle.baseVertex;
+                if (sphere.count == 0)
+                    continue;
+            } else {
+                int& lod = inField ? sphereFieldLod[i] : sphereLod;
+                float radius = sphereLods.radius * (inField ? 1.0f : sphereScale);
+                float size = projectedSphereDiameter(radius, sphere.depth, projection[1][1], fbHeight);
+                lod = useSphereLod ? selectSphereLod(size, lod) : 0;
+                setDrawMesh(sphere, meshBuffer, sphereLods.levels[lod]);
+                lodTrianglesSubmitted  += sphereLods.levels[lod].indexCount / 3;
+                lodTrianglesFullDetail += sphereLods.levels[0].indexCount / 3;
             }
+            pushDraw(renderQueue, sphere);
+        }
  
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, pyramidPos);
-            model = glm::rotate(model, pyramidRotY, glm::vec3(0.0f, 1.0f, 0.0f));
-            model = glm::rotate(model, pyramidRotX, glm::vec3(1.0f, 0.0f, 0.0f));
-            model = glm::rotate(model, pyramidRotZ, glm::vec3(0.0f, 0.0f, 1.0f));
-            model = glm::scale(model, glm::vec3(pyramidScale));
-            glUniformMatrix4fv(glGetUniformLocation(objShader, "model"), 1, GL_FALSE, glm::value_ptr(model));
-            glUniform1i(glGetUniformLocation(objShader, "useTexture"), false);
-            // Set sky blue color
-            glUniform3f(glGetUniformLocation(objShader, "objectColor"), 0.53f, 0.81f, 0.92f);
-            glBindVertexArray(pyramidVAO);
-            glDrawArrays(GL_TRIANGLES, 0, 18);
-            glBindVertexArray(0);
+        // --- Procedural shapes (not occlusion-culled) ---
+        for (size_t i = 0; i < shapeMeshes.size(); ++i) {
+            glm::vec3 pos = shapePosition(i);
+            Material shapeMaterial;
+            shapeMaterial.color = glm::vec3(0.3f + 0.1f * i, 0.7f, 0.5f);
+            DrawCommand shape;
+            if (!setDrawMaterial(shape, objectShaders, shapeMaterial))
+                continue;
+            setDrawMesh(shape, meshBuffer, shapeMeshes[i]);
+            shape.model = glm::translate(glm::mat4(1.0f), pos);
+            shape.depth = glm::distance(cameraPos, pos);
+            pushDraw(renderQueue, shape);
+        }
+
+        // --- Imported model ---
+        DrawCommand imported;
+        if (hasModel && setDrawMaterial(imported, objectShaders, modelMaterial)) {
+            setDrawMesh(imported, meshBuffer, model.mesh);
+            imported.model = modelMatrix;
+            imported.depth = glm::distance(cameraPos, glm::vec3(modelMatrix[3]));
+            pushDraw(renderQueue, imported);
+        }
+
+        // Point and spot lights: move, assign to clusters, upload before any uniforms are set
+        if (clusteredLightCount > 0)
+            updateClusteredLighting(clusteredLights, currentTime, view, projection, fbWidth, fbHeight);
+
+        // Camera and light for every built variant, including any the draws above just loaded
+        if (useTessellation) {
+            setFrameUniforms(tess.groundProgram, view, projection);
+            setTessellationUniforms(tess.groundProgram, (float)fbHeight);
+            setFrameUniforms(tess.sphereProgram, view, projection);
+            setTessellationUniforms(tess.sphereProgram, (float)fbHeight);
+            glUniform1f(glGetUniformLocation(tess.sphereProgram, "radius"), sphereLods.radius);
+        }
+        for (const ShaderVariant& v : objectShaders.variants)
+            if (v.ready)
+                setFrameUniforms(v.program, view, projection);
+        if (useIndirectDraw) {
+            updateIndirectPrograms(indirect);
+            for (const IndirectProgram& p : indirect.programs)
+                setFrameUniforms(p.program, view, projection);
+            flushRenderQueueIndirect(renderQueue, indirect, meshBuffer, farPlane);
+        } else {
+            flushRenderQueue(renderQueue, farPlane);
+        }
+
+        // --- Terrain ---
+        if (useTerrain) {
+            selectTerrainNodes(terrain, projection * view, cameraPos);
+            setFrameUniforms(terrain.program, view, projection);
+            drawTerrain(terrain, groundTexture);
+        }
+ 
+        // --- Draw Skybox (the deferred lighting pass shades the sky itself) ---
+        if (useDeferred) {
+            setFrameUniforms(deferred.program, view, projection);
+            shadeDeferred(deferred, view, projection, cubemapTexture);
+        } else {
+            bindPipeline(skyboxPipeline);
+            glm::mat4 skyboxView = glm::mat4(glm::mat3(view));
+            bindTexture(0, GL_TEXTURE_CUBE_MAP, cubemapTexture);
+            glUniform1i(glGetUniformLocation(skyboxShader, "skybox"), 0);
+            if (useSkyTriangle) {
+                glm::mat4 inverseViewProjection = glm::inverse(projection * skyboxView);
+                glUniformMatrix4fv(glGetUniformLocation(skyboxShader, "inverseViewProjection"), 1, GL_FALSE,
+                                   glm::value_ptr(inverseViewProjection));
+                glDrawArrays(GL_TRIANGLES, 0, 3);
+            } else {
+                glUniformMatrix4fv(glGetUniformLocation(skyboxShader, "view"), 1, GL_FALSE, glm::value_ptr(skyboxView));
+                glUniformMatrix4fv(glGetUniformLocation(skyboxShader, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+                drawMesh(skyboxMesh);
+            }
         }
  
-        // --- Draw Sphere (solid color) ---
-        {
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, spherePos);
-            model = glm::rotate(model, sphereRotY, glm::vec3(0.0f, 1.0f, 0.0f));
-            model = glm::rotate(model, sphereRotX, glm::vec3(1.0f, 0.0f, 0.0f));
-            model = glm::scale(model, glm::vec3(sphereScale));
-            glUniformMatrix4fv(glGetUniformLocation(objShader, "model"), 1, GL_FALSE, glm::value_ptr(model));
-            glUniform1i(glGetUniformLocation(objShader, "useTexture"), false);
-            glUniform3f(glGetUniformLocation(objShader, "objectColor"), 0.8f, 0.4f, 0.2f);
-            glBindVertexArray(sphereVAO);
-            glDrawElements(GL_TRIANGLES, (GLsizei)sphereIndices.size(), GL_UNSIGNED_INT, 0);
-            glBindVertexArray(0);
+        // Build the depth pyramid, test this frame's bounds and present
+        if (useHiZCulling) {
+            endHiZFrame(hiz, projection * view, cullBounds, fbWidth, fbHeight);
+            if (currentTime - cullReportTime > 1.0f) {
+                std::cout << "Hi-Z: " << hiz.culledCount << " / " << cullBounds.size() << " objects culled" << std::endl;
+                cullReportTime = currentTime;
+            }
         }
  
-        // --- Draw Skybox ---
-        glDepthFunc(GL_LEQUAL);
-        glUseProgram(skyboxShader);
-        glm::mat4 skyboxView = glm::mat4(glm::mat3(view));
-        glUniformMatrix4fv(glGetUniformLocation(skyboxShader, "view"), 1, GL_FALSE, glm::value_ptr(skyboxView));
-        glUniformMatrix4fv(glGetUniformLocation(skyboxShader, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        glBindVertexArray(skyboxVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
-        glUniform1i(glGetUniformLocation(skyboxShader, "skybox"), 0);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        glBindVertexArray(0);
-        glDepthFunc(GL_LESS);
+        // Render queue report: GL draw calls and state changes issued vs. eliminated by sorting/filtering
+        queueDrawCalls += renderQueue.stats.drawCalls;
+        queueStateIssued += renderQueue.stats.stateIssued;
+        queueStateEliminated += stateChangesEliminated(renderQueue.stats);
+        glStateIssued += glState.stats.issued;
+        glStateAvoided += glState.stats.avoided;
+        shadowStaticDraws += shadowMaps.stats.staticDraws;
+        shadowDynamicDraws += shadowMaps.stats.dynamicDraws;
+        shadowStaticRenders += shadowMaps.stats.staticRenders;
+        clusterAssignMs += clusteredLights.stats.assignMs;
+        clusterIndices += clusteredLights.stats.indices;
+        clusterMaxPerCluster = std::max(clusterMaxPerCluster, clusteredLights.stats.maxPerCluster);
+        queueFrames++;
+        if (currentTime - queueReportTime > 5.0f) {
+            std::cout << "Render queue: " << renderQueue.stats.draws << " draws in "
+                      << queueDrawCalls / queueFrames << " draw calls/frame, "
+                      << queueStateIssued / queueFrames << " state changes/frame issued, "
+                      << queueStateEliminated / queueFrames << " eliminated" << std::endl;
+            std::cout << "GL state: " << glStateIssued / queueFrames << " calls/frame issued, "
+                      << glStateAvoided / queueFrames << " redundant calls/frame avoided" << std::endl;
+            queueDrawCalls = queueStateIssued = queueStateEliminated = 0;
+            glStateIssued = glStateAvoided = 0;
+            if (useShadows)
+                std::cout << "Shadows: " << shadowStaticRenders << " static cascade renders in " << queueFrames
+                          << " frames, " << shadowStaticDraws / queueFrames << " static + "
+                          << shadowDynamicDraws / queueFrames << " dynamic caster draws/frame" << std::endl;
+            shadowStaticDraws = shadowDynamicDraws = 0;
+            shadowStaticRenders = 0;
+            if (clusteredLightCount > 0)
+                std::cout << "Clustered lights: " << clusteredLights.lights.size() << " lights ("
+                          << clusteredLights.stats.visibleLights << " in view), " << clusterAssignMs / queueFrames
+                          << " ms/frame assigning, " << (double)clusterIndices / queueFrames / CLUSTER_COUNT
+                          << " lights/cluster on average, " << clusterMaxPerCluster << " at most" << std::endl;
+            clusterAssignMs = 0.0;
+            clusterIndices = 0;
+            clusterMaxPerCluster = 0;
+            if (useStreamedGround)
+                printGroundStreamerStats(groundStreamer);
+            if (useTerrain)
+                printTerrainStats(terrain);
+            if (useMeshlets)
+                printMeshletStats(meshlets.stats);
+            queueFrames = 0;
+            queueReportTime = currentTime;
+        }
+ 
+        // Sphere LOD report: frame time and triangles submitted, averaged over ~1s
+        lodFrames++;
+        if (sphereFieldCount > 0 && currentTime - lodReportTime > 1.0f) {
+            std::cout << "Sphere LOD: " << (currentTime - lodReportTime) * 1000.0f / lodFrames << " ms/frame, "
+                      << lodTrianglesSubmitted / lodFrames << " triangles/frame ("
+                      << lodTrianglesFullDetail / lodFrames << " at full detail)" << std::endl;
+            lodTrianglesSubmitted = lodTrianglesFullDetail = 0;
+            lodFrames = 0;
+            lodReportTime = currentTime;
+        }
  
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
  
     // --------------------- Cleanup ---------------------
-    glDeleteVertexArrays(1, &cubeVAO);
-    glDeleteBuffers(1, &cubeVBO);
-    glDeleteVertexArrays(1, &groundVAO);
-    glDeleteBuffers(1, &groundVBO);
-    glDeleteVertexArrays(1, &pyramidVAO);
-    glDeleteBuffers(1, &pyramidVBO);
-    glDeleteVertexArrays(1, &sphereVAO);
-    glDeleteBuffers(1, &sphereVBO);
-    glDeleteBuffers(1, &sphereEBO);
-    glDeleteVertexArrays(1, &skyboxVAO);
-    glDeleteBuffers(1, &skyboxVBO);
-    glDeleteProgram(objShader);
+    if (useHotReload)
+        stopShaderWatcher(shaderWatcher);
+    if (useStreamedGround)
+        destroyGroundStreamer(groundStreamer, meshBuffer);
+    if (useTerrain)
+        destroyTerrainRenderer(terrain, meshBuffer);
+    for (const ProceduralMeshDesc& d : shapeDescs)
+        releaseProceduralMesh(meshCache, meshBuffer, d);
+    if (hasModel)
+        releaseMesh(meshBuffer, model.mesh);
+    if (useMeshlets)
+        destroyMeshletRenderer(meshlets, meshBuffer);
+    releaseSphereLodChain(sphereLods, meshCache, meshBuffer);
+    destroyMeshBuffer(meshBuffer);
+    if (useTessellation)
+        destroyTessellationRenderer(tess);
+    if (useIndirectDraw)
+        destroyIndirectRenderer(indirect);
+    destroyShaderPermutations(objectShaders);
     glDeleteProgram(skyboxShader);
+    if (useIBL)
+        destroyEnvironmentLighting(environment);
+    if (useShadows)
+        destroyShadowMaps(shadowMaps);
+    if (clusteredLightCount > 0)
+        destroyClusteredLighting(clusteredLights);
+    if (useDeferred)
+        destroyDeferredRenderer(deferred);
+    if (useSkyTriangle)
+        glDeleteVertexArrays(1, &skyTriangleVAO);
+    if (useHiZCulling)
+        destroyHiZCuller(hiz);
  
     glfwTerminate();
     return 0;
@@ -0,0 +1,252 @@
+#ifndef MESH_BUFFER_H
+#define MESH_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <vector>
+#include <algorithm>
+
+#include "vertex_packing.h"
+#include "pipeline_state.h"
+
+// --------------------- Shared Mesh Buffer ---------------------
+// Every static mesh lives in one vertex buffer and one index buffer behind a
+// single VAO. Meshes keep 0-based indices and are drawn with
+// glDrawElementsBaseVertex, so drawing another mesh never rebinds a VAO.
+// Both buffers are carved up by a first-fit range allocator; freed ranges are
+// merged with their neighbours, and a full buffer is grown by copying into a
+// larger one on the GPU (existing ranges keep their offsets).
+// Meshes are always supplied in the 8-float layout; a buffer created with
+// packed = true converts them to the 16-byte PackedVertex format on upload.
+
+const int MESH_VERTEX_FLOATS = 8;   // position (3), normal (3), texcoord (2)
+const int MESH_VERTEX_STRIDE = MESH_VERTEX_FLOATS * sizeof(float);
+
+struct MeshRange {
+    unsigned int offset;
+    unsigned int count;
+};
+
+struct RangeAllocator {
+    unsigned int capacity = 0;
+    unsigned int used = 0;
+    std::vector<MeshRange> freeRanges;   // sorted by offset, never adjacent
+};
+
+// Location of one mesh inside the shared buffers
+struct MeshHandle {
+    GLint        baseVertex = 0;
+    unsigned int vertexCount = 0;
+    unsigned int firstIndex = 0;
+    GLsizei      indexCount = 0;
+
+    size_t indexOffset() const { return firstIndex * sizeof(unsigned int); }
+};
+
+struct MeshBuffer {
+    unsigned int vao = 0, vbo = 0, ebo = 0;
+    bool packed = false;           // PackedVertex storage instead of 8 floats
+    RangeAllocator vertices;
+    RangeAllocator indices;
+    int meshCount = 0;
+    // Bumped whenever vbo/ebo are replaced by a grow. Other VAOs that draw
+    // from the buffers compare it rather than the GL names, which the driver
+    // is free to hand out again once the old buffers are deleted.
+    unsigned int generation = 1;
+};
+
+// --------------------- Range Allocator ---------------------
+inline void freeRange(RangeAllocator& a, unsigned int offset, unsigned int count) {
+    if (count == 0)
+        return;
+    auto it = std::lower_bound(a.freeRanges.begin(), a.freeRanges.end(), offset,
+                               [](const MeshRange& r, unsigned int o) { return r.offset < o; });
+    it = a.freeRanges.insert(it, MeshRange{ offset, count });
+    a.used -= count;
+
+    // Merge with the following range, then with the preceding one
+    auto next = it + 1;
+    if (next != a.freeRanges.end() && it->offset + it->count == next->offset) {
+        it->count += next->count;
+        it = a.freeRanges.erase(next) - 1;
+    }
+    if (it != a.freeRanges.begin()) {
+        auto prev = it - 1;
+        if (prev->offset + prev->count == it->offset) {
+            prev->count += it->count;
+            a.freeRanges.erase(it);
+        }
+    }
+}
+
+inline bool allocateRange(RangeAllocator& a, unsigned int count, unsigned int& offset) {
+    if (count == 0) {
+        offset = 0;
+        return true;
+    }
+    for (size_t i = 0; i < a.freeRanges.size(); ++i) {
+        MeshRange& r = a.freeRanges[i];
+        if (r.count < count)
+            continue;
+        offset = r.offset;
+        r.offset += count;
+        r.count -= count;
+        if (r.count == 0)
+            a.freeRanges.erase(a.freeRanges.begin() + i);
+        a.used += count;
+        return true;
+    }
+    return false;
+}
+
+// Extend the allocator to newCapacity; the new space becomes one free range
+inline void growRange(RangeAllocator& a, unsigned int newCapacity) {
+    unsigned int added = newCapacity - a.capacity;
+    unsigned int oldCapacity = a.capacity;
+    a.capacity = newCapacity;
+    a.used += added;   // freeRange() subtracts it again
+    freeRange(a, oldCapacity, added);
+}
+
+// --------------------- Mesh Buffer ---------------------
+inline int meshVertexStride(const MeshBuffer& mb) {
+    return mb.packed ? PACKED_VERTEX_STRIDE : MESH_VERTEX_STRIDE;
+}
+
+// Attributes 0-2 of the bound VAO from the shared buffers. Other VAOs that
+// draw from the mesh buffer (with extra attributes) use this too.
+inline void bindMeshBufferAttribs(const MeshBuffer& mb) {
+    glBindBuffer(GL_ARRAY_BUFFER, mb.vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mb.ebo);
+    if (mb.packed) {
+        setPackedVertexAttribs();
+        return;
+    }
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, MESH_VERTEX_STRIDE, (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, MESH_VERTEX_STRIDE, (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, MESH_VERTEX_STRIDE, (void*)(6 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+}
+
+inline void setupMeshBufferVAO(MeshBuffer& mb) {
+    bindVertexArray(mb.vao);
+    bindMeshBufferAttribs(mb);
+}
+
+// Replace `buffer` with a larger copy. The copy targets keep the VAO's
+// element binding untouched.
+inline void growGLBuffer(unsigned int& buffer, size_t oldBytes, size_t newBytes) {
+    unsigned int grown;
+    glGenBuffers(1, &grown);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+    glBufferData(GL_COPY_WRITE_BUFFER, newBytes, nullptr, GL_STATIC_DRAW);
+    if (oldBytes > 0) {
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldBytes);
+    }
+    glDeleteBuffers(1, &buffer);
+    buffer = grown;
+}
+
+inline void initMeshBuffer(MeshBuffer& mb, unsigned int vertexCapacity, unsigned int indexCapacity, bool packed = false) {
+    mb.packed = packed;
+    glGenVertexArrays(1, &mb.vao);
+    glGenBuffers(1, &mb.vbo);
+    glGenBuffers(1, &mb.ebo);
+    growGLBuffer(mb.vbo, 0, (size_t)vertexCapacity * meshVertexStride(mb));
+    growGLBuffer(mb.ebo, 0, (size_t)indexCapacity * sizeof(unsigned int));
+    growRange(mb.vertices, vertexCapacity);
+    growRange(mb.indices, indexCapacity);
+    setupMeshBufferVAO(mb);
+}
+
+// Place a mesh in the shared buffers, doubling them if it doesn't fit.
+// `vertices` uses the 8-float layout; indices are relative to the mesh.
+inline MeshHandle uploadMesh(MeshBuffer& mb, const float* vertices, unsigned int vertexCount,
+                             const unsigned int* indices, unsigned int indexCount) {
+    MeshHandle h;
+    size_t stride = (size_t)meshVertexStride(mb);
+    unsigned int vertexOffset, indexOffset;
+    bool grew = false;
+    while (!allocateRange(mb.vertices, vertexCount, vertexOffset)) {
+        unsigned int capacity = std::max(mb.vertices.capacity * 2, mb.vertices.capacity + vertexCount);
+        growGLBuffer(mb.vbo, (size_t)mb.vertices.capacity * stride, (size_t)capacity * stride);
+        growRange(mb.vertices, capacity);
+        grew = true;
+    }
+    while (!allocateRange(mb.indices, indexCount, indexOffset)) {
+        unsigned int capacity = std::max(mb.indices.capacity * 2, mb.indices.capacity + indexCount);
+        growGLBuffer(mb.ebo, (size_t)mb.indices.capacity * sizeof(unsigned int), (size_t)capacity * sizeof(unsigned int));
+        growRange(mb.indices, capacity);
+        grew = true;
+    }
+    if (grew) {
+        setupMeshBufferVAO(mb);
+        mb.generation++;
+    }
+
+    std::vector<PackedVertex> packedVertices;
+    const void* vertexData = vertices;
+    if (mb.packed) {
+        packVertices(vertices, vertexCount, packedVertices);
+        vertexData = packedVertices.data();
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, mb.vbo);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, (size_t)vertexOffset * stride, (size_t)vertexCount * stride, vertexData);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, mb.ebo);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, (size_t)indexOffset * sizeof(unsigned int),
+                    (size_t)indexCount * sizeof(unsigned int), indices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    h.baseVertex  = (GLint)vertexOffset;
+    h.vertexCount = vertexCount;
+    h.firstIndex  = indexOffset;
+    h.indexCount  = (GLsizei)indexCount;
+    mb.meshCount++;
+    return h;
+}
+
+// Non-indexed triangle list: indices are simply 0..n-1
+inline MeshHandle uploadMesh(MeshBuffer& mb, const float* vertices, unsigned int vertexCount) {
+    std::vector<unsigned int> indices(vertexCount);
+    for (unsigned int i = 0; i < vertexCount; ++i)
+        indices[i] = i;
+    return uploadMesh(mb, vertices, vertexCount, indices.data(), vertexCount);
+}
+
+inline void releaseMesh(MeshBuffer& mb, const MeshHandle& h) {
+    freeRange(mb.vertices, (unsigned int)h.baseVertex, h.vertexCount);
+    freeRange(mb.indices, h.firstIndex, (unsigned int)h.indexCount);
+    mb.meshCount--;
+}
+
+// Position-only data (e.g. the skybox) padded out to the shared layout
+inline std::vector<float> expandPositions(const float* positions, unsigned int vertexCount) {
+    std::vector<float> vertices((size_t)vertexCount * MESH_VERTEX_FLOATS, 0.0f);
+    for (unsigned int i = 0; i < vertexCount; ++i) {
+        vertices[i * MESH_VERTEX_FLOATS + 0] = positions[i * 3 + 0];
+        vertices[i * MESH_VERTEX_FLOATS + 1] = positions[i * 3 + 1];
+        vertices[i * MESH_VERTEX_FLOATS + 2] = positions[i * 3 + 2];
+    }
+    return vertices;
+}
+
+// Caller binds mb.vao
+inline void drawMesh(const MeshHandle& h) {
+    glDrawElementsBaseVertex(GL_TRIANGLES, h.indexCount, GL_UNSIGNED_INT, (void*)h.indexOffset(), h.baseVertex);
+}
+
+// Bytes of vertex and index data in use (not counting free space)
+inline size_t meshBufferBytesUsed(const MeshBuffer& mb) {
+    return (size_t)mb.vertices.used * meshVertexStride(mb) + (size_t)mb.indices.used * sizeof(unsigned int);
+}
+
+inline void destroyMeshBuffer(MeshBuffer& mb) {
+    glDeleteVertexArrays(1, &mb.vao);
+    glDeleteBuffers(1, &mb.vbo);
+    glDeleteBuffers(1, &mb.ebo);
+}
+
+#endif
@@ -0,0 +1,978 @@
+#ifndef MESH_IMPORT_H
+#define MESH_IMPORT_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <cctype>
+#include <cmath>
+#include <climits>
+#include <algorithm>
+
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "mesh_buffer.h"
+#include "mesh_optimizer.h"
+
+// Defined in obj_parser.h
+inline bool loadOBJParallel(const std::string& path, std::vector<float>& vertices, std::vector<unsigned int>& indices,
+                            unsigned int threadCount = 0);
+
+// --------------------- Mesh Import ---------------------
+// Wavefront OBJ and glTF 2.0 (.gltf with external or embedded buffers, .glb)
+// are converted to the shared 8-float layout (position, normal, UV) with an
+// index buffer. Missing normals are generated from the faces; missing UVs are
+// zero. Textures are not loaded with the image origin flipped, so UVs follow
+// the top-left convention of glTF and OBJ's V is flipped to match.
+//
+// Text parsing is slow for big models, so every import is optimised once and
+// written to a binary .mesh file next to the source (or converted offline with
+// --convert-mesh). The .mesh file is mmapped on later runs and its vertex and
+// index arrays go straight to uploadMesh().
+
+inline std::string fileExtension(const std::string& path) {
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos)
+        return "";
+    std::string ext = path.substr(dot + 1);
+    for (char& c : ext)
+        c = (char)std::tolower((unsigned char)c);
+    return ext;
+}
+
+inline std::string fileDirectory(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+}
+
+inline bool readFileBytes(const std::string& path, std::vector<char>& data) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+        return false;
+    data.resize((size_t)file.tellg());
+    file.seekg(0);
+    file.read(data.data(), (std::streamsize)data.size());
+    return (bool)file;
+}
+
+// Area-weighted vertex normals for every vertex whose normal is still zero
+inline void fillMissingNormals(std::vector<float>& vertices, const std::vector<unsigned int>& indices,
+                               unsigned int firstVertex = 0) {
+    size_t vertexCount = vertices.size() / MESH_VERTEX_FLOATS;
+    std::vector<bool> missing(vertexCount, false);
+    bool anyMissing = false;
+    for (size_t v = firstVertex; v < vertexCount; ++v) {
+        const float* n = &vertices[v * MESH_VERTEX_FLOATS + 3];
+        missing[v] = n[0] == 0.0f && n[1] == 0.0f && n[2] == 0.0f;
+        anyMissing = anyMissing || missing[v];
+    }
+    if (!anyMissing)
+        return;
+    for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+        const float* p[3];
+        for (int k = 0; k < 3; ++k)
+            p[k] = &vertices[(size_t)indices[t + k] * MESH_VERTEX_FLOATS];
+        glm::vec3 a(p[0][0], p[0][1], p[0][2]), b(p[1][0], p[1][1], p[1][2]), c(p[2][0], p[2][1], p[2][2]);
+        glm::vec3 n = glm::cross(b - a, c - a);   // length = 2 * area
+        for (int k = 0; k < 3; ++k) {
+            if (!missing[indices[t + k]])
+                continue;
+            float* dst = &vertices[(size_t)indices[t + k] * MESH_VERTEX_FLOATS + 3];
+            dst[0] += n.x; dst[1] += n.y; dst[2] += n.z;
+        }
+    }
+    for (size_t v = firstVertex; v < vertexCount; ++v) {
+        if (!missing[v])
+            continue;
+        float* n = &vertices[v * MESH_VERTEX_FLOATS + 3];
+        float len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (len > 0.0f) {
+            n[0] /= len; n[1] /= len; n[2] /= len;
+        } else {
+            n[1] = 1.0f;
+        }
+    }
+}
+
+// --------------------- OBJ ---------------------
+// v / vt / vn and polygonal f (fan-triangulated, negative indices allowed).
+// Each distinct position/uv/normal triple becomes one output vertex. This is
+// the simple single-threaded reader; imports use loadOBJParallel().
+struct ObjCorner {
+    int v, vt, vn;
+    bool operator==(const ObjCorner& o) const { return v == o.v && vt == o.vt && vn == o.vn; }
+};
+
+struct ObjCornerHash {
+    size_t operator()(const ObjCorner& c) const {
+        uint64_t h = (uint64_t)(uint32_t)c.v * 0x9E3779B97F4A7C15ull;
+        h ^= (uint64_t)(uint32_t)c.vt * 0xC2B2AE3D27D4EB4Full + (h << 6) + (h >> 2);
+        h ^= (uint64_t)(uint32_t)c.vn * 0x165667B19E3779F9ull + (h << 6) + (h >> 2);
+        return (size_t)h;
+    }
+};
+
+// Resolve a 1-based (or negative, relative) OBJ index; -1 if absent or out of range
+inline int resolveObjIndex(long index, size_t count) {
+    if (index > 0 && (size_t)index <= count)
+        return (int)(index - 1);
+    if (index < 0 && (size_t)(-index) <= count)
+        return (int)(count + index);
+    return -1;
+}
+
+inline bool loadOBJ(const std::string& path, std::vector<float>& vertices, std::vector<unsigned int>& indices) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cout << "ERROR::OBJ::FILE_NOT_FOUND: " << path << std::endl;
+        return false;
+    }
+    std::vector<glm::vec3> positions, normals;
+    std::vector<glm::vec2> uvs;
+    std::unordered_map<ObjCorner, unsigned int, ObjCornerHash> corners;
+    vertices.clear();
+    indices.clear();
+
+    std::string line;
+    std::vector<unsigned int> face;
+    while (std::getline(file, line)) {
+        const char* s = line.c_str();
+        while (*s == ' ' || *s == '\t')
+            ++s;
+        char* end;
+        if (s[0] == 'v' && (s[1] == ' ' || s[1] == '\t')) {
+            glm::vec3 p;
+            p.x = std::strtof(s + 2, &end);
+            p.y = std::strtof(end, &end);
+            p.z = std::strtof(end, &end);
+            positions.push_back(p);
+        } else if (s[0] == 'v' && s[1] == 'n') {
+            glm::vec3 n;
+            n.x = std::strtof(s + 2, &end);
+            n.y = std::strtof(end, &end);
+            n.z = std::strtof(end, &end);
+            normals.push_back(n);
+        } else if (s[0] == 'v' && s[1] == 't') {
+            glm::vec2 t;
+            t.x = std::strtof(s + 2, &end);
+            t.y = std::strtof(end, &end);
+            uvs.push_back(t);
+        } else if (s[0] == 'f' && (s[1] == ' ' || s[1] == '\t')) {
+            face.clear();
+            const char* p = s + 2;
+            while (true) {
+                long v = std::strtol(p, &end, 10);
+                if (end == p)
+                    break;
+                long vt = 0, vn = 0;
+                p = end;
+                if (*p == '/') {
+                    ++p;
+                    if (*p != '/') {
+                        vt = std::strtol(p, &end, 10);
+                        p = end;
+                    }
+                    if (*p == '/') {
+                        ++p;
+                        vn = std::strtol(p, &end, 10);
+                        p = end;
+                    }
+                }
+                ObjCorner c = { resolveObjIndex(v, positions.size()), resolveObjIndex(vt, uvs.size()),
+                                resolveObjIndex(vn, normals.size()) };
+                if (c.v < 0) {
+                    std::cout << "ERROR::OBJ::BAD_INDEX: " << path << ": " << line << std::endl;
+                    return false;
+                }
+                auto it = corners.find(c);
+                if (it == corners.end()) {
+                    unsigned int index = (unsigned int)(vertices.size() / MESH_VERTEX_FLOATS);
+                    it = corners.emplace(c, index).first;
+                    glm::vec3 n = c.vn >= 0 ? normals[c.vn] : glm::vec3(0.0f);
+                    glm::vec2 t = c.vt >= 0 ? uvs[c.vt] : glm::vec2(0.0f, 1.0f);
+                    const glm::vec3& pos = positions[c.v];
+                    vertices.insert(vertices.end(), { pos.x, pos.y, pos.z, n.x, n.y, n.z, t.x, 1.0f - t.y });
+                }
+                face.push_back(it->second);
+            }
+            for (size_t k = 2; k < face.size(); ++k)
+                indices.insert(indices.end(), { face[0], face[k - 1], face[k] });
+        }
+    }
+    fillMissingNormals(vertices, indices);
+    return !indices.empty();
+}
+
+// --------------------- JSON (glTF) ---------------------
+// Just enough JSON for glTF: the whole document becomes a value tree.
+struct JsonValue {
+    enum Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+    Type type = NUL;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<JsonValue> array;
+    std::vector<std::pair<std::string, JsonValue>> object;
+
+    const JsonValue* get(const char* key) const {
+        for (const auto& kv : object)
+            if (kv.first == key)
+                return &kv.second;
+        return nullptr;
+    }
+    double numberOr(const char* key, double fallback) const {
+        const JsonValue* v = get(key);
+        return v && v->type == NUMBER ? v->number : fallback;
+    }
+    // -1 for a number that isn't an integer in int range (glTF indices and
+    // counts are never negative, so callers reject it like a missing index)
+    int intOr(const char* key, int fallback) const {
+        const JsonValue* v = get(key);
+        return v && v->type == NUMBER ? v->intValue() : fallback;
+    }
+    int intValue() const {
+        if (type != NUMBER || !std::isfinite(number) || number != std::floor(number) ||
+            number < (double)INT_MIN || number > (double)INT_MAX)
+            return -1;
+        return (int)number;
+    }
+    const JsonValue& at(size_t i) const { return array[i]; }
+    size_t size() const { return array.size(); }
+};
+
+inline void skipJsonSpace(const char*& p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+        ++p;
+}
+
+inline bool parseJsonString(const char*& p, const char* end, std::string& out) {
+    if (p >= end || *p != '"')
+        return false;
+    ++p;
+    out.clear();
+    while (p < end && *p != '"') {
+        char c = *p++;
+        if (c != '\\') {
+            out += c;
+            continue;
+        }
+        if (p >= end)
+            return false;
+        char e = *p++;
+        switch (e) {
+            case 'n': out += '\n'; break;
+            case 't': out += '\t'; break;
+            case 'r': out += '\r'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'u': {
+                if (end - p < 4)
+                    return false;
+                unsigned int code = (unsigned int)std::strtoul(std::string(p, 4).c_str(), nullptr, 16);
+                p += 4;
+                // UTF-8 encode (surrogate pairs are not combined; glTF names only)
+                if (code < 0x80) {
+                    out += (char)code;
+                } else if (code < 0x800) {
+                    out += (char)(0xC0 | (code >> 6));
+                    out += (char)(0x80 | (code & 0x3F));
+                } else {
+                    out += (char)(0xE0 | (code >> 12));
+                    out += (char)(0x80 | ((code >> 6) & 0x3F));
+                    out += (char)(0x80 | (code & 0x3F));
+                }
+                break;
+            }
+            default: out += e; break;   // \" \\ \/
+        }
+    }
+    if (p >= end)
+        return false;
+    ++p;
+    return true;
+}
+
+inline bool parseJsonValue(const char*& p, const char* end, JsonValue& v, int depth = 0) {
+    skipJsonSpace(p, end);
+    if (p >= end || depth > 64)
+        return false;
+    if (*p == '{') {
+        v.type = JsonValue::OBJECT;
+        ++p;
+        skipJsonSpace(p, end);
+        if (p < end && *p == '}') {
+            ++p;
+            return true;
+        }
+        while (true) {
+            std::pair<std::string, JsonValue> kv;
+            skipJsonSpace(p, end);
+            if (!parseJsonString(p, end, kv.first))
+                return false;
+            skipJsonSpace(p, end);
+            if (p >= end || *p++ != ':')
+                return false;
+            if (!parseJsonValue(p, end, kv.second, depth + 1))
+                return false;
+            v.object.push_back(std::move(kv));
+            skipJsonSpace(p, end);
+            if (p < end && *p == ',') {
+                ++p;
+                continue;
+            }
+            if (p < end && *p == '}') {
+                ++p;
+                return true;
+            }
+            return false;
+        }
+    }
+    if (*p == '[') {
+        v.type = JsonValue::ARRAY;
+        ++p;
+        skipJsonSpace(p, end);
+        if (p < end && *p == ']') {
+            ++p;
+            return true;
+        }
+        while (true) {
+            v.array.emplace_back();
+            if (!parseJsonValue(p, end, v.array.back(), depth + 1))
+                return false;
+            skipJsonSpace(p, end);
+            if (p < end && *p == ',') {
+                ++p;
+                continue;
+            }
+            if (p < end && *p == ']') {
+                ++p;
+                return true;
+            }
+            return false;
+        }
+    }
+    if (*p == '"') {
+        v.type = JsonValue::STRING;
+        return parseJsonString(p, end, v.string);
+    }
+    if (end - p >= 4 && std::strncmp(p, "true", 4) == 0) {
+        v.type = JsonValue::BOOLEAN;
+        v.boolean = true;
+        p += 4;
+        return true;
+    }
+    if (end - p >= 5 && std::strncmp(p, "false", 5) == 0) {
+        v.type = JsonValue::BOOLEAN;
+        p += 5;
+        return true;
+    }
+    if (end - p >= 4 && std::strncmp(p, "null", 4) == 0) {
+        p += 4;
+        return true;
+    }
+    // Number: copy the token so strtod cannot run past the buffer
+    const char* start = p;
+    while (p < end && (std::isdigit((unsigned char)*p) || *p == '-' || *p == '+' || *p == '.' || *p == 'e' || *p == 'E'))
+        ++p;
+    if (p == start)
+        return false;
+    v.type = JsonValue::NUMBER;
+    v.number = std::strtod(std::string(start, p).c_str(), nullptr);
+    return true;
+}
+
+// --------------------- glTF 2.0 ---------------------
+// Triangle primitives of every mesh node in the default scene, with the node
+// transforms baked in. POSITION, NORMAL and TEXCOORD_0 (float or normalised
+// integer UVs) are read; materials, skins and morph targets are ignored.
+
+inline bool decodeBase64(const std::string& in, size_t start, std::vector<char>& out) {
+    auto value = [](char c) -> int {
+        if (c >= 'A' && c <= 'Z') return c - 'A';
+        if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+        if (c >= '0' && c <= '9') return c - '0' + 52;
+        if (c == '+' || c == '-') return 62;
+        if (c == '/' || c == '_') return 63;
+        return -1;
+    };
+    out.clear();
+    unsigned int bits = 0;
+    int bitCount = 0;
+    for (size_t i = start; i < in.size() && in[i] != '='; ++i) {
+        int v = value(in[i]);
+        if (v < 0)
+            return false;
+        bits = (bits << 6) | (unsigned int)v;
+        bitCount += 6;
+        if (bitCount >= 8) {
+            bitCount -= 8;
+            out.push_back((char)((bits >> bitCount) & 0xFF));
+        }
+    }
+    return true;
+}
+
+struct GltfDocument {
+    JsonValue json;
+    std::vector<std::vector<char>> buffers;
+};
+
+// Pointer to element 0 of an accessor plus its stride; false if unsupported
+inline bool gltfAccessorData(const GltfDocument& doc, int accessorIndex, const char*& data, size_t& stride,
+                             int& count, int& componentType, int& components, bool& normalized) {
+    const JsonValue* accessors = doc.json.get("accessors");
+    const JsonValue* views = doc.json.get("bufferViews");
+    if (!accessors || accessorIndex < 0 || (size_t)accessorIndex >= accessors->size() || !views)
+        return false;
+    const JsonValue& a = accessors->at(accessorIndex);
+    const JsonValue* type = a.get("type");
+    if (!type || a.get("sparse"))
+        return false;
+    static const std::pair<const char*, int> types[] = {
+        { "SCALAR", 1 }, { "VEC2", 2 }, { "VEC3", 3 }, { "VEC4", 4 }
+    };
+    components = 0;
+    for (const auto& t : types)
+        if (type->string == t.first)
+            components = t.second;
+    componentType = a.intOr("componentType", 0);
+    count = a.intOr("count", 0);
+    const JsonValue* normalizedValue = a.get("normalized");
+    normalized = normalizedValue && normalizedValue->boolean;
+    int componentSize = componentType == 5126 || componentType == 5125 ? 4 :
+                        componentType == 5123 || componentType == 5122 ? 2 :
+                        componentType == 5121 || componentType == 5120 ? 1 : 0;
+    int viewIndex = a.intOr("bufferView", -1);
+    if (components == 0 || componentSize == 0 || viewIndex < 0 || (size_t)viewIndex >= views->size())
+        return false;
+    const JsonValue& view = views->at(viewIndex);
+    int bufferIndex = view.intOr("buffer", -1);
+    if (bufferIndex < 0 || (size_t)bufferIndex >= doc.buffers.size())
+        return false;
+    size_t elementSize = (size_t)componentSize * components;
+    // Offsets, lengths and counts all come from the file: check them as read,
+    // before any arithmetic on them can wrap, so that every element lies
+    // inside the buffer view and the view inside the buffer
+    const std::vector<char>& buffer = doc.buffers[bufferIndex];
+    double viewOffset = view.numberOr("byteOffset", 0);
+    double viewLength = view.numberOr("byteLength", 0);
+    double viewStride = view.numberOr("byteStride", 0);
+    double accessorOffset = a.numberOr("byteOffset", 0);
+    if (count <= 0 || viewOffset < 0 || viewLength < 0 || viewStride < 0 || accessorOffset < 0 ||
+        viewOffset + viewLength > (double)buffer.size() || accessorOffset + elementSize > viewLength)
+        return false;
+    stride = viewStride > 0 ? (size_t)viewStride : elementSize;
+    if (stride < elementSize)
+        return false;
+    size_t offset = (size_t)accessorOffset;
+    size_t room = (size_t)viewLength - offset - elementSize;
+    if ((size_t)(count - 1) > room / stride)
+        return false;
+    data = buffer.data() + (size_t)viewOffset + offset;
+    return true;
+}
+
+// Float attribute (or normalised integer for UVs) converted to `wanted` floats per element
+inline bool readGltfFloats(const GltfDocument& doc, int accessorIndex, int wanted, std::vector<float>& out) {
+    const char* data;
+    size_t stride;
+    int count, componentType, components;
+    bool normalized;
+    if (!gltfAccessorData(doc, accessorIndex, data, stride, count, componentType, components, normalized))
+        return false;
+    if (components < wanted || (componentType != 5126 && !normalized))
+        return false;
+    out.resize((size_t)count * wanted);
+    for (int i = 0; i < count; ++i) {
+        const char* e = data + (size_t)i * stride;
+        for (int c = 0; c < wanted; ++c) {
+            float f;
+            if (componentType == 5126) {
+                std::memcpy(&f, e + c * 4, 4);
+            } else if (componentType == 5123) {
+                uint16_t u;
+                std::memcpy(&u, e + c * 2, 2);
+                f = u / 65535.0f;
+            } else if (componentType == 5121) {
+                f = (uint8_t)e[c] / 255.0f;
+            } else {
+                return false;
+            }
+            out[(size_t)i * wanted + c] = f;
+        }
+    }
+    return true;
+}
+
+inline bool readGltfIndices(const GltfDocument& doc, int accessorIndex, std::vector<unsigned int>& out) {
+    const char* data;
+    size_t stride;
+    int count, componentType, components;
+    bool normalized;
+    if (!gltfAccessorData(doc, accessorIndex, data, stride, count, componentType, components, normalized))
+        return false;
+    out.resize(count);
+    for (int i = 0; i < count; ++i) {
+        const char* e = data + (size_t)i * stride;
+        if (componentType == 5125) {
+            uint32_t v;
+            std::memcpy(&v, e, 4);
+            out[i] = v;
+        } else if (componentType == 5123) {
+            uint16_t v;
+            std::memcpy(&v, e, 2);
+            out[i] = v;
+        } else if (componentType == 5121) {
+            out[i] = (uint8_t)e[0];
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline glm::mat4 gltfNodeMatrix(const JsonValue& node) {
+    glm::mat4 m(1.0f);
+    const JsonValue* matrix = node.get("matrix");
+    if (matrix && matrix->size() == 16) {
+        for (int c = 0; c < 4; ++c)
+            for (int r = 0; r < 4; ++r)
+                m[c][r] = (float)matrix->at(c * 4 + r).number;
+        return m;
+    }
+    const JsonValue* t = node.get("translation");
+    const JsonValue* q = node.get("rotation");
+    const JsonValue* s = node.get("scale");
+    if (t && t->size() == 3)
+        m = glm::translate(m, glm::vec3((float)t->at(0).number, (float)t->at(1).number, (float)t->at(2).number));
+    if (q && q->size() == 4) {
+        float x = (float)q->at(0).number, y = (float)q->at(1).number, z = (float)q->at(2).number, w = (float)q->at(3).number;
+        glm::mat4 r(1.0f);
+        r[0][0] = 1 - 2 * (y * y + z * z); r[0][1] = 2 * (x * y + z * w);     r[0][2] = 2 * (x * z - y * w);
+        r[1][0] = 2 * (x * y - z * w);     r[1][1] = 1 - 2 * (x * x + z * z); r[1][2] = 2 * (y * z + x * w);
+        r[2][0] = 2 * (x * z + y * w);     r[2][1] = 2 * (y * z - x * w);     r[2][2] = 1 - 2 * (x * x + y * y);
+        m = m * r;
+    }
+    if (s && s->size() == 3)
+        m = glm::scale(m, glm::vec3((float)s->at(0).number, (float)s->at(1).number, (float)s->at(2).number));
+    return m;
+}
+
+inline void appendGltfMesh(const GltfDocument& doc, const JsonValue& mesh, const glm::mat4& transform,
+                           std::vector<float>& vertices, std::vector<unsigned int>& indices) {
+    const JsonValue* primitives = mesh.get("primitives");
+    if (!primitives)
+        return;
+    glm::mat4 normalMatrix = glm::transpose(glm::inverse(transform));
+    for (const JsonValue& prim : primitives->array) {
+        if (prim.intOr("mode", 4) != 4)
+            continue;   // points, lines and strips are skipped
+        const JsonValue* attributes = prim.get("attributes");
+        if (!attributes)
+            continue;
+        std::vector<float> positions, normals, uvs;
+        if (!readGltfFloats(doc, attributes->intOr("POSITION", -1), 3, positions))
+            continue;
+        size_t count = positions.size() / 3;
+        if (!readGltfFloats(doc, attributes->intOr("NORMAL", -1), 3, normals) || normals.size() != count * 3)
+            normals.assign(count * 3, 0.0f);
+        if (!readGltfFloats(doc, attributes->intOr("TEXCOORD_0", -1), 2, uvs) || uvs.size() != count * 2)
+            uvs.assign(count * 2, 0.0f);
+
+        std::vector<unsigned int> primIndices;
+        if (prim.get("indices")) {
+            if (!readGltfIndices(doc, prim.intOr("indices", -1), primIndices))
+                continue;
+        } else {
+            primIndices.resize(count);
+            for (size_t i = 0; i < count; ++i)
+                primIndices[i] = (unsigned int)i;
+        }
+
+        unsigned int base = (unsigned int)(vertices.size() / MESH_VERTEX_FLOATS);
+        for (size_t i = 0; i < count; ++i) {
+            glm::vec4 p = transform * glm::vec4(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2], 1.0f);
+            glm::vec4 n = normalMatrix * glm::vec4(normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2], 0.0f);
+            glm::vec3 nn(n.x, n.y, n.z);
+            if (glm::length(nn) > 0.0f)
+                nn = glm::normalize(nn);
+            vertices.insert(vertices.end(), { p.x, p.y, p.z, nn.x, nn.y, nn.z, uvs[i * 2], uvs[i * 2 + 1] });
+        }
+        // A mirroring transform flips the winding
+        bool flip = glm::determinant(transform) < 0.0f;
+        for (size_t i = 0; i + 2 < primIndices.size(); i += 3) {
+            if (primIndices[i] >= count || primIndices[i + 1] >= count || primIndices[i + 2] >= count)
+                continue;
+            indices.push_back(base + primIndices[i]);
+            indices.push_back(base + primIndices[flip ? i + 2 : i + 1]);
+            indices.push_back(base + primIndices[flip ? i + 1 : i + 2]);
+        }
+    }
+}
+
+inline void appendGltfNode(const GltfDocument& doc, int nodeIndex, const glm::mat4& parent,
+                           std::vector<float>& vertices, std::vector<unsigned int>& indices, int depth = 0) {
+    const JsonValue* nodes = doc.json.get("nodes");
+    const JsonValue* meshes = doc.json.get("meshes");
+    if (!nodes || nodeIndex < 0 || (size_t)nodeIndex >= nodes->size() || depth > 64)
+        return;
+    const JsonValue& node = nodes->at(nodeIndex);
+    glm::mat4 transform = parent * gltfNodeMatrix(node);
+    int meshIndex = node.intOr("mesh", -1);
+    if (meshes && meshIndex >= 0 && (size_t)meshIndex < meshes->size())
+        appendGltfMesh(doc, meshes->at(meshIndex), transform, vertices, indices);
+    if (const JsonValue* children = node.get("children"))
+        for (const JsonValue& child : children->array)
+            appendGltfNode(doc, child.intValue(), transform, vertices, indices, depth + 1);
+}
+
+inline bool loadGLTF(const std::string& path, std::vector<float>& vertices, std::vector<unsigned int>& indices) {
+    std::vector<char> file;
+    if (!readFileBytes(path, file)) {
+        std::cout << "ERROR::GLTF::FILE_NOT_FOUND: " << path << std::endl;
+        return false;
+    }
+
+    // .glb: 12-byte header, then a JSON chunk and an optional BIN chunk
+    GltfDocument doc;
+    const char* jsonBegin = file.data();
+    const char* jsonEnd = file.data() + file.size();
+    std::vector<char> glbBinary;
+    if (file.size() >= 20 && std::memcmp(file.data(), "glTF", 4) == 0) {
+        size_t offset = 12;
+        bool haveJson = false;
+        while (offset + 8 <= file.size()) {
+            uint32_t chunkLength, chunkType;
+            std::memcpy(&chunkLength, &file[offset], 4);
+            std::memcpy(&chunkType, &file[offset + 4], 4);
+            offset += 8;
+            if (offset + chunkLength > file.size())
+                break;
+            if (chunkType == 0x4E4F534A && !haveJson) {          // "JSON"
+                jsonBegin = &file[offset];
+                jsonEnd = jsonBegin + chunkLength;
+                haveJson = true;
+            } else if (chunkType == 0x004E4942 && glbBinary.empty()) {   // "BIN\0"
+                glbBinary.assign(&file[offset], &file[offset] + chunkLength);
+            }
+            offset += (chunkLength + 3) & ~3u;
+        }
+        if (!haveJson) {
+            std::cout << "ERROR::GLTF::NO_JSON_CHUNK: " << path << std::endl;
+            return false;
+        }
+    }
+    const char* p = jsonBegin;
+    if (!parseJsonValue(p, jsonEnd, doc.json) || doc.json.type != JsonValue::OBJECT) {
+        std::cout << "ERROR::GLTF::JSON_PARSE_FAILED: " << path << std::endl;
+        return false;
+    }
+
+    if (const JsonValue* buffers = doc.json.get("buffers")) {
+        for (size_t i = 0; i < buffers->size(); ++i) {
+            doc.buffers.emplace_back();
+            const JsonValue* uri = buffers->at(i).get("uri");
+            if (!uri) {
+                if (i == 0)
+                    doc.buffers.back().swap(glbBinary);
+                continue;
+            }
+            bool ok;
+            if (uri->string.compare(0, 5, "data:") == 0) {
+                size_t comma = uri->string.find(";base64,");
+                ok = comma != std::string::npos && decodeBase64(uri->string, comma + 8, doc.buffers.back());
+            } else {
+                ok = readFileBytes(fileDirectory(path) + uri->string, doc.buffers.back());
+            }
+            if (!ok) {
+                std::cout << "ERROR::GLTF::BUFFER_LOAD_FAILED: " << path << ": buffer " << i << std::endl;
+                return false;
+            }
+        }
+    }
+
+    vertices.clear();
+    indices.clear();
+    const JsonValue* scenes = doc.json.get("scenes");
+    int scene = doc.json.intOr("scene", 0);
+    if (scenes && (size_t)scene < scenes->size() && scenes->at(scene).get("nodes")) {
+        for (const JsonValue& node : scenes->at(scene).get("nodes")->array)
+            appendGltfNode(doc, node.intValue(), glm::mat4(1.0f), vertices, indices);
+    } else if (const JsonValue* meshes = doc.json.get("meshes")) {
+        for (const JsonValue& mesh : meshes->array)
+            appendGltfMesh(doc, mesh, glm::mat4(1.0f), vertices, indices);
+    }
+    fillMissingNormals(vertices, indices);
+    if (indices.empty())
+        std::cout << "ERROR::GLTF::NO_TRIANGLES: " << path << std::endl;
+    return !indices.empty();
+}
+
+// --------------------- Binary Mesh Files ---------------------
+// Header, then vertexCount * 8 floats, then indexCount indices, all in
+// native byte order. A cache file records the size and modification time of
+// the model it was converted from and is rebuilt when they change.
+
+const uint32_t MESH_FILE_VERSION = 1;
+
+struct MeshFileHeader {
+    char magic[4];             // "MESH"
+    uint32_t version;
+    uint32_t vertexFloats;     // MESH_VERTEX_FLOATS
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t reserved;
+    uint64_t sourceSize;       // 0 for a standalone file
+    int64_t  sourceTime;
+    float boundsMin[3];
+    float boundsMax[3];
+};
+
+struct MappedMeshFile {
+    const MeshFileHeader* header = nullptr;
+    const float* vertices = nullptr;
+    const unsigned int* indices = nullptr;
+    void* mapping = nullptr;
+    size_t size = 0;
+    std::vector<char> fallback;   // read() copy where mmap is unavailable
+};
+
+inline bool statFile(const std::string& path, uint64_t& size, int64_t& time) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        return false;
+    size = (uint64_t)st.st_size;
+    time = (int64_t)st.st_mtime;
+    return true;
+}
+
+inline bool writeMeshFile(const std::string& path, const std::vector<float>& vertices,
+                          const std::vector<unsigned int>& indices, uint64_t sourceSize, int64_t sourceTime) {
+    MeshFileHeader h = {};
+    std::memcpy(h.magic, "MESH", 4);
+    h.version = MESH_FILE_VERSION;
+    h.vertexFloats = MESH_VERTEX_FLOATS;
+    h.vertexCount = (uint32_t)(vertices.size() / MESH_VERTEX_FLOATS);
+    h.indexCount = (uint32_t)indices.size();
+    h.sourceSize = sourceSize;
+    h.sourceTime = sourceTime;
+    for (int c = 0; c < 3; ++c) {
+        h.boundsMin[c] = h.vertexCount ? INFINITY : 0.0f;
+        h.boundsMax[c] = h.vertexCount ? -INFINITY : 0.0f;
+    }
+    for (size_t v = 0; v < vertices.size(); v += MESH_VERTEX_FLOATS)
+        for (int c = 0; c < 3; ++c) {
+            h.boundsMin[c] = std::min(h.boundsMin[c], vertices[v + c]);
+            h.boundsMax[c] = std::max(h.boundsMax[c], vertices[v + c]);
+        }
+
+    // Write to a temporary name and rename, so a crash never leaves a torn cache
+    std::string temp = path + ".tmp";
+    FILE* f = std::fopen(temp.c_str(), "wb");
+    if (!f) {
+        std::cout << "ERROR::MESH_FILE::WRITE_FAILED: " << path << std::endl;
+        return false;
+    }
+    bool ok = std::fwrite(&h, sizeof(h), 1, f) == 1 &&
+              std::fwrite(vertices.data(), sizeof(float), vertices.size(), f) == vertices.size() &&
+              std::fwrite(indices.data(), sizeof(unsigned int), indices.size(), f) == indices.size();
+    ok = std::fclose(f) == 0 && ok;
+#ifdef _WIN32
+    // rename() replaces the old cache atomically elsewhere, but not on Windows
+    if (ok)
+        std::remove(path.c_str());
+#endif
+    if (!ok || std::rename(temp.c_str(), path.c_str()) != 0) {
+        std::remove(temp.c_str());
+        std::cout << "ERROR::MESH_FILE::WRITE_FAILED: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+inline void unmapMeshFile(MappedMeshFile& m) {
+#ifndef _WIN32
+    if (m.mapping)
+        munmap(m.mapping, m.size);
+#endif
+    m = MappedMeshFile();
+}
+
+inline bool mapMeshFile(const std::string& path, MappedMeshFile& m) {
+    unmapMeshFile(m);
+    const char* data = nullptr;
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(MeshFileHeader)) {
+        m.size = (size_t)st.st_size;
+        m.mapping = mmap(nullptr, m.size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m.mapping == MAP_FAILED)
+            m.mapping = nullptr;
+    }
+    close(fd);   // the mapping stays valid
+    if (!m.mapping) {
+        m = MappedMeshFile();
+        return false;
+    }
+    data = (const char*)m.mapping;
+#else
+    if (!readFileBytes(path, m.fallback) || m.fallback.size() < sizeof(MeshFileHeader))
+        return false;
+    m.size = m.fallback.size();
+    data = m.fallback.data();
+#endif
+    const MeshFileHeader* h = (const MeshFileHeader*)data;
+    size_t expected = sizeof(MeshFileHeader) + (size_t)h->vertexCount * MESH_VERTEX_FLOATS * sizeof(float) +
+                      (size_t)h->indexCount * sizeof(unsigned int);
+    if (std::memcmp(h->magic, "MESH", 4) != 0 || h->version != MESH_FILE_VERSION ||
+        h->vertexFloats != MESH_VERTEX_FLOATS || m.size != expected) {
+        unmapMeshFile(m);
+        return false;
+    }
+    m.header = h;
+    m.vertices = (const float*)(data + sizeof(MeshFileHeader));
+    m.indices = (const unsigned int*)(m.vertices + (size_t)h->vertexCount * MESH_VERTEX_FLOATS);
+    // A cache that is the right size can still be corrupt; an index past the
+    // vertices would be drawn straight from the mesh buffer, so reject it here
+    for (uint32_t i = 0; i < h->indexCount; ++i)
+        if (m.indices[i] >= h->vertexCount) {
+            unmapMeshFile(m);
+            return false;
+        }
+    return true;
+}
+
+// --------------------- Model Loading ---------------------
+struct ImportedModel {
+    MeshHandle mesh;
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+};
+
+inline std::string meshCachePath(const std::string& path) {
+    return path + ".mesh";
+}
+
+// Parse an OBJ or glTF file and optimise it for the vertex cache
+inline bool importMesh(const std::string& path, std::vector<float>& vertices, std::vector<unsigned int>& indices) {
+    std::string ext = fileExtension(path);
+    bool ok;
+    if (ext == "obj") {
+        ok = loadOBJParallel(path, vertices, indices);
+    } else if (ext == "gltf" || ext == "glb") {
+        ok = loadGLTF(path, vertices, indices);
+    } else {
+        std::cout << "ERROR::MESH_IMPORT::UNKNOWN_FORMAT: " << path << std::endl;
+        return false;
+    }
+    if (ok)
+        optimizeMesh(vertices, indices, path.c_str());
+    return ok;
+}
+
+// Offline conversion (--convert-mesh): writes <path>.mesh
+inline bool convertMeshFile(const std::string& path) {
+    using Clock = std::chrono::high_resolution_clock;
+    auto start = Clock::now();
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    uint64_t size;
+    int64_t time;
+    if (!statFile(path, size, time) || !importMesh(path, vertices, indices))
+        return false;
+    if (!writeMeshFile(meshCachePath(path), vertices, indices, size, time))
+        return false;
+    std::cout << "Converted " << path << " -> " << meshCachePath(path) << " in " << std::fixed << std::setprecision(1)
+              << std::chrono::duration<double, std::milli>(Clock::now() - start).count() << " ms"
+              << std::defaultfloat << std::endl;
+    return true;
+}
+
+// Load a .mesh file directly, or an OBJ/glTF model through its cache
+inline bool loadModel(MeshBuffer& mb, const std::string& path, ImportedModel& model) {
+    using Clock = std::chrono::high_resolution_clock;
+    auto start = Clock::now();
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+    bool standalone = fileExtension(path) == "mesh";
+    if (!standalone && !statFile(path, sourceSize, sourceTime)) {
+        std::cout << "ERROR::MODEL::FILE_NOT_FOUND: " << path << std::endl;
+        return false;
+    }
+
+    std::string cachePath = standalone ? path : meshCachePath(path);
+    MappedMeshFile mapped;
+    bool cached = mapMeshFile(cachePath, mapped) &&
+                  (standalone || (mapped.header->sourceSize == sourceSize && mapped.header->sourceTime == sourceTime));
+    if (cached) {
+        const MeshFileHeader& h = *mapped.header;
+        model.mesh = uploadMesh(mb, mapped.vertices, h.vertexCount, mapped.indices, h.indexCount);
+        model.boundsMin = glm::vec3(h.boundsMin[0], h.boundsMin[1], h.boundsMin[2]);
+        model.boundsMax = glm::vec3(h.boundsMax[0], h.boundsMax[1], h.boundsMax[2]);
+        unmapMeshFile(mapped);
+        std::cout << "Model: " << path << ": " << model.mesh.indexCount / 3 << " triangles from " << cachePath
+                  << " in " << std::fixed << std::setprecision(1)
+                  << std::chrono::duration<double, std::milli>(Clock::now() - start).count() << " ms"
+                  << std::defaultfloat << std::endl;
+        return true;
+    }
+    unmapMeshFile(mapped);
+    if (standalone) {
+        std::cout << "ERROR::MODEL::INVALID_MESH_FILE: " << path << std::endl;
+        return false;
+    }
+
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    if (!importMesh(path, vertices, indices))
+        return false;
+    writeMeshFile(cachePath, vertices, indices, sourceSize, sourceTime);
+    model.mesh = uploadMesh(mb, vertices.data(), (unsigned int)(vertices.size() / MESH_VERTEX_FLOATS),
+                            indices.data(), (unsigned int)indices.size());
+    model.boundsMin = glm::vec3(INFINITY);
+    model.boundsMax = glm::vec3(-INFINITY);
+    for (size_t v = 0; v < vertices.size(); v += MESH_VERTEX_FLOATS) {
+        glm::vec3 p(vertices[v], vertices[v + 1], vertices[v + 2]);
+        model.boundsMin = glm::min(model.boundsMin, p);
+        model.boundsMax = glm::max(model.boundsMax, p);
+    }
+    std::cout << "Model: " << path << ": " << model.mesh.indexCount / 3 << " triangles imported in "
+              << std::fixed << std::setprecision(1)
+              << std::chrono::duration<double, std::milli>(Clock::now() - start).count() << " ms, cached to "
+              << cachePath << std::defaultfloat << std::endl;
+    return true;
+}
+
+// Scale to `height` units and stand the model on `base` (bottom centre)
+inline glm::mat4 modelPlacement(const ImportedModel& model, const glm::vec3& base, float height) {
+    glm::vec3 extent = model.boundsMax - model.boundsMin;
+    float largest = std::max(extent.x, std::max(extent.y, extent.z));
+    float scale = largest > 0.0f ? height / largest : 1.0f;
+    glm::vec3 bottomCenter((model.boundsMin.x + model.boundsMax.x) * 0.5f, model.boundsMin.y,
+                           (model.boundsMin.z + model.boundsMax.z) * 0.5f);
+    glm::mat4 m = glm::translate(glm::mat4(1.0f), base);
+    m = glm::scale(m, glm::vec3(scale));
+    return glm::translate(m, -bottomCenter);
+}
+
+#endif
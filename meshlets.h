@@ -0,0 +1,284 @@
+#ifndef MESHLETS_H
+#define MESHLETS_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+#include "mesh_buffer.h"
+#include "mesh_optimizer.h"
+#include "frustum.h"
+
+// Defined in main.cpp
+void generateSphere(std::vector<float>& vertices, std::vector<unsigned int>& indices, float radius, unsigned int sectorCount, unsigned int stackCount);
+
+// --------------------- Meshlets ---------------------
+// Large meshes are split into small clusters (at most 64 vertices and 126
+// triangles, the usual mesh shader limits) built greedily along the index
+// order, so a vertex-cache-optimised mesh gives compact clusters. Each
+// cluster stores a bounding sphere and a normal cone. Every frame the clusters
+// are tested on the CPU:
+//
+//   frustum   sphere against the six planes (in model space)
+//   backface  the whole cluster faces away if the view direction lies
+//             outside the normal cone widened by the sphere radius
+//
+// and the surviving clusters' triangles are written to a per-frame index
+// buffer that is drawn with one call against the shared vertex buffer.
+
+const unsigned int MESHLET_MAX_VERTICES  = 64;
+const unsigned int MESHLET_MAX_TRIANGLES = 126;
+
+struct Meshlet {
+    uint32_t vertexOffset;     // into MeshletMesh::vertices
+    uint32_t triangleOffset;   // into MeshletMesh::triangles (3 bytes per triangle)
+    uint32_t vertexCount;
+    uint32_t triangleCount;
+    glm::vec3 center;
+    float radius;
+    glm::vec3 coneAxis;
+    float coneCutoff;          // sin of the cone half-angle; 1 = cone test disabled
+};
+
+struct MeshletMesh {
+    std::vector<Meshlet> meshlets;
+    std::vector<unsigned int> vertices;   // mesh vertex index per meshlet-local vertex
+    std::vector<uint8_t> triangles;       // meshlet-local indices
+};
+
+struct MeshletStats {
+    int total = 0;
+    int frustumCulled = 0;
+    int backfaceCulled = 0;
+    long long triangles = 0;      // triangles in the frame's index stream
+};
+
+inline glm::vec3 meshPosition(const std::vector<float>& vertices, unsigned int index) {
+    const float* v = &vertices[(size_t)index * MESH_VERTEX_FLOATS];
+    return glm::vec3(v[0], v[1], v[2]);
+}
+
+inline void computeMeshletBounds(Meshlet& m, const MeshletMesh& mesh, const std::vector<float>& vertices) {
+    // Bounding sphere around the vertex centroid
+    glm::vec3 center(0.0f);
+    for (uint32_t i = 0; i < m.vertexCount; ++i)
+        center = center + meshPosition(vertices, mesh.vertices[m.vertexOffset + i]);
+    center = center / (float)m.vertexCount;
+    float radius = 0.0f;
+    for (uint32_t i = 0; i < m.vertexCount; ++i)
+        radius = std::max(radius, glm::distance(center, meshPosition(vertices, mesh.vertices[m.vertexOffset + i])));
+    m.center = center;
+    m.radius = radius;
+
+    // Normal cone: axis is the mean face normal, the spread the widest deviation from it
+    std::vector<glm::vec3> normals;
+    normals.reserve(m.triangleCount);
+    glm::vec3 axis(0.0f);
+    for (uint32_t t = 0; t < m.triangleCount; ++t) {
+        const uint8_t* tri = &mesh.triangles[m.triangleOffset + t * 3];
+        glm::vec3 a = meshPosition(vertices, mesh.vertices[m.vertexOffset + tri[0]]);
+        glm::vec3 b = meshPosition(vertices, mesh.vertices[m.vertexOffset + tri[1]]);
+        glm::vec3 c = meshPosition(vertices, mesh.vertices[m.vertexOffset + tri[2]]);
+        glm::vec3 n = glm::cross(b - a, c - a);
+        float len = glm::length(n);
+        if (len < 1e-12f)
+            continue;
+        normals.push_back(n / len);
+        axis = axis + n / len;
+    }
+    m.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+    m.coneCutoff = 1.0f;
+    float axisLength = glm::length(axis);
+    if (normals.empty() || axisLength < 1e-6f)
+        return;
+    axis = axis / axisLength;
+    float minDot = 1.0f;
+    for (const glm::vec3& n : normals)
+        minDot = std::min(minDot, glm::dot(n, axis));
+    m.coneAxis = axis;
+    if (minDot > 0.0f)   // spread under 90 degrees, otherwise the cone never culls
+        m.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+// Greedy clustering in index order
+inline void buildMeshlets(MeshletMesh& mesh, const std::vector<float>& vertices, const std::vector<unsigned int>& indices) {
+    mesh = MeshletMesh();
+    unsigned int vertexCount = (unsigned int)(vertices.size() / MESH_VERTEX_FLOATS);
+    const uint8_t unused = 0xFF;
+    std::vector<uint8_t> localIndex(vertexCount, unused);
+
+    Meshlet current = {};
+    auto finish = [&]() {
+        if (current.triangleCount == 0)
+            return;
+        for (uint32_t i = 0; i < current.vertexCount; ++i)
+            localIndex[mesh.vertices[current.vertexOffset + i]] = unused;
+        computeMeshletBounds(current, mesh, vertices);
+        mesh.meshlets.push_back(current);
+        current = {};
+        current.vertexOffset = (uint32_t)mesh.vertices.size();
+        current.triangleOffset = (uint32_t)mesh.triangles.size();
+    };
+
+    for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+        unsigned int tri[3] = { indices[t], indices[t + 1], indices[t + 2] };
+        unsigned int newVertices = 0;
+        for (int k = 0; k < 3; ++k)
+            if (localIndex[tri[k]] == unused && (k == 0 || tri[k] != tri[0]) && (k < 2 || tri[2] != tri[1]))
+                newVertices++;
+        if (current.vertexCount + newVertices > MESHLET_MAX_VERTICES || current.triangleCount + 1 > MESHLET_MAX_TRIANGLES)
+            finish();
+
+        for (int k = 0; k < 3; ++k) {
+            if (localIndex[tri[k]] == unused) {
+                localIndex[tri[k]] = (uint8_t)current.vertexCount++;
+                mesh.vertices.push_back(tri[k]);
+            }
+            mesh.triangles.push_back(localIndex[tri[k]]);
+        }
+        current.triangleCount++;
+    }
+    finish();
+}
+
+// Model-space test; frustum from projection * view * model, eye in model space
+inline bool isMeshletVisible(const Meshlet& m, const Frustum& frustum, const glm::vec3& eye, MeshletStats& stats) {
+    if (!sphereInFrustum(frustum, m.center, m.radius)) {
+        stats.frustumCulled++;
+        return false;
+    }
+    glm::vec3 toCenter = m.center - eye;
+    if (glm::dot(toCenter, m.coneAxis) >= m.coneCutoff * glm::length(toCenter) + m.radius) {
+        stats.backfaceCulled++;
+        return false;
+    }
+    return true;
+}
+
+// Writes the visible clusters' triangles (mesh vertex indices) to `out`
+inline void cullMeshlets(const MeshletMesh& mesh, const Frustum& frustum, const glm::vec3& eye,
+                         std::vector<unsigned int>& out, MeshletStats& stats) {
+    out.clear();
+    stats = MeshletStats();
+    stats.total = (int)mesh.meshlets.size();
+    for (const Meshlet& m : mesh.meshlets) {
+        if (!isMeshletVisible(m, frustum, eye, stats))
+            continue;
+        const unsigned int* local = &mesh.vertices[m.vertexOffset];
+        const uint8_t* tri = &mesh.triangles[m.triangleOffset];
+        for (uint32_t i = 0; i < m.triangleCount * 3; ++i)
+            out.push_back(local[tri[i]]);
+        stats.triangles += m.triangleCount;
+    }
+}
+
+// --------------------- Meshlet Rendering ---------------------
+// One mesh in the shared vertex buffer, drawn through its own VAO whose
+// element buffer is refilled every frame with the surviving triangles.
+struct MeshletRenderer {
+    MeshletMesh mesh;
+    MeshHandle handle;                 // vertices (and full index list) in the mesh buffer
+    unsigned int vao = 0, ebo = 0;
+    unsigned int boundGeneration = 0;   // mesh buffer generation the VAO was set up for
+    std::vector<unsigned int> frameIndices;
+    MeshletStats stats;
+};
+
+inline void initMeshletRenderer(MeshletRenderer& r, MeshBuffer& mb, std::vector<float>& vertices,
+                                std::vector<unsigned int>& indices, const char* name) {
+    optimizeMesh(vertices, indices, name);
+    buildMeshlets(r.mesh, vertices, indices);
+    r.handle = uploadMesh(mb, vertices.data(), (unsigned int)(vertices.size() / MESH_VERTEX_FLOATS),
+                          indices.data(), (unsigned int)indices.size());
+    glGenVertexArrays(1, &r.vao);
+    glGenBuffers(1, &r.ebo);
+    std::cout << "Meshlets: " << name << ": " << r.mesh.meshlets.size() << " clusters, "
+              << std::fixed << std::setprecision(1)
+              << (float)r.mesh.vertices.size() / r.mesh.meshlets.size() << " vertices and "
+              << (float)(indices.size() / 3) / r.mesh.meshlets.size() << " triangles per cluster"
+              << std::defaultfloat << std::endl;
+}
+
+// Cull and upload this frame's index stream; returns the index count to draw
+inline GLsizei updateMeshletRenderer(MeshletRenderer& r, const MeshBuffer& mb, const glm::mat4& viewProjection,
+                                     const glm::mat4& model, const glm::vec3& cameraPos) {
+    Frustum frustum = extractFrustum(viewProjection * model);
+    glm::vec3 eye = glm::vec3(glm::inverse(model) * glm::vec4(cameraPos, 1.0f));
+    cullMeshlets(r.mesh, frustum, eye, r.frameIndices, r.stats);
+
+    bindVertexArray(r.vao);
+    if (r.boundGeneration != mb.generation) {
+        bindMeshBufferAttribs(mb);
+        r.boundGeneration = mb.generation;
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, r.ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, r.frameIndices.size() * sizeof(unsigned int), r.frameIndices.data(), GL_STREAM_DRAW);
+    return (GLsizei)r.frameIndices.size();
+}
+
+inline void printMeshletStats(const MeshletStats& stats) {
+    std::cout << "Meshlets: " << stats.total << " clusters, " << stats.frustumCulled << " frustum-culled, "
+              << stats.backfaceCulled << " backface-culled, " << stats.triangles << " triangles drawn" << std::endl;
+}
+
+inline void destroyMeshletRenderer(MeshletRenderer& r, MeshBuffer& mb) {
+    releaseMesh(mb, r.handle);
+    glDeleteVertexArrays(1, &r.vao);
+    glDeleteBuffers(1, &r.ebo);
+}
+
+// --------------------- Meshlet Benchmark ---------------------
+// High-poly sphere from generateSphere(): cluster build time, then culling
+// from a few viewpoints (each the best of 20 runs).
+inline void benchmarkMeshlets() {
+    using Clock = std::chrono::high_resolution_clock;
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    generateSphere(vertices, indices, 1.0f, 1024, 512);
+    optimizeVertexCache(indices, (unsigned int)(vertices.size() / MESH_VERTEX_FLOATS));
+    optimizeVertexFetch(vertices, indices);
+
+    MeshletMesh mesh;
+    auto start = Clock::now();
+    buildMeshlets(mesh, vertices, indices);
+    double buildMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    std::cout << "Meshlet benchmark: 1024x512 sphere, " << indices.size() / 3 << " triangles, "
+              << mesh.meshlets.size() << " clusters built in " << std::fixed << std::setprecision(2) << buildMs << " ms"
+              << std::endl;
+
+    struct View { const char* name; glm::vec3 eye; glm::vec3 target; float fov; };
+    const View views[] = {
+        { "whole sphere in view", glm::vec3(0.0f, 0.0f, 4.0f), glm::vec3(0.0f), 45.0f },
+        { "close-up",             glm::vec3(0.0f, 0.0f, 1.5f), glm::vec3(0.0f), 45.0f },
+        { "grazing, narrow fov",  glm::vec3(2.0f, 0.0f, 1.2f), glm::vec3(0.0f, 0.0f, 1.0f), 20.0f },
+    };
+    std::vector<unsigned int> out;
+    for (const View& v : views) {
+        glm::mat4 viewProjection = glm::perspective(glm::radians(v.fov), 800.0f / 600.0f, 0.1f, 100.0f) *
+                                   glm::lookAt(v.eye, v.target, glm::vec3(0.0f, 1.0f, 0.0f));
+        Frustum frustum = extractFrustum(viewProjection);
+        MeshletStats stats;
+        double best = 1e30;
+        for (int run = 0; run < 20; ++run) {
+            auto t0 = Clock::now();
+            cullMeshlets(mesh, frustum, v.eye, out, stats);
+            best = std::min(best, std::chrono::duration<double, std::milli>(Clock::now() - t0).count());
+        }
+        std::cout << "  " << std::left << std::setw(22) << v.name << std::right
+                  << std::setw(7) << stats.frustumCulled << " frustum + " << std::setw(6) << stats.backfaceCulled
+                  << " backface culled of " << stats.total << ", " << std::setw(8) << stats.triangles
+                  << " triangles kept (" << std::setprecision(1) << 100.0 * stats.triangles / (indices.size() / 3)
+                  << "%), " << std::setprecision(3) << best << " ms" << std::endl;
+    }
+    std::cout << std::defaultfloat;
+}
+
+#endif
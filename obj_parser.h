@@ -0,0 +1,488 @@
+#ifndef OBJ_PARSER_H
+#define OBJ_PARSER_H
+
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+
+#include "mesh_buffer.h"
+#include "mesh_import.h"
+
+// --------------------- Parallel OBJ Parser ---------------------
+// loadOBJ() reads line by line with strtof and one hash map; this version is
+// the fast path used by importMesh():
+//
+//   1. the file is split into one chunk per thread at line boundaries
+//   2. each thread counts its v/vt/vn lines; a prefix sum gives every chunk
+//      its global attribute offsets (so negative indices resolve locally)
+//   3. each thread parses its chunk straight into the shared attribute
+//      arrays and records its triangulated face corners
+//   4. corners are deduplicated in a hash map split into one shard per
+//      thread by hash; each thread owns a shard and visits the corners of
+//      every chunk in file order, so no locks are needed
+//   5. shards are concatenated and each chunk writes its own index range
+//
+// Floats are parsed with a hand-written decimal parser that handles eight
+// digits at a time with SWAR (SIMD within a register) arithmetic and falls
+// back to strtof for the rare inputs it cannot round exactly, so results
+// match loadOBJ() bit for bit.
+
+const size_t OBJ_MIN_BYTES_PER_THREAD = 256 * 1024;
+
+// True if all eight bytes are ASCII digits
+inline bool isEightDigits(uint64_t v) {
+    return (((v + 0x4646464646464646ull) | (v - 0x3030303030303030ull)) & 0x8080808080808080ull) == 0;
+}
+
+// Eight ASCII digits (little-endian load) to their value
+inline uint32_t parseEightDigits(uint64_t v) {
+    v -= 0x3030303030303030ull;
+    v = (v * 10) + (v >> 8);   // pairs of digits
+    v = (((v & 0x000000FF000000FFull) * (100 + (1000000ull << 32))) +
+         (((v >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32)))) >> 32;
+    return (uint32_t)v;
+}
+
+inline uint64_t loadEightBytes(const char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+// Parses a decimal float at p (leading blanks skipped, never past a newline).
+// Needs 8 readable bytes past the end of the number; the loader pads the file.
+inline float parseObjFloat(const char*& p) {
+    static const double POW10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    while (*p == ' ' || *p == '\t')
+        ++p;
+    const char* start = p;
+    bool negative = *p == '-';
+    if (*p == '-' || *p == '+')
+        ++p;
+
+    uint64_t mantissa = 0;
+    int digits = 0;          // significant digits accumulated
+    int exponent = 0;
+    const char* intStart = p;
+    while (*p == '0')
+        ++p;
+    while (*p >= '0' && *p <= '9') {
+        mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+        ++digits;
+        ++p;
+    }
+    bool sawDigits = p != intStart;
+    if (*p == '.') {
+        ++p;
+        const char* fracStart = p;
+        if (mantissa == 0)
+            while (*p == '0')   // leading zeros of 0.000123 are not significant
+                ++p;
+        while (digits <= 11 && isEightDigits(loadEightBytes(p))) {
+            mantissa = mantissa * 100000000ull + parseEightDigits(loadEightBytes(p));
+            digits += 8;
+            p += 8;
+        }
+        while (*p >= '0' && *p <= '9') {
+            mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+            ++digits;
+            ++p;
+        }
+        exponent = -(int)(p - fracStart);
+        sawDigits = sawDigits || p != fracStart;
+    }
+    if (!sawDigits) {
+        p = start;
+        return 0.0f;
+    }
+    if (*p == 'e' || *p == 'E') {
+        const char* e = p + 1;
+        bool negativeExp = *e == '-';
+        if (*e == '-' || *e == '+')
+            ++e;
+        if (*e >= '0' && *e <= '9') {
+            int value = 0;
+            while (*e >= '0' && *e <= '9') {
+                if (value < 10000)
+                    value = value * 10 + (*e - '0');
+                ++e;
+            }
+            exponent += negativeExp ? -value : value;
+            p = e;
+        }
+    }
+
+    // With an exact mantissa and power of ten the double is correctly rounded,
+    // so rounding it to float is exact unless it lands on a float halfway point
+    if (digits <= 15 && exponent >= -22 && exponent <= 22) {
+        double value = (double)mantissa;
+        value = exponent < 0 ? value / POW10[-exponent] : value * POW10[exponent];
+        uint64_t bits;
+        std::memcpy(&bits, &value, 8);
+        if ((bits & 0x1FFFFFFFull) != 0x10000000ull)
+            return (float)(negative ? -value : value);
+    }
+    char* end;
+    float value = std::strtof(start, &end);
+    p = end;
+    return value;
+}
+
+inline long parseObjInt(const char*& p) {
+    bool negative = *p == '-';
+    if (*p == '-' || *p == '+')
+        ++p;
+    long value = 0;
+    while (*p >= '0' && *p <= '9')
+        value = value * 10 + (*p++ - '0');
+    return negative ? -value : value;
+}
+
+inline const char* skipObjLine(const char* p, const char* end) {
+    const char* nl = (const char*)std::memchr(p, '\n', (size_t)(end - p));
+    return nl ? nl + 1 : end;
+}
+
+// Murmur3 finaliser over the packed corner; low bits pick the slot, high bits the shard
+inline uint64_t hashObjCorner(const ObjCorner& c) {
+    uint64_t h = ((uint64_t)(uint32_t)c.v << 32) ^ ((uint64_t)(uint32_t)c.vt << 16) ^ (uint64_t)(uint32_t)c.vn;
+    h ^= (uint64_t)(uint32_t)c.vn << 48;
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+// Open-addressing map from corner to shard-local vertex id (first-seen order)
+struct ObjCornerShard {
+    std::vector<ObjCorner> slots;
+    std::vector<uint32_t> ids;
+    std::vector<ObjCorner> unique;   // corner of each id
+    size_t mask = 0;
+
+    void init(size_t expected) {
+        size_t capacity = 64;
+        while (capacity < expected * 2)
+            capacity *= 2;
+        slots.assign(capacity, ObjCorner{ -2, 0, 0 });
+        ids.assign(capacity, 0);
+        mask = capacity - 1;
+    }
+
+    uint32_t insert(const ObjCorner& c, uint64_t hash) {
+        if ((unique.size() + 1) * 2 > slots.size())
+            grow();
+        size_t i = (size_t)hash & mask;
+        while (true) {
+            if (slots[i].v == -2) {
+                slots[i] = c;
+                ids[i] = (uint32_t)unique.size();
+                unique.push_back(c);
+                return ids[i];
+            }
+            if (slots[i] == c)
+                return ids[i];
+            i = (i + 1) & mask;
+        }
+    }
+
+    void grow() {
+        std::vector<ObjCorner> oldSlots;
+        std::vector<uint32_t> oldIds;
+        oldSlots.swap(slots);
+        oldIds.swap(ids);
+        slots.assign(oldSlots.size() * 2, ObjCorner{ -2, 0, 0 });
+        ids.assign(slots.size(), 0);
+        mask = slots.size() - 1;
+        for (size_t j = 0; j < oldSlots.size(); ++j) {
+            if (oldSlots[j].v == -2)
+                continue;
+            size_t i = (size_t)hashObjCorner(oldSlots[j]) & mask;
+            while (slots[i].v != -2)
+                i = (i + 1) & mask;
+            slots[i] = oldSlots[j];
+            ids[i] = oldIds[j];
+        }
+    }
+};
+
+struct ObjChunk {
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    size_t positionBase = 0, uvBase = 0, normalBase = 0;
+    size_t positionCount = 0, uvCount = 0, normalCount = 0;
+    std::vector<ObjCorner> corners;                  // three per triangle
+    std::vector<std::vector<uint32_t>> shardItems;   // corner positions per shard
+    std::vector<uint32_t> cornerIds;                 // shard-local vertex id per corner
+    size_t indexBase = 0;
+    bool badIndex = false;
+};
+
+inline void countObjChunk(ObjChunk& c) {
+    for (const char* p = c.begin; p < c.end; p = skipObjLine(p, c.end)) {
+        while (*p == ' ' || *p == '\t')
+            ++p;
+        if (p[0] != 'v')
+            continue;
+        if (p[1] == ' ' || p[1] == '\t')
+            c.positionCount++;
+        else if (p[1] == 't')
+            c.uvCount++;
+        else if (p[1] == 'n')
+            c.normalCount++;
+    }
+}
+
+// Global 0-based index; relative indices count back from this chunk's position
+inline int resolveChunkIndex(long index, size_t before, size_t total) {
+    if (index > 0)
+        return (size_t)index <= total ? (int)(index - 1) : -1;
+    if (index < 0)
+        return (size_t)(-index) <= before ? (int)(before + index) : -1;
+    return -1;
+}
+
+inline void parseObjChunk(ObjChunk& c, std::vector<glm::vec3>& positions, std::vector<glm::vec2>& uvs,
+                          std::vector<glm::vec3>& normals) {
+    size_t pi = c.positionBase, ti = c.uvBase, ni = c.normalBase;
+    for (const char* p = c.begin; p < c.end; p = skipObjLine(p, c.end)) {
+        while (*p == ' ' || *p == '\t')
+            ++p;
+        if (p[0] == 'v' && (p[1] == ' ' || p[1] == '\t')) {
+            p += 2;
+            glm::vec3& v = positions[pi++];
+            v.x = parseObjFloat(p);
+            v.y = parseObjFloat(p);
+            v.z = parseObjFloat(p);
+        } else if (p[0] == 'v' && p[1] == 't') {
+            p += 2;
+            glm::vec2& t = uvs[ti++];
+            t.x = parseObjFloat(p);
+            t.y = parseObjFloat(p);
+        } else if (p[0] == 'v' && p[1] == 'n') {
+            p += 2;
+            glm::vec3& n = normals[ni++];
+            n.x = parseObjFloat(p);
+            n.y = parseObjFloat(p);
+            n.z = parseObjFloat(p);
+        } else if (p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')) {
+            p += 2;
+            ObjCorner first = {}, previous = {};
+            int count = 0;
+            while (true) {
+                while (*p == ' ' || *p == '\t')
+                    ++p;
+                if (!((*p >= '0' && *p <= '9') || *p == '-'))
+                    break;
+                long v = parseObjInt(p), vt = 0, vn = 0;
+                if (*p == '/') {
+                    ++p;
+                    if (*p != '/')
+                        vt = parseObjInt(p);
+                    if (*p == '/') {
+                        ++p;
+                        vn = parseObjInt(p);
+                    }
+                }
+                ObjCorner corner = { resolveChunkIndex(v, pi, positions.size()),
+                                     resolveChunkIndex(vt, ti, uvs.size()),
+                                     resolveChunkIndex(vn, ni, normals.size()) };
+                if (corner.v < 0) {
+                    c.badIndex = true;
+                    return;
+                }
+                // Fan-triangulate as corners arrive
+                if (count == 0)
+                    first = corner;
+                if (count >= 2) {
+                    c.corners.push_back(first);
+                    c.corners.push_back(previous);
+                    c.corners.push_back(corner);
+                }
+                previous = corner;
+                count++;
+            }
+        }
+    }
+}
+
+inline bool loadOBJParallel(const std::string& path, std::vector<float>& vertices, std::vector<unsigned int>& indices,
+                            unsigned int threadCount) {
+    std::vector<char> file;
+    if (!readFileBytes(path, file)) {
+        std::cout << "ERROR::OBJ::FILE_NOT_FOUND: " << path << std::endl;
+        return false;
+    }
+    size_t size = file.size();
+    file.resize(size + 16, '\0');   // terminator and room for 8-byte loads
+    const char* data = file.data();
+
+    if (threadCount == 0) {
+        unsigned int hw = std::max(1u, std::thread::hardware_concurrency());
+        threadCount = (unsigned int)std::min<size_t>(hw, size / OBJ_MIN_BYTES_PER_THREAD);
+    }
+    threadCount = std::max(1u, threadCount);
+    auto runThreads = [&](auto&& work) {
+        std::vector<std::thread> threads;
+        for (unsigned int t = 1; t < threadCount; ++t)
+            threads.emplace_back(work, t);
+        work(0u);
+        for (std::thread& t : threads)
+            t.join();
+    };
+
+    // 1. Chunks end just after a newline
+    std::vector<ObjChunk> chunks(threadCount);
+    const char* cursor = data;
+    for (unsigned int t = 0; t < threadCount; ++t) {
+        chunks[t].begin = cursor;
+        const char* split = std::max(cursor, data + size * (t + 1) / threadCount);
+        cursor = t + 1 == threadCount ? data + size : skipObjLine(split, data + size);
+        chunks[t].end = cursor;
+    }
+
+    // 2. Attribute counts and offsets
+    runThreads([&](unsigned int t) { countObjChunk(chunks[t]); });
+    size_t positionTotal = 0, uvTotal = 0, normalTotal = 0;
+    for (ObjChunk& c : chunks) {
+        c.positionBase = positionTotal;
+        c.uvBase = uvTotal;
+        c.normalBase = normalTotal;
+        positionTotal += c.positionCount;
+        uvTotal += c.uvCount;
+        normalTotal += c.normalCount;
+    }
+    std::vector<glm::vec3> positions(positionTotal), normals(normalTotal);
+    std::vector<glm::vec2> uvs(uvTotal);
+
+    // 3. Parse, then bucket each chunk's corners by shard
+    unsigned int shardCount = threadCount;
+    runThreads([&](unsigned int t) {
+        ObjChunk& c = chunks[t];
+        parseObjChunk(c, positions, uvs, normals);
+        c.shardItems.resize(shardCount);
+        for (std::vector<uint32_t>& items : c.shardItems)
+            items.reserve(c.corners.size() / shardCount + 16);
+        for (size_t i = 0; i < c.corners.size(); ++i)
+            c.shardItems[(hashObjCorner(c.corners[i]) >> 40) % shardCount].push_back((uint32_t)i);
+        c.cornerIds.resize(c.corners.size());
+    });
+    for (const ObjChunk& c : chunks) {
+        if (c.badIndex) {
+            std::cout << "ERROR::OBJ::BAD_INDEX: " << path << std::endl;
+            return false;
+        }
+    }
+
+    // 4. Each thread deduplicates one shard across all chunks, in file order
+    std::vector<ObjCornerShard> shards(shardCount);
+    runThreads([&](unsigned int s) {
+        size_t expected = 0;
+        for (const ObjChunk& c : chunks)
+            expected += c.shardItems[s].size();
+        shards[s].init(expected / 4);   // smooth meshes share each corner ~6 times
+        for (ObjChunk& c : chunks)
+            for (uint32_t i : c.shardItems[s])
+                c.cornerIds[i] = shards[s].insert(c.corners[i], hashObjCorner(c.corners[i]));
+    });
+
+    // 5. Shards are laid out one after another; every thread writes its
+    //    shard's vertices and its chunk's indices
+    std::vector<size_t> shardBase(shardCount);
+    size_t vertexTotal = 0, indexTotal = 0;
+    for (unsigned int s = 0; s < shardCount; ++s) {
+        shardBase[s] = vertexTotal;
+        vertexTotal += shards[s].unique.size();
+    }
+    for (ObjChunk& c : chunks) {
+        c.indexBase = indexTotal;
+        indexTotal += c.corners.size();
+    }
+    vertices.resize(vertexTotal * MESH_VERTEX_FLOATS);
+    indices.resize(indexTotal);
+    runThreads([&](unsigned int t) {
+        float* out = vertices.data() + shardBase[t] * MESH_VERTEX_FLOATS;
+        for (const ObjCorner& c : shards[t].unique) {
+            const glm::vec3& p = positions[c.v];
+            glm::vec3 n = c.vn >= 0 ? normals[c.vn] : glm::vec3(0.0f);
+            glm::vec2 uv = c.vt >= 0 ? uvs[c.vt] : glm::vec2(0.0f, 1.0f);
+            out[0] = p.x; out[1] = p.y; out[2] = p.z;
+            out[3] = n.x; out[4] = n.y; out[5] = n.z;
+            out[6] = uv.x; out[7] = 1.0f - uv.y;
+            out += MESH_VERTEX_FLOATS;
+        }
+        const ObjChunk& c = chunks[t];
+        unsigned int* indexOut = indices.data() + c.indexBase;
+        for (unsigned int s = 0; s < shardCount; ++s)
+            for (uint32_t i : c.shardItems[s])
+                indexOut[i] = (unsigned int)(shardBase[s] + c.cornerIds[i]);
+    });
+
+    fillMissingNormals(vertices, indices);
+    return !indices.empty();
+}
+
+// --------------------- OBJ Parser Benchmark ---------------------
+// loadOBJ() against the parallel parser on 1 thread and on all hardware
+// threads; throughput is file size over the best of three runs.
+inline void benchmarkObjParsing(const std::string& path) {
+    using Clock = std::chrono::high_resolution_clock;
+    uint64_t size;
+    int64_t time;
+    if (!statFile(path, size, time)) {
+        std::cout << "ERROR::OBJ::FILE_NOT_FOUND: " << path << std::endl;
+        return;
+    }
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    auto bestMs = [&](auto&& fn) {
+        double best = 1e30;
+        for (int run = 0; run < 3; ++run) {
+            auto start = Clock::now();
+            fn();
+            best = std::min(best, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+        }
+        return best;
+    };
+
+    unsigned int hw = std::max(1u, std::thread::hardware_concurrency());
+    double mb = size / (1024.0 * 1024.0);
+    std::cout << "OBJ parsing: " << path << " (" << std::fixed << std::setprecision(1) << mb << " MB, "
+              << hw << " hardware threads)" << std::endl;
+
+    double naiveMs = bestMs([&] { loadOBJ(path, vertices, indices); });
+    size_t naiveVertices = vertices.size() / MESH_VERTEX_FLOATS, naiveTriangles = indices.size() / 3;
+    std::cout << "  " << std::left << std::setw(22) << "naive (getline/strtof)" << std::right << std::setw(10)
+              << naiveMs << " ms " << std::setw(8) << mb / (naiveMs / 1000.0) << " MB/s  "
+              << naiveVertices << " vertices, " << naiveTriangles << " triangles" << std::endl;
+
+    unsigned int threadCounts[] = { 1, hw };
+    for (unsigned int threads : threadCounts) {
+        double ms = bestMs([&] { loadOBJParallel(path, vertices, indices, threads); });
+        std::string label = "parallel, " + std::to_string(threads) + (threads == 1 ? " thread" : " threads");
+        bool same = vertices.size() / MESH_VERTEX_FLOATS == naiveVertices && indices.size() / 3 == naiveTriangles;
+        std::cout << "  " << std::left << std::setw(22) << label << std::right << std::setw(10) << ms << " ms "
+                  << std::setw(8) << mb / (ms / 1000.0) << " MB/s  " << std::setprecision(2) << naiveMs / ms
+                  << "x" << (same ? "" : "  MISMATCH") << std::setprecision(1) << std::endl;
+        if (hw == 1)
+            break;
+    }
+    std::cout << std::defaultfloat;
+}
+
+#endif
@@ -0,0 +1,173 @@
+#ifndef PIPELINE_STATE_H
+#define PIPELINE_STATE_H
+
+#include <glad/glad.h>
+
+#include <iostream>
+
+// --------------------- Pipeline State ---------------------
+// A PipelineState bundles what a pass sets up before drawing: program,
+// vertex layout (the VAO), depth test/function/writes, blending and face
+// culling. Passes describe their pipelines once and bind them with
+// bindPipeline(); the tracker compares every field with what the context
+// already has and only issues the calls that change something. Texture
+// bindings are tracked per unit the same way.
+//
+// The tracker is only right if nothing goes around it, so every program, VAO
+// and texture bind in the tree uses useProgram() / bindVertexArray() /
+// bindTexture(), and nothing "unbinds" to 0 after itself. Deleting an object
+// that is still bound unbinds it behind the tracker's back; code that does
+// that at runtime (resizing render targets) calls invalidateGLState().
+
+const int GL_STATE_TEXTURE_UNITS = 16;       // the GL 3.3 minimum per stage
+const int GL_STATE_TEXTURE_TARGETS = 4;      // 2D, cube map, buffer, 2D array
+const unsigned int GL_STATE_UNKNOWN = 0xFFFFFFFF;
+
+struct PipelineState {
+    unsigned int program = 0;
+    unsigned int vao = 0;
+    bool   depthTest = true;
+    GLenum depthFunc = GL_LESS;
+    bool   depthWrite = true;
+    bool   blend = false;
+    GLenum blendSrc = GL_ONE;
+    GLenum blendDst = GL_ZERO;
+    bool   cullFace = false;
+    GLenum cullMode = GL_BACK;
+};
+
+struct GLStateStats {
+    int issued = 0;       // state calls made
+    int avoided = 0;      // calls skipped because the value was already set
+};
+
+// What the context currently has; GL_STATE_UNKNOWN where it can't be trusted
+struct GLStateTracker {
+    unsigned int program, vao;
+    unsigned int depthTest, depthFunc, depthWrite;
+    unsigned int blend, blendSrc, blendDst;
+    unsigned int cullFace, cullMode;
+    unsigned int activeUnit;
+    unsigned int textures[GL_STATE_TEXTURE_UNITS][GL_STATE_TEXTURE_TARGETS];
+    GLStateStats stats;
+};
+
+GLStateTracker glState;
+
+// Forget everything; the next set of each piece of state is issued
+inline void invalidateGLState() {
+    glState.program = glState.vao = GL_STATE_UNKNOWN;
+    glState.depthTest = glState.depthFunc = glState.depthWrite = GL_STATE_UNKNOWN;
+    glState.blend = glState.blendSrc = glState.blendDst = GL_STATE_UNKNOWN;
+    glState.cullFace = glState.cullMode = GL_STATE_UNKNOWN;
+    glState.activeUnit = GL_STATE_UNKNOWN;
+    for (int u = 0; u < GL_STATE_TEXTURE_UNITS; ++u)
+        for (int t = 0; t < GL_STATE_TEXTURE_TARGETS; ++t)
+            glState.textures[u][t] = GL_STATE_UNKNOWN;
+}
+
+// Records the new value; true if it differs and the GL call has to be made
+inline bool stateChanged(unsigned int& tracked, unsigned int value) {
+    if (tracked == value) {
+        glState.stats.avoided++;
+        return false;
+    }
+    tracked = value;
+    glState.stats.issued++;
+    return true;
+}
+
+inline void useProgram(unsigned int program) {
+    if (stateChanged(glState.program, program))
+        glUseProgram(program);
+}
+
+inline void bindVertexArray(unsigned int vao) {
+    if (stateChanged(glState.vao, vao))
+        glBindVertexArray(vao);
+}
+
+inline void setCapability(unsigned int& tracked, GLenum cap, bool enable) {
+    if (stateChanged(tracked, enable ? 1u : 0u)) {
+        if (enable)
+            glEnable(cap);
+        else
+            glDisable(cap);
+    }
+}
+
+inline void setDepthTest(bool enable) {
+    setCapability(glState.depthTest, GL_DEPTH_TEST, enable);
+}
+
+inline void setDepthFunc(GLenum func) {
+    if (stateChanged(glState.depthFunc, func))
+        glDepthFunc(func);
+}
+
+inline void setDepthWrite(bool enable) {
+    if (stateChanged(glState.depthWrite, enable ? 1u : 0u))
+        glDepthMask(enable ? GL_TRUE : GL_FALSE);
+}
+
+inline void setBlend(bool enable, GLenum src, GLenum dst) {
+    setCapability(glState.blend, GL_BLEND, enable);
+    if (!enable)
+        return;
+    bool srcChanged = stateChanged(glState.blendSrc, src);
+    bool dstChanged = stateChanged(glState.blendDst, dst);
+    if (srcChanged || dstChanged)
+        glBlendFunc(src, dst);
+}
+
+inline void setCullFace(bool enable, GLenum mode) {
+    setCapability(glState.cullFace, GL_CULL_FACE, enable);
+    if (enable && stateChanged(glState.cullMode, mode))
+        glCullFace(mode);
+}
+
+inline int textureTargetIndex(GLenum target) {
+    switch (target) {
+    case GL_TEXTURE_2D:       return 0;
+    case GL_TEXTURE_CUBE_MAP: return 1;
+    case GL_TEXTURE_BUFFER:   return 2;
+    case GL_TEXTURE_2D_ARRAY: return 3;
+    default:                  return -1;
+    }
+}
+
+// Bind a texture to a unit. Leaves that unit active, so glTexParameter and
+// glTexImage calls can follow directly.
+inline void bindTexture(int unit, GLenum target, unsigned int texture) {
+    int t = textureTargetIndex(target);
+    if (t < 0 || unit >= GL_STATE_TEXTURE_UNITS) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(target, texture);
+        glState.activeUnit = GL_STATE_UNKNOWN;
+        glState.stats.issued += 2;
+        return;
+    }
+    if (stateChanged(glState.activeUnit, (unsigned int)unit))
+        glActiveTexture(GL_TEXTURE0 + unit);
+    if (stateChanged(glState.textures[unit][t], texture))
+        glBindTexture(target, texture);
+}
+
+inline void bindPipeline(const PipelineState& p) {
+    useProgram(p.program);
+    bindVertexArray(p.vao);
+    setDepthTest(p.depthTest);
+    if (p.depthTest)
+        setDepthFunc(p.depthFunc);
+    setDepthWrite(p.depthWrite);
+    setBlend(p.blend, p.blendSrc, p.blendDst);
+    setCullFace(p.cullFace, p.cullMode);
+}
+
+// Start of frame: reset the counters and make sure clears reach the depth buffer
+inline void beginGLStateFrame() {
+    glState.stats = GLStateStats();
+    setDepthWrite(true);
+}
+
+#endif
@@ -0,0 +1,411 @@
+#ifndef PROCEDURAL_MESH_H
+#define PROCEDURAL_MESH_H
+
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#include "mesh_buffer.h"
+#include "mesh_optimizer.h"
+#include "sphere_generator.h"
+
+// --------------------- Procedural Meshes ---------------------
+// Generators for the basic shapes, all producing the shared 8-float layout
+// with CCW front faces, plus a cache that keys meshes by their parameters so
+// identical requests share one range of the mesh buffer.
+//
+//   shape        params[0..3]                          detail[0], detail[1]
+//   sphere       radius                                sectors, stacks
+//   icosphere    radius                                subdivisions
+//   torus        major radius, tube radius             rings, sides
+//   cylinder     radius, height                        sectors
+//   cone         radius, height                        sectors
+//   plane        width, depth                          x divisions, z divisions
+//   rounded box  width, height, depth, corner radius   segments per face edge
+//
+// Everything is centred on the origin; planes lie in XZ facing +Y, and
+// cylinders/cones run along Y.
+
+enum ProceduralShape {
+    SHAPE_SPHERE,
+    SHAPE_ICOSPHERE,
+    SHAPE_TORUS,
+    SHAPE_CYLINDER,
+    SHAPE_CONE,
+    SHAPE_PLANE,
+    SHAPE_ROUNDED_BOX
+};
+
+struct ProceduralMeshDesc {
+    ProceduralShape shape = SHAPE_SPHERE;
+    float params[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    unsigned int detail[2] = { 0, 0 };
+
+    bool operator==(const ProceduralMeshDesc& o) const {
+        return shape == o.shape && std::memcmp(params, o.params, sizeof(params)) == 0 &&
+               detail[0] == o.detail[0] && detail[1] == o.detail[1];
+    }
+};
+
+inline ProceduralMeshDesc makeMeshDesc(ProceduralShape shape, float p0, float p1, float p2, float p3,
+                                       unsigned int d0, unsigned int d1) {
+    ProceduralMeshDesc d;
+    d.shape = shape;
+    d.params[0] = p0; d.params[1] = p1; d.params[2] = p2; d.params[3] = p3;
+    d.detail[0] = d0; d.detail[1] = d1;
+    return d;
+}
+
+inline ProceduralMeshDesc sphereDesc(float radius, unsigned int sectors, unsigned int stacks) {
+    return makeMeshDesc(SHAPE_SPHERE, radius, 0, 0, 0, sectors, stacks);
+}
+inline ProceduralMeshDesc icosphereDesc(float radius, unsigned int subdivisions) {
+    return makeMeshDesc(SHAPE_ICOSPHERE, radius, 0, 0, 0, subdivisions, 0);
+}
+inline ProceduralMeshDesc torusDesc(float majorRadius, float tubeRadius, unsigned int rings, unsigned int sides) {
+    return makeMeshDesc(SHAPE_TORUS, majorRadius, tubeRadius, 0, 0, rings, sides);
+}
+inline ProceduralMeshDesc cylinderDesc(float radius, float height, unsigned int sectors) {
+    return makeMeshDesc(SHAPE_CYLINDER, radius, height, 0, 0, sectors, 0);
+}
+inline ProceduralMeshDesc coneDesc(float radius, float height, unsigned int sectors) {
+    return makeMeshDesc(SHAPE_CONE, radius, height, 0, 0, sectors, 0);
+}
+inline ProceduralMeshDesc planeDesc(float width, float depth, unsigned int divX, unsigned int divZ) {
+    return makeMeshDesc(SHAPE_PLANE, width, depth, 0, 0, divX, divZ);
+}
+inline ProceduralMeshDesc roundedBoxDesc(float width, float height, float depth, float radius, unsigned int segments) {
+    return makeMeshDesc(SHAPE_ROUNDED_BOX, width, height, depth, radius, segments, 0);
+}
+
+// FNV-1a over the fields (not the struct bytes, which may contain padding)
+inline uint64_t hashMeshDesc(const ProceduralMeshDesc& d) {
+    uint64_t h = 14695981039346656037ull;
+    auto mix = [&h](const void* data, size_t size) {
+        const unsigned char* p = (const unsigned char*)data;
+        for (size_t i = 0; i < size; ++i) {
+            h ^= p[i];
+            h *= 1099511628211ull;
+        }
+    };
+    uint32_t shape = (uint32_t)d.shape;
+    mix(&shape, sizeof(shape));
+    mix(d.params, sizeof(d.params));
+    mix(d.detail, sizeof(d.detail));
+    return h;
+}
+
+// --------------------- Shape Generators ---------------------
+inline void appendVertex(std::vector<float>& v, const glm::vec3& p, const glm::vec3& n, const glm::vec2& uv) {
+    float data[8] = { p.x, p.y, p.z, n.x, n.y, n.z, uv.x, uv.y };
+    v.insert(v.end(), data, data + 8);
+}
+
+// Quads of a (cols+1) x (rows+1) vertex grid starting at `base`, row-major.
+// Front faces follow d(col) x d(row); flip reverses them.
+inline void appendGridIndices(std::vector<unsigned int>& indices, unsigned int base,
+                              unsigned int cols, unsigned int rows, bool flip) {
+    for (unsigned int i = 0; i < rows; ++i) {
+        for (unsigned int j = 0; j < cols; ++j) {
+            unsigned int a = base + i * (cols + 1) + j;
+            unsigned int b = a + cols + 1;
+            unsigned int quad[6] = { a, a + 1, b,  a + 1, b + 1, b };
+            if (flip) {
+                std::swap(quad[1], quad[2]);
+                std::swap(quad[4], quad[5]);
+            }
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+}
+
+// Spherical UVs; the seam is not split, so the last column of triangles
+// stretches across the texture
+inline void generateIcosphere(std::vector<float>& vertices, std::vector<unsigned int>& indices,
+                              float radius, unsigned int subdivisions) {
+    const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+    std::vector<glm::vec3> points = {
+        {-1,  t,  0}, { 1,  t,  0}, {-1, -t,  0}, { 1, -t,  0},
+        { 0, -1,  t}, { 0,  1,  t}, { 0, -1, -t}, { 0,  1, -t},
+        { t,  0, -1}, { t,  0,  1}, {-t,  0, -1}, {-t,  0,  1}
+    };
+    std::vector<unsigned int> faces = {
+        0, 11, 5,   0, 5, 1,    0, 1, 7,    0, 7, 10,   0, 10, 11,
+        1, 5, 9,    5, 11, 4,   11, 10, 2,  10, 7, 6,   7, 1, 8,
+        3, 9, 4,    3, 4, 2,    3, 2, 6,    3, 6, 8,    3, 8, 9,
+        4, 9, 5,    2, 4, 11,   6, 2, 10,   8, 6, 7,    9, 8, 1
+    };
+    for (glm::vec3& p : points)
+        p = glm::normalize(p);
+
+    for (unsigned int s = 0; s < subdivisions; ++s) {
+        std::unordered_map<uint64_t, unsigned int> midpoints;
+        auto midpoint = [&](unsigned int a, unsigned int b) {
+            uint64_t key = ((uint64_t)std::min(a, b) << 32) | std::max(a, b);
+            auto it = midpoints.find(key);
+            if (it != midpoints.end())
+                return it->second;
+            unsigned int index = (unsigned int)points.size();
+            points.push_back(glm::normalize(points[a] + points[b]));
+            midpoints.emplace(key, index);
+            return index;
+        };
+        std::vector<unsigned int> refined;
+        refined.reserve(faces.size() * 4);
+        for (size_t f = 0; f < faces.size(); f += 3) {
+            unsigned int a = faces[f], b = faces[f + 1], c = faces[f + 2];
+            unsigned int ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+            unsigned int tris[12] = { a, ab, ca,  b, bc, ab,  c, ca, bc,  ab, bc, ca };
+            refined.insert(refined.end(), tris, tris + 12);
+        }
+        faces.swap(refined);
+    }
+
+    const float PI = 3.14159265359f;
+    unsigned int base = (unsigned int)(vertices.size() / MESH_VERTEX_FLOATS);
+    for (const glm::vec3& n : points) {
+        glm::vec2 uv(0.5f + std::atan2(n.z, n.x) / (2.0f * PI), 0.5f - std::asin(n.y) / PI);
+        appendVertex(vertices, n * radius, n, uv);
+    }
+    for (unsigned int i : faces)
+        indices.push_back(base + i);
+}
+
+inline void generateTorus(std::vector<float>& vertices, std::vector<unsigned int>& indices,
+                          float majorRadius, float tubeRadius, unsigned int rings, unsigned int sides) {
+    const float PI = 3.14159265359f;
+    unsigned int base = (unsigned int)(vertices.size() / MESH_VERTEX_FLOATS);
+    for (unsigned int i = 0; i <= rings; ++i) {
+        float u = (float)i / rings * 2.0f * PI;
+        glm::vec3 center(majorRadius * std::cos(u), 0.0f, majorRadius * std::sin(u));
+        for (unsigned int j = 0; j <= sides; ++j) {
+            float v = (float)j / sides * 2.0f * PI;
+            glm::vec3 n(std::cos(v) * std::cos(u), std::sin(v), std::cos(v) * std::sin(u));
+            appendVertex(vertices, center + tubeRadius * n, n, glm::vec2((float)i / rings, (float)j / sides));
+        }
+    }
+    appendGridIndices(indices, base, sides, rings, false);
+}
+
+// Flat cap at height y: a centre vertex plus a ring
+inline void appendDiskCap(std::vector<float>& vertices, std::vector<unsigned int>& indices,
+                          float radius, float y, unsigned int sectors, bool facingUp) {
+    const float PI = 3.14159265359f;
+    glm::vec3 n(0.0f, facingUp ? 1.0f : -1.0f, 0.0f);
+    unsigned int center = (unsigned int)(vertices.size() / MESH_VERTEX_FLOATS);
+    appendVertex(vertices, glm::vec3(0.0f, y, 0.0f), n, glm::vec2(0.5f));
+    for (unsigned int j = 0; j <= sectors; ++j) {
+        float a = (float)j / sectors * 2.0f * PI;
+        glm::vec2 d(std::cos(a), std::sin(a));
+        appendVertex(vertices, glm::vec3(radius * d.x, y, radius * d.y), n, 0.5f + 0.5f * d);
+    }
+    for (unsigned int j = 0; j < sectors; ++j) {
+        unsigned int r0 = center + 1 + j, r1 = r0 + 1;
+        unsigned int tri[3] = { center, facingUp ? r1 : r0, facingUp ? r0 : r1 };
+        indices.insert(indices.end(), tri, tri + 3);
+    }
+}
+
+inline void generateCylinder(std::vector<float>& vertices, std::vector<unsigned int>& indices,
+                             float radius, float height, unsigned int sectors) {
+    const float PI = 3.14159265359f;
+    float h = height * 0.5f;
+    unsigned int base = (unsigned int)(vertices.size() / MESH_VERTEX_FLOATS);
+    for (unsigned int i = 0; i <= 1; ++i) {
+        float y = i ? h : -h;
+        for (unsigned int j = 0; j <= sectors; ++j) {
+            float a = (float)j / sectors * 2.0f * PI;
+            glm::vec3 n(std::cos(a), 0.0f, std::sin(a));
+            appendVertex(vertices, glm::vec3(radius * n.x, y, radius * n.z), n, glm::vec2((float)j / sectors, (float)i));
+        }
+    }
+    appendGridIndices(indices, base, sectors, 1, true);
+    appendDiskCap(vertices, indices, radius, h, sectors, true);
+    appendDiskCap(vertices, indices, radius, -h, sectors, false);
+}
+
+// The apex is duplicated per sector so every side triangle gets its own normal
+inline void generateCone(std::vector<float>& vertices, std::vector<unsigned int>& indices,
+                         float radius, float height, unsigned int sectors) {
+    const float PI = 3.14159265359f;
+    float h = height * 0.5f;
+    unsigned int base = (unsigned int)(vertices.size() / MESH_VERTEX_FLOATS);
+    for (unsigned int j = 0; j <= sectors; ++j) {
+        float a = (float)j / sectors * 2.0f * PI;
+        float mid = ((float)j + 0.5f) / sectors * 2.0f * PI;
+        glm::vec3 n = glm::normalize(glm::vec3(height * std::cos(a), radius, height * std::sin(a)));
+        glm::vec3 apexNormal = glm::normalize(glm::vec3(height * std::cos(mid), radius, height * std::sin(mid)));
+        appendVertex(vertices, glm::vec3(radius * std::cos(a), -h, radius * std::sin(a)), n, glm::vec2((float)j / sectors, 0.0f));
+        appendVertex(vertices, glm::vec3(0.0f, h, 0.0f), apexNormal, glm::vec2(((float)j + 0.5f) / sectors, 1.0f));
+    }
+    for (unsigned int j = 0; j < sectors; ++j) {
+        unsigned int ring = base + j * 2;
+        unsigned int tri[3] = { ring, ring + 1, ring + 2 };
+        indices.insert(indices.end(), tri, tri + 3);
+    }
+    appendDiskCap(vertices, indices, radius, -h, sectors, false);
+}
+
+inline void generatePlane(std::vector<float>& vertices, std::vector<unsigned int>& indices,
+                          float width, float depth, unsigned int divX, unsigned int divZ) {
+    unsigned int base = (unsigned int)(vertices.size() / MESH_VERTEX_FLOATS);
+    for (unsigned int i = 0; i <= divZ; ++i) {
+        for (unsigned int j = 0; j <= divX; ++j) {
+            glm::vec2 uv((float)j / divX, (float)i / divZ);
+            appendVertex(vertices, glm::vec3((uv.x - 0.5f) * width, 0.0f, (uv.y - 0.5f) * depth),
+                         glm::vec3(0.0f, 1.0f, 0.0f), uv);
+        }
+    }
+    appendGridIndices(indices, base, divX, divZ, true);
+}
+
+// Each face is a segments x segments grid on the box surface; every vertex is
+// pulled onto the rounded surface by clamping to the inner box (shrunk by the
+// corner radius) and pushing back out along the offset direction.
+inline void generateRoundedBox(std::vector<float>& vertices, std::vector<unsigned int>& indices,
+                               const glm::vec3& size, float radius, unsigned int segments) {
+    glm::vec3 half = size * 0.5f;
+    radius = std::min(radius, std::min(half.x, std::min(half.y, half.z)));
+    glm::vec3 inner = half - glm::vec3(radius);
+
+    // Outward normal, then U and V axes with U x V = normal
+    const glm::vec3 faces[6][3] = {
+        { { 1, 0, 0}, { 0, 0, -1}, {0, 1,  0} },
+        { {-1, 0, 0}, { 0, 0,  1}, {0, 1,  0} },
+        { { 0, 1, 0}, { 1, 0,  0}, {0, 0, -1} },
+        { { 0,-1, 0}, { 1, 0,  0}, {0, 0,  1} },
+        { { 0, 0, 1}, { 1, 0,  0}, {0, 1,  0} },
+        { { 0, 0,-1}, {-1, 0,  0}, {0, 1,  0} }
+    };
+    for (const auto& face : faces) {
+        const glm::vec3& normal = face[0];
+        const glm::vec3& u = face[1];
+        const glm::vec3& v = face[2];
+        float extentU = glm::dot(glm::abs(u), half);
+        float extentV = glm::dot(glm::abs(v), half);
+        unsigned int base = (unsigned int)(vertices.size() / MESH_VERTEX_FLOATS);
+        for (unsigned int i = 0; i <= segments; ++i) {
+            for (unsigned int j = 0; j <= segments; ++j) {
+                glm::vec2 uv((float)j / segments, (float)i / segments);
+                glm::vec3 p = normal * half + u * ((uv.x * 2.0f - 1.0f) * extentU) + v * ((uv.y * 2.0f - 1.0f) * extentV);
+                glm::vec3 core = glm::clamp(p, -inner, inner);
+                glm::vec3 offset = p - core;
+                glm::vec3 n = glm::length(offset) > 1e-6f ? glm::normalize(offset) : normal;
+                appendVertex(vertices, core + n * radius, n, uv);
+            }
+        }
+        appendGridIndices(indices, base, segments, segments, false);
+    }
+}
+
+inline void generateProceduralMesh(const ProceduralMeshDesc& d, std::vector<float>& vertices,
+                                   std::vector<unsigned int>& indices) {
+    unsigned int d0 = std::max(1u, d.detail[0]);
+    unsigned int d1 = std::max(1u, d.detail[1]);
+    switch (d.shape) {
+    case SHAPE_SPHERE:      generateSphereFast(vertices, indices, d.params[0], std::max(3u, d0), std::max(2u, d1)); break;
+    case SHAPE_ICOSPHERE:   generateIcosphere(vertices, indices, d.params[0], d.detail[0]); break;
+    case SHAPE_TORUS:       generateTorus(vertices, indices, d.params[0], d.params[1], std::max(3u, d0), std::max(3u, d1)); break;
+    case SHAPE_CYLINDER:    generateCylinder(vertices, indices, d.params[0], d.params[1], std::max(3u, d0)); break;
+    case SHAPE_CONE:        generateCone(vertices, indices, d.params[0], d.params[1], std::max(3u, d0)); break;
+    case SHAPE_PLANE:       generatePlane(vertices, indices, d.params[0], d.params[1], d0, d1); break;
+    case SHAPE_ROUNDED_BOX: generateRoundedBox(vertices, indices, glm::vec3(d.params[0], d.params[1], d.params[2]), d.params[3], d0); break;
+    }
+}
+
+inline const char* proceduralShapeName(ProceduralShape shape) {
+    switch (shape) {
+    case SHAPE_SPHERE:      return "sphere";
+    case SHAPE_ICOSPHERE:   return "icosphere";
+    case SHAPE_TORUS:       return "torus";
+    case SHAPE_CYLINDER:    return "cylinder";
+    case SHAPE_CONE:        return "cone";
+    case SHAPE_PLANE:       return "plane";
+    case SHAPE_ROUNDED_BOX: return "rounded box";
+    }
+    return "mesh";
+}
+
+// --------------------- Mesh Cache ---------------------
+// Reference-counted: acquire returns the existing mesh for an identical
+// description, release frees the buffer range once the last user is gone.
+struct CachedMesh {
+    ProceduralMeshDesc desc;
+    MeshHandle mesh;
+    int refCount = 0;
+};
+
+struct MeshCacheStats {
+    int entries = 0;
+    size_t bytes = 0;        // mesh buffer space held by cached meshes
+    long long hits = 0;
+    long long misses = 0;
+};
+
+struct MeshCache {
+    // Collisions are chained in the bucket vector and told apart by the full description
+    std::unordered_map<uint64_t, std::vector<CachedMesh>> entries;
+    MeshCacheStats stats;
+};
+
+inline size_t cachedMeshBytes(const MeshBuffer& mb, const MeshHandle& h) {
+    return (size_t)h.vertexCount * meshVertexStride(mb) + (size_t)h.indexCount * sizeof(unsigned int);
+}
+
+inline MeshHandle acquireProceduralMesh(MeshCache& cache, MeshBuffer& mb, const ProceduralMeshDesc& desc) {
+    std::vector<CachedMesh>& bucket = cache.entries[hashMeshDesc(desc)];
+    for (CachedMesh& e : bucket) {
+        if (e.desc == desc) {
+            e.refCount++;
+            cache.stats.hits++;
+            return e.mesh;
+        }
+    }
+
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    generateProceduralMesh(desc, vertices, indices);
+    optimizeMesh(vertices, indices, proceduralShapeName(desc.shape));
+
+    CachedMesh e;
+    e.desc = desc;
+    e.mesh = uploadMesh(mb, vertices.data(), (unsigned int)(vertices.size() / MESH_VERTEX_FLOATS),
+                        indices.data(), (unsigned int)indices.size());
+    e.refCount = 1;
+    bucket.push_back(e);
+    cache.stats.entries++;
+    cache.stats.bytes += cachedMeshBytes(mb, e.mesh);
+    cache.stats.misses++;
+    return e.mesh;
+}
+
+inline void releaseProceduralMesh(MeshCache& cache, MeshBuffer& mb, const ProceduralMeshDesc& desc) {
+    auto it = cache.entries.find(hashMeshDesc(desc));
+    if (it == cache.entries.end())
+        return;
+    std::vector<CachedMesh>& bucket = it->second;
+    for (size_t i = 0; i < bucket.size(); ++i) {
+        if (!(bucket[i].desc == desc) || --bucket[i].refCount > 0)
+            continue;
+        cache.stats.entries--;
+        cache.stats.bytes -= cachedMeshBytes(mb, bucket[i].mesh);
+        releaseMesh(mb, bucket[i].mesh);
+        bucket.erase(bucket.begin() + i);
+        if (bucket.empty())
+            cache.entries.erase(it);
+        return;
+    }
+}
+
+inline void printMeshCacheStats(const MeshCache& cache) {
+    std::cout << "Mesh cache: " << cache.stats.entries << " entries, " << cache.stats.bytes / 1024 << " KB, "
+              << cache.stats.hits << " hits, " << cache.stats.misses << " misses" << std::endl;
+}
+
+#endif
@@ -0,0 +1,237 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+
+#include "mesh_buffer.h"
+#include "pipeline_state.h"
+
+// --------------------- Render Queue ---------------------
+// Opaque draws are recorded as commands during the frame, then sorted by a
+// 64-bit key and submitted in one pass that skips any state that is already
+// set. Key layout, most significant first:
+//
+//   63..52  program  (12 bits)
+//   51..40  texture  (12 bits, 0 = untextured)
+//   39..28  VAO      (12 bits)
+//   27..0   depth    (28 bits, view distance quantised, near first)
+//
+// GL names are small integers, so their low 12 bits are used directly. A
+// collision only weakens grouping; submission compares the real names.
+// Inside one state group draws go front to back, so early-Z rejects more.
+
+struct DrawCommand {
+    unsigned int program = 0;
+    unsigned int vao = 0;
+    unsigned int texture = 0;        // 0 = solid color
+    glm::vec3 color = glm::vec3(1.0f);
+    glm::mat4 model = glm::mat4(1.0f);
+    GLenum  mode = GL_TRIANGLES;
+    GLsizei count = 0;
+    bool    indexed = false;
+    size_t  indexOffset = 0;         // bytes, indexed draws
+    GLint   baseVertex = 0;          // indexed: base vertex, arrays: first vertex
+    float   depth = 0.0f;            // sort distance from the camera
+};
+
+struct RenderQueueStats {
+    int draws = 0;
+    int drawCalls = 0;        // GL draw calls issued for them
+    int stateRequested = 0;   // program/VAO/texture/material sets the draws asked for
+    int stateIssued = 0;      // GL calls actually made for them
+};
+
+// Uniform locations and last uploaded material per program. Uniform values
+// live in the program object, so they stay valid across frames and program
+// switches as long as nothing outside the queue sets them. Shader variants
+// built for textured or untextured materials have no useTexture uniform
+// (location -1); only programs shared by both kinds switch it per draw.
+struct ProgramState {
+    unsigned int program = 0;
+    GLint modelLoc = -1;
+    GLint useTextureLoc = -1;
+    GLint colorLoc = -1;
+    int useTexture = -1;
+    glm::vec3 color = glm::vec3(-1.0f);
+};
+
+struct RenderQueue {
+    std::vector<DrawCommand> commands;
+    std::vector<uint64_t> keys, keysTmp;
+    std::vector<uint32_t> order, orderTmp;
+    std::vector<ProgramState> programs;
+    PipelineState pipeline;          // fixed-function state of every queued draw (opaque)
+    RenderQueueStats stats;
+};
+
+// Point a command at a mesh in the shared mesh buffer
+inline void setDrawMesh(DrawCommand& cmd, const MeshBuffer& mb, const MeshHandle& mesh) {
+    cmd.vao = mb.vao;
+    cmd.indexed = true;
+    cmd.count = mesh.indexCount;
+    cmd.indexOffset = mesh.indexOffset();
+    cmd.baseVertex = mesh.baseVertex;
+}
+
+inline void beginRenderQueue(RenderQueue& q) {
+    q.commands.clear();
+    q.stats = RenderQueueStats();
+}
+
+inline void pushDraw(RenderQueue& q, const DrawCommand& cmd) {
+    q.commands.push_back(cmd);
+}
+
+inline uint64_t makeSortKey(const DrawCommand& cmd, float maxDepth) {
+    float d = glm::clamp(cmd.depth / maxDepth, 0.0f, 1.0f);
+    // In double: the 28-bit maximum rounds up to 1 << 28 as a float, into the VAO field
+    uint64_t depthBits = (uint64_t)(d * (double)((1u << 28) - 1));
+    return ((uint64_t)(cmd.program & 0xFFF) << 52) |
+           ((uint64_t)(cmd.texture & 0xFFF) << 40) |
+           ((uint64_t)(cmd.vao     & 0xFFF) << 28) |
+           depthBits;
+}
+
+// LSD radix sort, 8 bits per pass, carrying the command index with each key.
+// Passes where every key has the same digit (common for the state bits) are
+// skipped.
+inline void radixSortKeys(std::vector<uint64_t>& keys, std::vector<uint32_t>& values,
+                          std::vector<uint64_t>& keysTmp, std::vector<uint32_t>& valuesTmp) {
+    size_t n = keys.size();
+    if (n < 2)
+        return;
+    keysTmp.resize(n);
+    valuesTmp.resize(n);
+    for (int shift = 0; shift < 64; shift += 8) {
+        size_t counts[256] = {0};
+        for (size_t i = 0; i < n; ++i)
+            counts[(keys[i] >> shift) & 0xFF]++;
+        if (counts[(keys[0] >> shift) & 0xFF] == n)
+            continue;
+
+        size_t offset = 0;
+        for (int b = 0; b < 256; ++b) {
+            size_t c = counts[b];
+            counts[b] = offset;
+            offset += c;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            size_t dst = counts[(keys[i] >> shift) & 0xFF]++;
+            keysTmp[dst] = keys[i];
+            valuesTmp[dst] = values[i];
+        }
+        keys.swap(keysTmp);
+        values.swap(valuesTmp);
+    }
+}
+
+inline ProgramState& programState(RenderQueue& q, unsigned int program) {
+    for (ProgramState& p : q.programs)
+        if (p.program == program)
+            return p;
+    ProgramState p;
+    p.program = program;
+    p.modelLoc = glGetUniformLocation(program, "model");
+    p.useTextureLoc = glGetUniformLocation(program, "useTexture");
+    p.colorLoc = glGetUniformLocation(program, "objectColor");
+    useProgram(program);
+    glUniform1i(glGetUniformLocation(program, "texture1"), 0);
+    q.programs.push_back(p);
+    return q.programs.back();
+}
+
+// Sort the queued commands; q.order then lists them in submission order
+inline void sortRenderQueue(RenderQueue& q, float maxDepth) {
+    size_t n = q.commands.size();
+    q.keys.resize(n);
+    q.order.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        q.keys[i] = makeSortKey(q.commands[i], maxDepth);
+        q.order[i] = (uint32_t)i;
+    }
+    radixSortKeys(q.keys, q.order, q.keysTmp, q.orderTmp);
+
+    // Make sure every program has its locations cached before tracking starts
+    for (size_t i = 0; i < n; ++i)
+        programState(q, q.commands[i].program);
+}
+
+// Uniform tracking for the program of the last submitted command. Bindings
+// are left to the GL state tracker, which also skips them across passes.
+struct SubmitState {
+    unsigned int program = 0;
+    ProgramState* ps = nullptr;
+};
+
+inline void beginSubmit(SubmitState& st) {
+    st = SubmitState();
+}
+
+// Bind the pipeline (queue state + the command's program and VAO) and the
+// material of a command, skipping what's already set. Texture unit 0 is used
+// for the diffuse texture of every command.
+inline void applyDrawState(RenderQueue& q, SubmitState& st, const DrawCommand& cmd) {
+    q.stats.stateRequested += 3; // program, VAO, texture or color
+
+    if (cmd.program != st.program) {
+        st.program = cmd.program;
+        st.ps = &programState(q, cmd.program);
+    }
+    PipelineState pipeline = q.pipeline;
+    pipeline.program = cmd.program;
+    pipeline.vao = cmd.vao;
+    int issued = glState.stats.issued;
+    bindPipeline(pipeline);
+    if (cmd.texture != 0)
+        bindTexture(0, GL_TEXTURE_2D, cmd.texture);
+    q.stats.stateIssued += glState.stats.issued - issued;
+
+    int useTexture = cmd.texture != 0 ? 1 : 0;
+    if (st.ps->useTextureLoc >= 0) {
+        q.stats.stateRequested++;
+        if (useTexture != st.ps->useTexture) {
+            glUniform1i(st.ps->useTextureLoc, useTexture);
+            st.ps->useTexture = useTexture;
+            q.stats.stateIssued++;
+        }
+    }
+    if (!useTexture && st.ps->colorLoc >= 0 && cmd.color != st.ps->color) {
+        glUniform3fv(st.ps->colorLoc, 1, glm::value_ptr(cmd.color));
+        st.ps->color = cmd.color;
+        q.stats.stateIssued++;
+    }
+}
+
+inline void submitDrawCommand(RenderQueue& q, SubmitState& st, const DrawCommand& cmd) {
+    applyDrawState(q, st, cmd);
+    glUniformMatrix4fv(st.ps->modelLoc, 1, GL_FALSE, glm::value_ptr(cmd.model));
+    if (cmd.indexed)
+        glDrawElementsBaseVertex(cmd.mode, cmd.count, GL_UNSIGNED_INT, (void*)cmd.indexOffset, cmd.baseVertex);
+    else
+        glDrawArrays(cmd.mode, cmd.baseVertex, cmd.count);
+    q.stats.draws++;
+    q.stats.drawCalls++;
+}
+
+// Sort and submit everything queued this frame, one GL draw per command
+inline void flushRenderQueue(RenderQueue& q, float maxDepth) {
+    sortRenderQueue(q, maxDepth);
+    SubmitState st;
+    beginSubmit(st);
+    for (size_t i = 0; i < q.order.size(); ++i)
+        submitDrawCommand(q, st, q.commands[q.order[i]]);
+}
+
+// Eliminated = requested - issued
+inline int stateChangesEliminated(const RenderQueueStats& stats) {
+    return stats.stateRequested - stats.stateIssued;
+}
+
+#endif
@@ -0,0 +1,416 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <glad/glad.h>
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+#include "gl_ext.h"
+
+// --------------------- Program Binary Cache ---------------------
+// Linked programs are saved with glGetProgramBinary and restored with
+// glProgramBinary on later runs, skipping compile and link. Each file is
+// named after a hash of every stage's source plus the GL vendor, renderer and
+// version strings, so a driver update or an edited shader simply misses. A
+// binary the driver refuses (GL_LINK_STATUS false after glProgramBinary) is
+// recompiled and overwritten. Without program binary support, or with
+// --no-shader-cache, everything compiles as before.
+//
+// Compiling is asynchronous: no status is queried when a program is
+// submitted, so drivers that compile on their own threads keep working
+// while the caller goes on. Between beginProgramBatch() and
+// endProgramBatch() programs are only submitted; pollProgramBatch() finishes
+// those that are done (GL_COMPLETION_STATUS_KHR, when
+// KHR_parallel_shader_compile is available) and endProgramBatch() waits for
+// the rest. Outside a batch, createCachedProgram() returns a finished program.
+
+const uint32_t PROGRAM_CACHE_VERSION = 1;
+
+struct ShaderStageSource {
+    GLenum type;
+    const char* source;
+};
+
+// Linked but not yet checked: status queries would wait for the compiler
+struct PendingProgram {
+    unsigned int program = 0;
+    std::vector<unsigned int> shaders;
+    uint64_t key = 0;
+};
+
+struct ProgramCache {
+    bool enabled = false;
+    std::string directory = "shader_cache";
+    uint64_t driverHash = 0;
+    int hits = 0;
+    int compiles = 0;
+    int rejected = 0;        // cached binaries the driver no longer accepts
+    double hitMs = 0.0;
+    double compileMs = 0.0;      // submitting, plus waiting outside batches
+
+    // Batched compilation
+    bool batching = false;
+    std::vector<PendingProgram> pending;
+    int batchSize = 0;
+    int finishedEarly = 0;       // completed before endProgramBatch()
+    double waitMs = 0.0;         // blocked in endProgramBatch()
+    int waitedFor = 0;           // programs still compiling at that point
+};
+
+struct ProgramCacheHeader {
+    char magic[4];           // "PBIN"
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;
+    uint32_t length;
+};
+
+ProgramCache programCache;
+
+inline uint64_t fnv1a64(const void* data, size_t size, uint64_t hash = 0xCBF29CE484222325ull) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+inline uint64_t fnv1a64(const char* text, uint64_t hash = 0xCBF29CE484222325ull) {
+    return fnv1a64(text, text ? std::strlen(text) : 0, hash);
+}
+
+inline void makeDirectory(const std::string& path) {
+#ifdef _WIN32
+    _mkdir(path.c_str());
+#else
+    mkdir(path.c_str(), 0755);
+#endif
+}
+
+// Call once the context is current
+inline void initProgramCache(ProgramCache& c, bool enable) {
+    c.enabled = enable && glCaps.programBinary;
+    if (!c.enabled)
+        return;
+    c.driverHash = fnv1a64((const char*)glGetString(GL_VENDOR));
+    c.driverHash = fnv1a64((const char*)glGetString(GL_RENDERER), c.driverHash);
+    c.driverHash = fnv1a64((const char*)glGetString(GL_VERSION), c.driverHash);
+    makeDirectory(c.directory);
+}
+
+inline uint64_t programCacheKey(const ProgramCache& c, const ShaderStageSource* stages, int stageCount) {
+    uint64_t key = c.driverHash;
+    for (int i = 0; i < stageCount; ++i) {
+        key = fnv1a64(&stages[i].type, sizeof(GLenum), key);
+        key = fnv1a64(stages[i].source, key);
+    }
+    return key;
+}
+
+inline std::string programCachePath(const ProgramCache& c, uint64_t key) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    return c.directory + "/" + name;
+}
+
+inline bool programLinked(unsigned int program) {
+    int success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    return success != 0;
+}
+
+// 0 if there is no usable binary for this key
+inline unsigned int loadProgramBinary(ProgramCache& c, uint64_t key) {
+    std::ifstream file(programCachePath(c, key), std::ios::binary);
+    if (!file)
+        return 0;
+    ProgramCacheHeader h;
+    if (!file.read((char*)&h, sizeof(h)) || std::memcmp(h.magic, "PBIN", 4) != 0 ||
+        h.version != PROGRAM_CACHE_VERSION || h.key != key)
+        return 0;
+    // The length comes from the file: a corrupt header must not size the allocation
+    std::streamoff start = file.tellg();
+    file.seekg(0, std::ios::end);
+    std::streamoff remaining = file.tellg() - start;
+    file.seekg(start);
+    if (h.length == 0 || remaining < 0 || (uint64_t)h.length > (uint64_t)remaining)
+        return 0;
+    std::vector<char> binary(h.length);
+    if (!file.read(binary.data(), (std::streamsize)binary.size()))
+        return 0;
+
+    unsigned int program = glCreateProgram();
+    glProgramBinary(program, (GLenum)h.format, binary.data(), (GLsizei)binary.size());
+    if (!programLinked(program)) {
+        glDeleteProgram(program);
+        c.rejected++;
+        return 0;
+    }
+    return program;
+}
+
+inline void saveProgramBinary(const ProgramCache& c, uint64_t key, unsigned int program) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    ProgramCacheHeader h;
+    std::memcpy(h.magic, "PBIN", 4);
+    h.version = PROGRAM_CACHE_VERSION;
+    h.key = key;
+    h.format = format;
+    h.length = (uint32_t)length;
+    std::string path = programCachePath(c, key);
+    std::string temp = path + ".tmp";
+    bool ok;
+    {
+        std::ofstream file(temp, std::ios::binary);
+        file.write((const char*)&h, sizeof(h));
+        file.write(binary.data(), length);
+        file.close();
+        ok = !file.fail();
+    }
+#ifdef _WIN32
+    // rename() replaces the old entry atomically elsewhere, but not on Windows
+    if (ok)
+        std::remove(path.c_str());
+#endif
+    if (!ok || std::rename(temp.c_str(), path.c_str()) != 0)
+        std::remove(temp.c_str());
+}
+
+// Compile every stage and start the link; nothing waits for the driver
+inline PendingProgram submitProgram(const ShaderStageSource* stages, int stageCount, bool retrievable) {
+    PendingProgram p;
+    for (int i = 0; i < stageCount; ++i) {
+        unsigned int shader = glCreateShader(stages[i].type);
+        glShaderSource(shader, 1, &stages[i].source, nullptr);
+        glCompileShader(shader);
+        p.shaders.push_back(shader);
+    }
+    p.program = glCreateProgram();
+    for (unsigned int shader : p.shaders)
+        glAttachShader(p.program, shader);
+    if (retrievable)
+        glProgramParameteri(p.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(p.program);
+    return p;
+}
+
+inline bool programCompleted(const PendingProgram& p) {
+    if (!glCaps.parallelShaderCompile)
+        return false;   // any query would block
+    int done = 0;
+    glGetProgramiv(p.program, GL_COMPLETION_STATUS_KHR, &done);
+    return done != 0;
+}
+
+// Blocks until the program is linked; reports errors, stores the binary and frees the shaders
+inline bool finishProgram(ProgramCache& c, PendingProgram& p) {
+    bool linked = programLinked(p.program);
+    if (!linked) {
+        char infoLog[512];
+        for (unsigned int shader : p.shaders) {
+            int compiled = 0;
+            glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+            if (!compiled) {
+                glGetShaderInfoLog(shader, 512, nullptr, infoLog);
+                std::cout << "ERROR::SHADER_COMPILATION_ERROR:\n" << infoLog << std::endl;
+            }
+        }
+        glGetProgramInfoLog(p.program, 512, nullptr, infoLog);
+        std::cout << "ERROR::PROGRAM_LINKING_ERROR:\n" << infoLog << std::endl;
+    } else if (c.enabled) {
+        saveProgramBinary(c, p.key, p.program);
+    }
+    for (unsigned int shader : p.shaders)
+        glDeleteShader(shader);
+    p.shaders.clear();
+    return linked;
+}
+
+// The program name is usable immediately; inside a batch it may still be compiling
+inline unsigned int createCachedProgram(ProgramCache& c, const ShaderStageSource* stages, int stageCount) {
+    using Clock = std::chrono::high_resolution_clock;
+    auto start = Clock::now();
+    uint64_t key = 0;
+    if (c.enabled) {
+        key = programCacheKey(c, stages, stageCount);
+        if (unsigned int program = loadProgramBinary(c, key)) {
+            c.hits++;
+            c.hitMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            return program;
+        }
+    }
+    PendingProgram p = submitProgram(stages, stageCount, c.enabled);
+    p.key = key;
+    c.compiles++;
+    if (c.batching)
+        c.pending.push_back(p);
+    else
+        finishProgram(c, p);
+    c.compileMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return p.program;
+}
+
+inline void beginProgramBatch(ProgramCache& c) {
+    c.batching = true;
+    c.batchSize = c.compiles;
+    c.finishedEarly = 0;
+    if (glCaps.parallelShaderCompile)
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);   // as many as the driver likes
+}
+
+// Finish whatever has completed; returns the number still compiling
+inline int pollProgramBatch(ProgramCache& c) {
+    for (size_t i = 0; i < c.pending.size();) {
+        if (programCompleted(c.pending[i])) {
+            finishProgram(c, c.pending[i]);
+            c.finishedEarly++;
+            c.pending[i] = c.pending.back();
+            c.pending.pop_back();
+        } else {
+            ++i;
+        }
+    }
+    return (int)c.pending.size();
+}
+
+inline void endProgramBatch(ProgramCache& c) {
+    using Clock = std::chrono::high_resolution_clock;
+    pollProgramBatch(c);
+    auto start = Clock::now();
+    int waited = (int)c.pending.size();
+    for (PendingProgram& p : c.pending)
+        finishProgram(c, p);
+    c.pending.clear();
+    c.waitMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    c.waitedFor = waited;
+    c.batching = false;
+    c.batchSize = c.compiles - c.batchSize;
+}
+
+inline void printProgramCacheStats(const ProgramCache& c) {
+    std::cout << "Shader programs: " << c.hits + c.compiles << " total, " << c.hits << " from "
+              << (c.enabled ? c.directory : std::string("cache (disabled)")) << " in " << std::fixed
+              << std::setprecision(1) << c.hitMs << " ms, " << c.compiles << " compiled in " << c.compileMs << " ms";
+    if (c.rejected > 0)
+        std::cout << " (" << c.rejected << " stale binaries rejected)";
+    std::cout << std::endl;
+    if (c.batchSize > 0)
+        std::cout << "Shader compile: " << c.batchSize << " programs submitted up front, " << c.finishedEarly
+                  << " finished while loading" << (glCaps.parallelShaderCompile ? "" : " (no parallel compile extension)")
+                  << ", waited " << c.waitMs << " ms for " << c.waitedFor << std::endl;
+    std::cout << std::defaultfloat;
+}
+
+// --------------------- Program Cache Benchmark ---------------------
+// Builds N variants of the object shader (one #define apart, plus a per-run
+// value so the driver's own shader cache cannot serve them) three ways:
+// compiled without the cache, compiled and stored, then loaded back. The
+// compiles are submitted together, so a parallel-compiling driver overlaps them.
+inline void benchmarkProgramCache(const char* vertexSrc, const char* fragmentSrc) {
+    using Clock = std::chrono::high_resolution_clock;
+    if (!glCaps.programBinary) {
+        std::cout << "Program binaries unsupported by this driver, nothing to benchmark" << std::endl;
+        return;
+    }
+    ProgramCache cache;
+    cache.directory = "shader_cache/bench";
+    makeDirectory("shader_cache");
+    initProgramCache(cache, true);
+    long long nonce = (long long)std::chrono::system_clock::now().time_since_epoch().count();
+
+    // Insert a #define after the #version line
+    auto variant = [](const char* src, const std::string& define) {
+        std::string s(src);
+        size_t line = s.find('\n', s.find("#version"));
+        return s.insert(line + 1, define + "\n");
+    };
+    auto elapsedMs = [](Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+
+    std::cout << "Program cache benchmark (ms for N programs)" << std::endl;
+    std::cout << std::setw(6) << "N" << std::setw(12) << "compile" << std::setw(16) << "compile+store"
+              << std::setw(12) << "cached" << std::setw(10) << "speedup" << std::endl;
+    for (int count = 1; count <= 64; count *= 4) {
+        std::vector<std::string> vs(count), fs(count), vsCached(count), fsCached(count);
+        for (int i = 0; i < count; ++i) {
+            std::string tag = "#define VARIANT_" + std::to_string(i) + " " + std::to_string(nonce + count);
+            vs[i] = variant(vertexSrc, tag + "1");
+            fs[i] = variant(fragmentSrc, tag + "1");
+            vsCached[i] = variant(vertexSrc, tag + "2");
+            fsCached[i] = variant(fragmentSrc, tag + "2");
+        }
+        std::vector<unsigned int> programs;
+        auto finish = [&]() {   // glGetProgramiv forces the work to complete
+            for (unsigned int p : programs) {
+                programLinked(p);
+                glDeleteProgram(p);
+            }
+            programs.clear();
+        };
+
+        auto start = Clock::now();
+        ProgramCache uncached;
+        std::vector<PendingProgram> submitted;
+        for (int i = 0; i < count; ++i) {
+            ShaderStageSource stages[] = { { GL_VERTEX_SHADER, vs[i].c_str() }, { GL_FRAGMENT_SHADER, fs[i].c_str() } };
+            submitted.push_back(submitProgram(stages, 2, false));
+        }
+        for (PendingProgram& p : submitted) {
+            finishProgram(uncached, p);
+            programs.push_back(p.program);
+        }
+        finish();
+        double compileMs = elapsedMs(start);
+
+        start = Clock::now();
+        beginProgramBatch(cache);
+        for (int i = 0; i < count; ++i) {
+            ShaderStageSource stages[] = { { GL_VERTEX_SHADER, vsCached[i].c_str() }, { GL_FRAGMENT_SHADER, fsCached[i].c_str() } };
+            programs.push_back(createCachedProgram(cache, stages, 2));
+        }
+        endProgramBatch(cache);
+        finish();
+        double storeMs = elapsedMs(start);
+
+        start = Clock::now();
+        for (int i = 0; i < count; ++i) {
+            ShaderStageSource stages[] = { { GL_VERTEX_SHADER, vsCached[i].c_str() }, { GL_FRAGMENT_SHADER, fsCached[i].c_str() } };
+            programs.push_back(createCachedProgram(cache, stages, 2));
+        }
+        finish();
+        double cachedMs = elapsedMs(start);
+
+        std::cout << std::fixed << std::setprecision(1) << std::setw(6) << count << std::setw(12) << compileMs
+                  << std::setw(16) << storeMs << std::setw(12) << cachedMs << std::setw(9)
+                  << compileMs / std::max(cachedMs, 0.001) << "x" << std::endl;
+        for (int i = 0; i < count; ++i) {
+            ShaderStageSource stages[] = { { GL_VERTEX_SHADER, vsCached[i].c_str() }, { GL_FRAGMENT_SHADER, fsCached[i].c_str() } };
+            std::remove(programCachePath(cache, programCacheKey(cache, stages, 2)).c_str());
+        }
+    }
+    std::cout << std::defaultfloat;
+}
+
+#endif
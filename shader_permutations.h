@@ -0,0 +1,311 @@
+#ifndef SHADER_PERMUTATIONS_H
+#define SHADER_PERMUTATIONS_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+
+#include "gl_ext.h"
+#include "shader_cache.h"
+#include "render_queue.h"
+
+// --------------------- Shader Permutations ---------------------
+// One shader source is specialised into variants by #defines inserted after
+// its #version line, so each variant only contains the code its material
+// needs and the fragment shader has no per-fragment feature branches:
+//
+//   TEXTURED          diffuse color from texture1 (otherwise objectColor)
+//   DYNAMIC_TEXTURE   texture or color picked per draw by the useTexture
+//                     uniform; only for programs shared by mixed draws
+//                     (batched indirect draws)
+//   LIGHTING_MODEL    0 unlit, 1 Lambert, 2 Phong, 3 Blinn-Phong
+//   FOG               exponential-squared distance fog
+//   SHADOWS           multiplies direct light by shadowFactor(), whose
+//                     source the shadow pass registers in shadowSource;
+//                     requests are dropped while none is registered
+//   IBL               ambient from SH irradiance and reflections from the
+//                     prefiltered sky (environment_lighting.h)
+//   CLUSTERED         adds the point and spot lights of the fragment's
+//                     cluster with addClusteredLights(), from clusterSource
+//                     like shadowFactor() (clustered_lighting.h)
+//
+// A variant key packs the feature bits and the lighting model. Materials ask
+// for their key at draw time; variants that don't exist yet are submitted
+// without waiting, and the draw uses an already built variant with the same
+// texturing until updateShaderPermutations() finds the compile finished.
+// With KHR_parallel_shader_compile the driver compiles on its own threads;
+// without it the finish blocks, one frame after the submit.
+
+enum ShaderFeature : uint32_t {
+    SHADER_TEXTURED        = 1u << 0,
+    SHADER_DYNAMIC_TEXTURE = 1u << 1,
+    SHADER_FOG             = 1u << 2,
+    SHADER_SHADOWS         = 1u << 3,
+    SHADER_IBL             = 1u << 4,
+    SHADER_CLUSTERED       = 1u << 5,
+};
+
+enum LightingModel : uint32_t {
+    LIGHTING_UNLIT = 0,
+    LIGHTING_LAMBERT = 1,
+    LIGHTING_PHONG = 2,
+    LIGHTING_BLINN_PHONG = 3,
+};
+
+const uint32_t SHADER_FEATURE_MASK = 0x3F;
+const uint32_t SHADER_TEXTURE_MASK = SHADER_TEXTURED | SHADER_DYNAMIC_TEXTURE;
+const int SHADER_LIGHTING_SHIFT = 6;
+
+struct Material {
+    unsigned int texture = 0;        // 0 = solid color
+    glm::vec3 color = glm::vec3(1.0f);
+    LightingModel lighting = LIGHTING_PHONG;
+};
+
+struct ShaderVariant {
+    uint32_t key = 0;
+    unsigned int program = 0;
+    bool ready = false;
+    bool failed = false;
+    bool compiling = false;
+    int framesWaited = 0;
+    PendingProgram pending;
+    std::chrono::high_resolution_clock::time_point submitted;
+};
+
+struct ShaderPermutations {
+    const char* vertexSrc = nullptr;
+    const char* fragmentSrc = nullptr;
+    uint32_t sceneFeatures = 0;      // added to every material (fog, IBL, clustered lights)
+    std::string shadowSource;        // defines shadowFactor(); empty = no shadows yet
+    std::string clusterSource;       // defines addClusteredLights(); empty = no clustered lights
+    std::vector<ShaderVariant> variants;
+    int lazyCompiles = 0;
+    int fallbackDraws = 0;           // draws that used a stand-in variant
+};
+
+inline uint32_t shaderVariantKey(uint32_t features, LightingModel lighting) {
+    return (features & SHADER_FEATURE_MASK) | ((uint32_t)lighting << SHADER_LIGHTING_SHIFT);
+}
+
+inline LightingModel variantLighting(uint32_t key) {
+    return (LightingModel)(key >> SHADER_LIGHTING_SHIFT);
+}
+
+inline std::string shaderVariantName(uint32_t key) {
+    static const char* lightingNames[] = { "unlit", "lambert", "phong", "blinn-phong" };
+    std::string name = (key & SHADER_TEXTURED) ? "textured" : (key & SHADER_DYNAMIC_TEXTURE) ? "dynamic-texture" : "color";
+    name += std::string(" ") + lightingNames[variantLighting(key) & 3];
+    if (key & SHADER_FOG)
+        name += " fog";
+    if (key & SHADER_SHADOWS)
+        name += " shadows";
+    if (key & SHADER_IBL)
+        name += " ibl";
+    if (key & SHADER_CLUSTERED)
+        name += " clustered";
+    return name;
+}
+
+// The source with the key's #defines (and extra declarations) after #version
+inline std::string shaderVariantSource(const char* src, uint32_t key, const std::string& extra = std::string()) {
+    std::string defines;
+    if (key & SHADER_TEXTURED)
+        defines += "#define TEXTURED\n";
+    if (key & SHADER_DYNAMIC_TEXTURE)
+        defines += "#define DYNAMIC_TEXTURE\n";
+    defines += "#define LIGHTING_MODEL " + std::to_string(variantLighting(key)) + "\n";
+    if (key & SHADER_FOG)
+        defines += "#define FOG\n";
+    if (key & SHADER_SHADOWS)
+        defines += "#define SHADOWS\n";
+    if (key & SHADER_IBL)
+        defines += "#define IBL\n";
+    if (key & SHADER_CLUSTERED)
+        defines += "#define CLUSTERED\n";
+    defines += extra;
+
+    std::string s(src);
+    size_t line = s.find('\n', s.find("#version"));
+    return s.insert(line + 1, defines);
+}
+
+inline void initShaderPermutations(ShaderPermutations& p, const char* vertexSrc, const char* fragmentSrc,
+                                   uint32_t sceneFeatures) {
+    p.vertexSrc = vertexSrc;
+    p.fragmentSrc = fragmentSrc;
+    p.sceneFeatures = sceneFeatures;
+}
+
+// Drop features the tree can't provide yet
+inline uint32_t supportedVariantKey(const ShaderPermutations& p, uint32_t key) {
+    if (p.shadowSource.empty())
+        key &= ~(uint32_t)SHADER_SHADOWS;
+    if (p.clusterSource.empty())
+        key &= ~(uint32_t)SHADER_CLUSTERED;
+    return key;
+}
+
+inline ShaderVariant* findVariant(ShaderPermutations& p, uint32_t key) {
+    for (ShaderVariant& v : p.variants)
+        if (v.key == key)
+            return &v;
+    return nullptr;
+}
+
+// Registered sources the key's features need
+inline std::string variantExtraSource(const ShaderPermutations& p, uint32_t key) {
+    std::string extra;
+    if (key & SHADER_SHADOWS)
+        extra += p.shadowSource;
+    if (key & SHADER_CLUSTERED)
+        extra += p.clusterSource;
+    return extra;
+}
+
+// fragmentSrc overrides the set's source (a reload building from new text)
+inline std::string variantFragmentSource(const ShaderPermutations& p, uint32_t key, const char* fragmentSrc = nullptr) {
+    return shaderVariantSource(fragmentSrc ? fragmentSrc : p.fragmentSrc, key, variantExtraSource(p, key));
+}
+
+// Build a variant through the program cache. Inside a program batch it is
+// finished by endProgramBatch(), so it counts as ready for drawing.
+inline unsigned int precompileVariant(ShaderPermutations& p, uint32_t features, LightingModel lighting) {
+    uint32_t key = supportedVariantKey(p, shaderVariantKey(features | p.sceneFeatures, lighting));
+    if (ShaderVariant* existing = findVariant(p, key))
+        return existing->program;
+    std::string fragSrc = variantFragmentSource(p, key);
+    ShaderStageSource stages[] = { { GL_VERTEX_SHADER, p.vertexSrc }, { GL_FRAGMENT_SHADER, fragSrc.c_str() } };
+    ShaderVariant v;
+    v.key = key;
+    v.program = createCachedProgram(programCache, stages, 2);
+    v.ready = true;
+    p.variants.push_back(v);
+    return v.program;
+}
+
+// Start a compile without waiting for it; a cached binary is ready at once
+inline ShaderVariant& requestVariant(ShaderPermutations& p, uint32_t key) {
+    ShaderVariant v;
+    v.key = key;
+    std::string fragSrc = variantFragmentSource(p, key);
+    ShaderStageSource stages[] = { { GL_VERTEX_SHADER, p.vertexSrc }, { GL_FRAGMENT_SHADER, fragSrc.c_str() } };
+    uint64_t cacheKey = 0;
+    if (programCache.enabled) {
+        cacheKey = programCacheKey(programCache, stages, 2);
+        v.program = loadProgramBinary(programCache, cacheKey);
+    }
+    if (v.program) {
+        programCache.hits++;
+        v.ready = true;
+    } else {
+        v.pending = submitProgram(stages, 2, programCache.enabled);
+        v.pending.key = cacheKey;
+        v.program = v.pending.program;
+        v.compiling = true;
+        v.submitted = std::chrono::high_resolution_clock::now();
+        programCache.compiles++;
+        p.lazyCompiles++;
+    }
+    p.variants.push_back(v);
+    return p.variants.back();
+}
+
+// Stand-in while a variant compiles: a built variant with the same texturing,
+// preferring the same lighting model. 0 if there is none.
+inline unsigned int fallbackVariantProgram(const ShaderPermutations& p, uint32_t key) {
+    unsigned int best = 0;
+    for (const ShaderVariant& v : p.variants) {
+        if (!v.ready || (v.key & SHADER_TEXTURE_MASK) != (key & SHADER_TEXTURE_MASK))
+            continue;
+        if (variantLighting(v.key) == variantLighting(key))
+            return v.program;
+        if (!best)
+            best = v.program;
+    }
+    return best;
+}
+
+// Program to draw a material with this frame
+inline unsigned int materialProgram(ShaderPermutations& p, const Material& m) {
+    uint32_t features = p.sceneFeatures | (m.texture ? (uint32_t)SHADER_TEXTURED : 0u);
+    uint32_t key = supportedVariantKey(p, shaderVariantKey(features, m.lighting));
+    ShaderVariant* v = findVariant(p, key);
+    if (!v)
+        v = &requestVariant(p, key);
+    if (v->ready)
+        return v->program;
+    p.fallbackDraws++;
+    return fallbackVariantProgram(p, key);
+}
+
+// Point a command at the material's variant; false if nothing can draw it yet
+inline bool setDrawMaterial(DrawCommand& cmd, ShaderPermutations& p, const Material& m) {
+    cmd.program = materialProgram(p, m);
+    cmd.texture = m.texture;
+    cmd.color = m.color;
+    return cmd.program != 0;
+}
+
+// Finish background compiles that are done; call once per frame. Returns
+// true when a variant became ready (its frame uniforms still need setting).
+inline bool updateShaderPermutations(ShaderPermutations& p) {
+    bool changed = false;
+    for (ShaderVariant& v : p.variants) {
+        if (!v.compiling)
+            continue;
+        // Without the completion query the finish blocks; give the driver a frame first
+        if (glCaps.parallelShaderCompile ? !programCompleted(v.pending) : v.framesWaited++ == 0)
+            continue;
+        v.compiling = false;
+        v.ready = finishProgram(programCache, v.pending);
+        v.failed = !v.ready;
+        changed = changed || v.ready;
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - v.submitted).count();
+        std::cout << "Shader variant '" << shaderVariantName(v.key) << "' "
+                  << (v.ready ? "compiled in the background" : "failed, keeping the fallback")
+                  << " (" << (int)ms << " ms)" << std::endl;
+    }
+    return changed;
+}
+
+inline bool isVariantProgram(const ShaderPermutations& p, unsigned int program) {
+    for (const ShaderVariant& v : p.variants)
+        if (v.ready && v.program == program)
+            return true;
+    return false;
+}
+
+inline void destroyShaderPermutations(ShaderPermutations& p) {
+    for (ShaderVariant& v : p.variants) {
+        if (v.compiling)
+            for (unsigned int shader : v.pending.shaders)
+                glDeleteShader(shader);
+        glDeleteProgram(v.program);
+    }
+    p.variants.clear();
+}
+
+// Swap in programs rebuilt from new source text (shader hot reload). Variants
+// the rebuild didn't cover are dropped and requested again on their next draw.
+inline void reloadVariantPrograms(ShaderPermutations& p, const char* vertexSrc, const char* fragmentSrc,
+                                  const std::vector<uint32_t>& keys, const std::vector<unsigned int>& programs) {
+    destroyShaderPermutations(p);
+    p.vertexSrc = vertexSrc;
+    p.fragmentSrc = fragmentSrc;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        ShaderVariant v;
+        v.key = keys[i];
+        v.program = programs[i];
+        v.ready = true;
+        p.variants.push_back(v);
+    }
+}
+
+#endif
@@ -0,0 +1,301 @@
+#ifndef SHADER_RELOAD_H
+#define SHADER_RELOAD_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+// --------------------- Shader Files and Hot Reload ---------------------
+// Shader sources live in shaders/ and are read at startup. With --hot-reload
+// a worker thread watches those files (inotify on Linux, mtime polling
+// elsewhere) and reports which ones changed. The render thread reads the new
+// text and queues a reload job with every program built from it; the worker
+// compiles and links them on a hidden context that shares objects with the
+// main one, waits for the driver with glFinish and hands the job back. The
+// render thread swaps all of a job's programs in at once between frames, or,
+// if any stage fails, prints the log and keeps drawing with the old ones.
+
+const int SHADER_WATCH_INTERVAL_MS = 100;
+
+// Read a whole shader file; false (with an error) if it can't be opened
+inline bool readShaderFile(const std::string& path, std::string& source) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cout << "ERROR::SHADER::FILE_NOT_READ: " << path << std::endl;
+        return false;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    source = text.str();
+    return true;
+}
+
+// Size and modification time, nanoseconds where the platform has them
+inline int64_t shaderFileStamp(const std::string& path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        return -1;
+#if defined(__APPLE__)
+    int64_t time = (int64_t)st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#elif defined(__linux__)
+    int64_t time = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#else
+    int64_t time = (int64_t)st.st_mtime * 1000000000;
+#endif
+    return time ^ ((int64_t)st.st_size << 40);
+}
+
+// One program of a reload job. tag identifies it to the caller (a variant key).
+struct ShaderBuild {
+    uint32_t tag = 0;
+    std::string vertexSrc;
+    std::string tessControlSrc, tessEvaluationSrc;   // empty without tessellation
+    std::string fragmentSrc;
+    unsigned int program = 0;
+};
+
+struct ShaderReloadJob {
+    std::string name;                // which program set, for the caller
+    std::string vertexSrc, fragmentSrc;
+    std::vector<std::string> includeSrc;   // shared snippets the builds were made with
+    std::vector<ShaderBuild> builds;
+    bool ok = false;
+    std::string log;
+    double ms = 0.0;
+};
+
+struct ShaderWatcher {
+    // Shared with the worker, guarded by mutex
+    std::mutex mutex;
+    std::vector<std::string> changed;
+    std::vector<ShaderReloadJob> queued, finished;
+    bool quit = false;
+
+    // Set up by the render thread before the worker starts
+    std::thread worker;
+    GLFWwindow* context = nullptr;   // hidden, shares objects with the main window
+    std::vector<std::string> files;
+    std::vector<int64_t> stamps;
+    int inotifyFd = -1;
+    std::vector<std::pair<int, std::string>> watchDirs;   // inotify watch descriptor, directory
+};
+
+inline std::string watchedDirectory(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? "." : path.substr(0, slash);
+}
+
+inline void markShaderChanged(ShaderWatcher& w, const std::string& path, std::vector<std::string>& changed) {
+    if (std::find(w.files.begin(), w.files.end(), path) != w.files.end() &&
+        std::find(changed.begin(), changed.end(), path) == changed.end())
+        changed.push_back(path);
+}
+
+// Worker thread: block up to one interval for file events
+inline std::vector<std::string> waitForShaderChanges(ShaderWatcher& w) {
+    std::vector<std::string> changed;
+#ifdef __linux__
+    if (w.inotifyFd >= 0) {
+        pollfd pfd = { w.inotifyFd, POLLIN, 0 };
+        if (poll(&pfd, 1, SHADER_WATCH_INTERVAL_MS) <= 0)
+            return changed;
+        alignas(inotify_event) char buffer[4096];
+        ssize_t length = read(w.inotifyFd, buffer, sizeof(buffer));
+        for (ssize_t offset = 0; offset < length;) {
+            const inotify_event* e = (const inotify_event*)(buffer + offset);
+            offset += sizeof(inotify_event) + e->len;
+            if (e->len == 0)
+                continue;
+            for (const auto& dir : w.watchDirs)
+                if (dir.first == e->wd)
+                    markShaderChanged(w, dir.second + "/" + e->name, changed);
+        }
+        return changed;
+    }
+#endif
+    std::this_thread::sleep_for(std::chrono::milliseconds(SHADER_WATCH_INTERVAL_MS));
+    for (size_t i = 0; i < w.files.size(); ++i) {
+        int64_t stamp = shaderFileStamp(w.files[i]);
+        if (stamp != w.stamps[i]) {
+            w.stamps[i] = stamp;
+            if (stamp >= 0)
+                changed.push_back(w.files[i]);
+        }
+    }
+    return changed;
+}
+
+inline unsigned int compileReloadStage(GLenum type, const std::string& source, std::string& log) {
+    unsigned int shader = glCreateShader(type);
+    const char* text = source.c_str();
+    glShaderSource(shader, 1, &text, nullptr);
+    glCompileShader(shader);
+    int success = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char infoLog[1024];
+        glGetShaderInfoLog(shader, sizeof(infoLog), nullptr, infoLog);
+        log += infoLog;
+    }
+    return shader;
+}
+
+// Worker thread, background context current. All or nothing: on any error
+// every program of the job is deleted again.
+inline void buildReloadJob(ShaderReloadJob& job) {
+    using Clock = std::chrono::high_resolution_clock;
+    auto start = Clock::now();
+    job.ok = true;
+    for (ShaderBuild& b : job.builds) {
+        std::string log;
+        std::vector<unsigned int> shaders;
+        shaders.push_back(compileReloadStage(GL_VERTEX_SHADER, b.vertexSrc, log));
+        if (!b.tessControlSrc.empty()) {
+            shaders.push_back(compileReloadStage(GL_TESS_CONTROL_SHADER, b.tessControlSrc, log));
+            shaders.push_back(compileReloadStage(GL_TESS_EVALUATION_SHADER, b.tessEvaluationSrc, log));
+        }
+        shaders.push_back(compileReloadStage(GL_FRAGMENT_SHADER, b.fragmentSrc, log));
+        b.program = glCreateProgram();
+        for (unsigned int shader : shaders)
+            glAttachShader(b.program, shader);
+        glLinkProgram(b.program);
+        for (unsigned int shader : shaders)
+            glDeleteShader(shader);
+        int linked = 0;
+        glGetProgramiv(b.program, GL_LINK_STATUS, &linked);
+        if (!linked) {
+            char infoLog[1024];
+            glGetProgramInfoLog(b.program, sizeof(infoLog), nullptr, infoLog);
+            job.log += log + infoLog;
+            job.ok = false;
+            break;
+        }
+    }
+    if (!job.ok) {
+        for (ShaderBuild& b : job.builds) {
+            glDeleteProgram(b.program);
+            b.program = 0;
+        }
+    }
+    glFinish();   // the render thread may use the programs as soon as it sees the job
+    job.ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+inline void shaderWatcherLoop(ShaderWatcher* w) {
+    glfwMakeContextCurrent(w->context);
+    while (true) {
+        std::vector<std::string> changed = waitForShaderChanges(*w);
+        std::vector<ShaderReloadJob> jobs;
+        {
+            std::lock_guard<std::mutex> lock(w->mutex);
+            if (w->quit)
+                break;
+            for (const std::string& path : changed)
+                if (std::find(w->changed.begin(), w->changed.end(), path) == w->changed.end())
+                    w->changed.push_back(path);
+            jobs.swap(w->queued);
+        }
+        for (ShaderReloadJob& job : jobs)
+            buildReloadJob(job);
+        if (!jobs.empty()) {
+            std::lock_guard<std::mutex> lock(w->mutex);
+            for (ShaderReloadJob& job : jobs)
+                w->finished.push_back(std::move(job));
+        }
+    }
+    glfwMakeContextCurrent(nullptr);
+}
+
+// Render thread. The background context is created here because GLFW windows
+// must be created on the main thread; it inherits the current context hints.
+inline bool startShaderWatcher(ShaderWatcher& w, GLFWwindow* mainWindow, const std::vector<std::string>& files) {
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    w.context = glfwCreateWindow(1, 1, "shader reload", nullptr, mainWindow);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    if (!w.context) {
+        std::cout << "Shader hot reload: could not create a shared context" << std::endl;
+        return false;
+    }
+    w.files = files;
+    for (const std::string& path : files)
+        w.stamps.push_back(shaderFileStamp(path));
+#ifdef __linux__
+    w.inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    for (const std::string& path : files) {
+        std::string dir = watchedDirectory(path);
+        bool known = false;
+        for (const auto& d : w.watchDirs)
+            known = known || d.second == dir;
+        if (w.inotifyFd >= 0 && !known) {
+            // Editors either rewrite the file or rename a new one over it
+            int wd = inotify_add_watch(w.inotifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+            if (wd >= 0)
+                w.watchDirs.push_back({ wd, dir });
+        }
+    }
+#endif
+    std::cout << "Shader hot reload: watching " << files.size() << " files"
+              << (w.inotifyFd >= 0 ? " (inotify)" : " (polling)") << std::endl;
+    w.worker = std::thread(shaderWatcherLoop, &w);
+    return true;
+}
+
+inline std::vector<std::string> takeChangedShaderFiles(ShaderWatcher& w) {
+    std::vector<std::string> changed;
+    std::lock_guard<std::mutex> lock(w.mutex);
+    changed.swap(w.changed);
+    return changed;
+}
+
+inline void submitShaderReload(ShaderWatcher& w, ShaderReloadJob job) {
+    std::lock_guard<std::mutex> lock(w.mutex);
+    w.queued.push_back(std::move(job));
+}
+
+inline bool takeFinishedShaderReload(ShaderWatcher& w, ShaderReloadJob& job) {
+    std::lock_guard<std::mutex> lock(w.mutex);
+    if (w.finished.empty())
+        return false;
+    job = std::move(w.finished.front());
+    w.finished.erase(w.finished.begin());
+    return true;
+}
+
+inline void stopShaderWatcher(ShaderWatcher& w) {
+    {
+        std::lock_guard<std::mutex> lock(w.mutex);
+        w.quit = true;
+    }
+    if (w.worker.joinable())
+        w.worker.join();
+    for (ShaderReloadJob& job : w.finished)
+        for (ShaderBuild& b : job.builds)
+            glDeleteProgram(b.program);
+    w.finished.clear();
+#ifdef __linux__
+    if (w.inotifyFd >= 0)
+        close(w.inotifyFd);
+    w.inotifyFd = -1;
+#endif
+    if (w.context)
+        glfwDestroyWindow(w.context);
+    w.context = nullptr;
+}
+
+#endif
@@ -0,0 +1,48 @@
+// addClusteredLights() for the CLUSTERED object shader variants and the
+// deferred lighting pass; shader_permutations.h inserts it after the
+// #version line. clustered_lighting.h fills the buffers: per cluster an
+// (offset, count) into the index list, the list itself, and 3 texels per
+// light: position + radius, color + spot outer cosine (below -1 for point
+// lights), direction + inner cosine.
+uniform usamplerBuffer clusterGrid;
+uniform usamplerBuffer clusterLightIndices;
+uniform samplerBuffer clusterLights;
+uniform ivec3 clusterDims;
+uniform vec2 clusterTileScale;      // clusters per framebuffer pixel
+uniform vec3 clusterViewForward;
+uniform vec2 clusterSliceParams;    // slice = log(view depth) * x + y
+
+// Adds the lights of the cluster at gl_FragCoord / worldPos. model: 1 Lambert,
+// 2 Phong, 3 Blinn-Phong (4x the exponent, like the sun's highlight)
+void addClusteredLights(vec3 worldPos, vec3 norm, vec3 eye, int model, float shininess, float specularStrength,
+                        inout vec3 diffuse, inout vec3 specular) {
+    float depth = dot(worldPos - eye, clusterViewForward);
+    int slice = clamp(int(log(max(depth, 1e-4)) * clusterSliceParams.x + clusterSliceParams.y), 0, clusterDims.z - 1);
+    ivec2 tile = min(ivec2(gl_FragCoord.xy * clusterTileScale), clusterDims.xy - 1);
+    uvec2 range = texelFetch(clusterGrid, (slice * clusterDims.y + tile.y) * clusterDims.x + tile.x).xy;
+    vec3 viewDir = normalize(eye - worldPos);
+    for (uint i = 0u; i < range.y; ++i) {
+        int light = int(texelFetch(clusterLightIndices, int(range.x + i)).r) * 3;
+        vec4 positionRadius = texelFetch(clusterLights, light);
+        vec3 toLight = positionRadius.xyz - worldPos;
+        float dist2 = dot(toLight, toLight);
+        float r2 = positionRadius.w * positionRadius.w;
+        if (dist2 >= r2)
+            continue;
+        vec4 colorOuter = texelFetch(clusterLights, light + 1);
+        vec3 L = toLight * inversesqrt(dist2);
+        // Inverse square, windowed to reach 0 at the radius
+        float window = 1.0 - (dist2 / r2) * (dist2 / r2);
+        float attenuation = window * window / (dist2 + 1.0);
+        if (colorOuter.w >= -1.0) {
+            vec4 directionInner = texelFetch(clusterLights, light + 2);
+            attenuation *= smoothstep(colorOuter.w, directionInner.w, dot(-L, directionInner.xyz));
+        }
+        vec3 radiance = colorOuter.rgb * attenuation;
+        diffuse += max(dot(norm, L), 0.0) * radiance;
+        if (model == 2)
+            specular += specularStrength * pow(max(dot(viewDir, reflect(-L, norm)), 0.0), shininess) * radiance;
+        else if (model == 3)
+            specular += specularStrength * pow(max(dot(norm, normalize(L + viewDir)), 0.0), shininess * 4.0) * radiance;
+    }
+}
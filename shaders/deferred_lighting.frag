@@ -0,0 +1,112 @@
+#version 330 core
+// Lighting pass of the deferred path (deferred_renderer.h): every pixel is
+// shaded once from the G-buffer, with the same lighting as object.frag. The
+// scene's FOG / SHADOWS / IBL / CLUSTERED defines (and the shadow and
+// cluster sources) are inserted after the #version line by
+// shader_permutations.h; the lighting model comes per pixel from the
+// material bits. Pixels nothing was drawn on get the sky.
+out vec4 FragColor;
+
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+uniform samplerCube skybox;
+uniform mat4 inverseViewProjection;
+
+uniform vec3 lightDir;
+uniform vec3 lightColor;
+uniform vec3 viewPos;
+#ifdef FOG
+uniform vec3 fogColor;
+uniform float fogDensity;
+#endif
+#ifdef IBL
+uniform vec3 shIrradiance[9];
+uniform samplerCube prefilteredEnv;
+uniform float prefilteredMaxLod;
+
+vec3 irradianceSH(vec3 n) {
+    return shIrradiance[0]
+         + shIrradiance[1] * n.y + shIrradiance[2] * n.z + shIrradiance[3] * n.x
+         + shIrradiance[4] * (n.x * n.y) + shIrradiance[5] * (n.y * n.z)
+         + shIrradiance[6] * (3.0 * n.z * n.z - 1.0) + shIrradiance[7] * (n.x * n.z)
+         + shIrradiance[8] * (n.x * n.x - n.y * n.y);
+}
+#endif
+
+// Same constants as object.frag
+#define AMBIENT_STRENGTH 0.3
+#define SPECULAR_STRENGTH 0.5
+#define SHININESS 32.0
+#define IBL_DIFFUSE_STRENGTH 0.5
+#define IBL_SPECULAR_STRENGTH 0.25
+
+vec2 signNotZero(vec2 v) {
+    return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+// Inverse of gbuffer.frag's octahedralEncode
+vec3 octahedralDecode(vec2 e) {
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * signNotZero(n.xy);
+    return normalize(n);
+}
+
+void main() {
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, pixel, 0).r;
+    vec2 ndc = gl_FragCoord.xy / vec2(textureSize(gDepth, 0)) * 2.0 - 1.0;
+    vec4 world = inverseViewProjection * vec4(ndc, depth * 2.0 - 1.0, 1.0);
+    vec3 worldPos = world.xyz / world.w;
+    // The target's depth buffer gets the scene's (Hi-Z reads it)
+    gl_FragDepth = depth;
+    if (depth == 1.0) {
+        FragColor = texture(skybox, worldPos - viewPos);
+        return;
+    }
+
+    vec4 albedoBits = texelFetch(gAlbedo, pixel, 0);
+    vec3 texColor = albedoBits.rgb;
+    int model = int(albedoBits.a * 255.0 + 0.5) & 3;
+    vec3 result = texColor;
+    if (model != 0) {
+        vec3 norm = octahedralDecode(texelFetch(gNormal, pixel, 0).xy);
+#ifdef IBL
+        vec3 ambient = IBL_DIFFUSE_STRENGTH * max(irradianceSH(norm), 0.0);
+#else
+        vec3 ambient = AMBIENT_STRENGTH * lightColor;
+#endif
+        vec3 invLight = normalize(-lightDir);
+        vec3 diffuse = max(dot(norm, invLight), 0.0) * lightColor;
+        vec3 viewDir = normalize(viewPos - worldPos);
+        vec3 specular = vec3(0.0);
+        if (model == 2)
+            specular = SPECULAR_STRENGTH * pow(max(dot(viewDir, reflect(lightDir, norm)), 0.0), SHININESS) * lightColor;
+        else if (model == 3)
+            specular = SPECULAR_STRENGTH * pow(max(dot(norm, normalize(invLight + viewDir)), 0.0), SHININESS * 4.0) * lightColor;
+#ifdef SHADOWS
+        float shadow = shadowFactor(worldPos, norm);
+        diffuse *= shadow;
+        specular *= shadow;
+#endif
+#ifdef CLUSTERED
+        addClusteredLights(worldPos, norm, viewPos, model, SHININESS, SPECULAR_STRENGTH, diffuse, specular);
+#endif
+#ifdef IBL
+        if (model >= 2) {
+            float roughness = model == 3 ? 0.12 : 0.24;
+            specular += IBL_SPECULAR_STRENGTH * textureLod(prefilteredEnv, reflect(-viewDir, norm),
+                                                           roughness * prefilteredMaxLod).rgb;
+        }
+#endif
+        result = (ambient + diffuse + specular) * texColor;
+    }
+
+#ifdef FOG
+    float fogAmount = fogDensity * length(viewPos - worldPos);
+    result = mix(fogColor, result, exp(-fogAmount * fogAmount));
+#endif
+    FragColor = vec4(result, 1.0);
+}
@@ -0,0 +1,7 @@
+#version 330 core
+// One triangle covering the screen, corners from gl_VertexID (no vertex
+// buffer). Fragment shaders work from gl_FragCoord.
+void main() {
+    vec2 ndc = vec2(gl_VertexID == 1 ? 3.0 : -1.0, gl_VertexID == 2 ? 3.0 : -1.0);
+    gl_Position = vec4(ndc, 1.0, 1.0);
+}
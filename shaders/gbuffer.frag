@@ -0,0 +1,45 @@
+#version 330 core
+// Geometry pass of the deferred path (deferred_renderer.h): object.frag's
+// inputs and material, stored in the G-buffer instead of lit. Specialised by
+// shader_permutations.h the same way; only TEXTURED, DYNAMIC_TEXTURE and
+// LIGHTING_MODEL matter here, everything else is the lighting pass's.
+layout(location = 0) out vec4 gAlbedo;   // rgb albedo, a material bits
+layout(location = 1) out vec2 gNormal;   // octahedral, mapped to [0,1]
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoord;
+
+uniform sampler2D texture1;
+#ifdef DYNAMIC_TEXTURE
+uniform bool useTexture;
+#endif
+uniform vec3 objectColor;
+
+#ifndef LIGHTING_MODEL
+#define LIGHTING_MODEL 2
+#endif
+
+vec2 signNotZero(vec2 v) {
+    return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+// Unit vector -> octahedron, lower half folded over the diagonals
+vec2 octahedralEncode(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 e = n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * signNotZero(n.xy);
+    return e * 0.5 + 0.5;
+}
+
+void main() {
+#if defined(TEXTURED)
+    vec3 texColor = texture(texture1, TexCoord).rgb;
+#elif defined(DYNAMIC_TEXTURE)
+    vec3 texColor = useTexture ? texture(texture1, TexCoord).rgb : objectColor;
+#else
+    vec3 texColor = objectColor;
+#endif
+    // Material bits: the lighting model in bits 0-1
+    gAlbedo = vec4(texColor, float(LIGHTING_MODEL) / 255.0);
+    gNormal = octahedralEncode(normalize(Normal));
+}
@@ -0,0 +1,108 @@
+#version 330 core
+// Specialised per material by shader_permutations.h, which inserts its
+// #defines after the #version line. Without any it is untextured Phong.
+out vec4 FragColor;
+ 
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoord;
+ 
+uniform sampler2D texture1;
+#ifdef DYNAMIC_TEXTURE
+uniform bool useTexture;
+#endif
+uniform vec3 objectColor;
+ 
+uniform vec3 lightDir;
+uniform vec3 lightColor;
+uniform vec3 viewPos;
+#ifdef FOG
+uniform vec3 fogColor;
+uniform float fogDensity;
+#endif
+#ifdef IBL
+// From environment_lighting.h: irradiance / pi as 9 SH coefficients with the
+// basis constants folded in, and the sky prefiltered by roughness per mip
+uniform vec3 shIrradiance[9];
+uniform samplerCube prefilteredEnv;
+uniform float prefilteredMaxLod;
+
+vec3 irradianceSH(vec3 n) {
+    return shIrradiance[0]
+         + shIrradiance[1] * n.y + shIrradiance[2] * n.z + shIrradiance[3] * n.x
+         + shIrradiance[4] * (n.x * n.y) + shIrradiance[5] * (n.y * n.z)
+         + shIrradiance[6] * (3.0 * n.z * n.z - 1.0) + shIrradiance[7] * (n.x * n.z)
+         + shIrradiance[8] * (n.x * n.x - n.y * n.y);
+}
+#endif
+
+#ifndef LIGHTING_MODEL
+#define LIGHTING_MODEL 2
+#endif
+#define AMBIENT_STRENGTH 0.3
+#define SPECULAR_STRENGTH 0.5
+#define SHININESS 32.0
+#define IBL_DIFFUSE_STRENGTH 0.5
+#define IBL_SPECULAR_STRENGTH 0.25
+// GGX roughness close to the Phong / Blinn-Phong highlights
+#if LIGHTING_MODEL == 3
+#define IBL_ROUGHNESS 0.12
+#else
+#define IBL_ROUGHNESS 0.24
+#endif
+ 
+void main() {
+#if defined(TEXTURED)
+    vec3 texColor = texture(texture1, TexCoord).rgb;
+#elif defined(DYNAMIC_TEXTURE)
+    vec3 texColor = useTexture ? texture(texture1, TexCoord).rgb : objectColor;
+#else
+    vec3 texColor = objectColor;
+#endif
+
+#if LIGHTING_MODEL == 0
+    vec3 result = texColor;
+#else
+    vec3 norm = normalize(Normal);
+#ifdef IBL
+    vec3 ambient = IBL_DIFFUSE_STRENGTH * max(irradianceSH(norm), 0.0);
+#else
+    vec3 ambient = AMBIENT_STRENGTH * lightColor;
+#endif
+    vec3 invLight = normalize(-lightDir);
+    float diff = max(dot(norm, invLight), 0.0);
+    vec3 diffuse = diff * lightColor;
+#if LIGHTING_MODEL == 1
+    vec3 specular = vec3(0.0);
+#else
+    vec3 viewDir = normalize(viewPos - FragPos);
+#if LIGHTING_MODEL == 2
+    vec3 reflectDir = reflect(lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), SHININESS);
+#else
+    vec3 halfDir = normalize(invLight + viewDir);
+    float spec = pow(max(dot(norm, halfDir), 0.0), SHININESS * 4.0);
+#endif
+    vec3 specular = SPECULAR_STRENGTH * spec * lightColor;
+#endif
+#ifdef SHADOWS
+    float shadow = shadowFactor(FragPos, norm);
+    diffuse *= shadow;
+    specular *= shadow;
+#endif
+#ifdef CLUSTERED
+    addClusteredLights(FragPos, norm, viewPos, LIGHTING_MODEL, SHININESS, SPECULAR_STRENGTH, diffuse, specular);
+#endif
+#if defined(IBL) && LIGHTING_MODEL >= 2
+    vec3 reflected = textureLod(prefilteredEnv, reflect(-viewDir, norm), IBL_ROUGHNESS * prefilteredMaxLod).rgb;
+    specular += IBL_SPECULAR_STRENGTH * reflected;
+#endif
+    vec3 result = (ambient + diffuse + specular) * texColor;
+#endif
+
+#ifdef FOG
+    float fogAmount = fogDensity * length(viewPos - FragPos);
+    result = mix(fogColor, result, exp(-fogAmount * fogAmount));
+#endif
+    FragColor = vec4(result, 1.0);
+}
@@ -0,0 +1,8 @@
+#version 330 core
+// Shadow casters: position only, into one cascade's light clip space
+layout (location = 0) in vec3 aPos;
+uniform mat4 lightMatrix;
+uniform mat4 model;
+void main() {
+    gl_Position = lightMatrix * model * vec4(aPos, 1.0);
+}
@@ -0,0 +1,24 @@
+// shadowFactor() for the object shader's SHADOWS variants. shadow_maps.h
+// defines SHADOW_CASCADES in front of this, and shader_permutations.h inserts
+// both after the fragment shader's #version line.
+uniform sampler2DArrayShadow shadowMap;
+uniform mat4 shadowMatrices[SHADOW_CASCADES];   // world -> [0,1] shadow map space
+uniform float shadowTexelSizes[SHADOW_CASCADES]; // world size of a texel per cascade
+
+// 1 = lit, 0 = in shadow. Uses the first (sharpest) cascade containing the
+// point, offset along the normal by a texel and a half against acne, with a
+// 3x3 PCF kernel of filtered compares. Beyond the last cascade: lit.
+float shadowFactor(vec3 worldPos, vec3 normal) {
+    vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+    for (int i = 0; i < SHADOW_CASCADES; ++i) {
+        vec4 p = shadowMatrices[i] * vec4(worldPos + normal * (1.5 * shadowTexelSizes[i]), 1.0);
+        if (any(lessThan(p.xy, texel)) || any(greaterThan(p.xy, 1.0 - texel)) || p.z > 1.0)
+            continue;
+        float lit = 0.0;
+        for (int y = -1; y <= 1; ++y)
+            for (int x = -1; x <= 1; ++x)
+                lit += texture(shadowMap, vec4(p.xy + vec2(x, y) * texel, float(i), p.z));
+        return lit / 9.0;
+    }
+    return 1.0;
+}
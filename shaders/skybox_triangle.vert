@@ -0,0 +1,15 @@
+#version 330 core
+// Skybox as one triangle covering the screen, with no vertex buffer: the
+// corners come from gl_VertexID. Each corner's far-plane point is unprojected
+// with the inverse of projection * (rotation-only) view to get the direction
+// into the cubemap. w is the same across the far plane, so dividing per vertex
+// still interpolates exactly. Any later fullscreen pass can reuse this to
+// shade background pixels itself instead of drawing the sky separately.
+out vec3 TexCoords;
+uniform mat4 inverseViewProjection;
+void main() {
+    vec2 ndc = vec2(gl_VertexID == 1 ? 3.0 : -1.0, gl_VertexID == 2 ? 3.0 : -1.0);
+    vec4 farPoint = inverseViewProjection * vec4(ndc, 1.0, 1.0);
+    TexCoords = farPoint.xyz / farPoint.w;
+    gl_Position = vec4(ndc, 1.0, 1.0);
+}
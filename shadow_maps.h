@@ -0,0 +1,334 @@
+#ifndef SHADOW_MAPS_H
+#define SHADOW_MAPS_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "mesh_buffer.h"
+#include "pipeline_state.h"
+
+// Defined in main.cpp
+unsigned int createShaderProgram(const char* vertSrc, const char* fragSrc);
+
+// --------------------- Cascaded Shadow Maps ---------------------
+// Shadows of the directional light. The view frustum up to the shadow
+// distance is split into SHADOW_CASCADES slices (practical split scheme);
+// each slice gets a layer of a depth texture array.
+//
+// Stable fitting: a cascade covers the bounding sphere of its slice, whose
+// radius doesn't change as the camera turns, and the sphere's center is
+// snapped to whole texels in light space. The shadow map therefore only
+// moves in texel steps and edges don't shimmer, and a cascade's matrix stays
+// exactly the same while the camera is still or moves less than a texel.
+//
+// Caching: casters are static until they move, and static again once they
+// have stayed put for SHADOW_SETTLE_FRAMES frames. Every cascade keeps the depth
+// of its static casters in a second texture array, re-rendered only when the
+// cascade's matrix changes or a static caster moves, appears or goes away.
+// Each frame a cascade's layer is the cached static depth (a depth blit)
+// plus whatever dynamic casters overlap it, and a cascade with nothing
+// dynamic in it now or last frame isn't touched at all.
+
+const int SHADOW_CASCADES = 4;
+const int SHADOW_MAP_SIZE = 1024;
+const float SHADOW_SPLIT_LAMBDA = 0.7f;      // 0 = uniform splits, 1 = logarithmic
+const float SHADOW_CASTER_MARGIN = 50.0f;    // depth range towards the light for casters outside the slice
+const int SHADOW_TEXTURE_UNIT = 3;
+const int SHADOW_SETTLE_FRAMES = 30;
+
+// Objects that cast shadows, drawn from the shared mesh buffer. Casters are
+// matched with the previous frame's by position in the list, so the caller
+// submits them in the same order every frame.
+struct ShadowCaster {
+    MeshHandle mesh;
+    glm::mat4 model = glm::mat4(1.0f);
+    glm::vec3 center = glm::vec3(0.0f);      // world bounding sphere
+    float radius = 0.0f;
+};
+
+struct ShadowCascade {
+    glm::mat4 lightMatrix = glm::mat4(1.0f);     // world -> light clip space
+    glm::mat4 shadowMatrix = glm::mat4(1.0f);    // world -> [0,1] shadow map space
+    glm::vec2 center = glm::vec2(0.0f);          // light-space xy of the covered square
+    float radius = 0.0f;
+    float texelSize = 0.0f;                      // world size of a shadow map texel
+    bool staticValid = false;
+    bool hasDynamic = false;                     // dynamic casters were drawn into the layer
+};
+
+struct ShadowStats {
+    int staticRenders = 0;        // cascades whose static depth was re-rendered
+    int staticDraws = 0;
+    int dynamicDraws = 0;
+    int cascadesUpdated = 0;      // layers rewritten (copy + dynamic casters)
+};
+
+struct ShadowMaps {
+    unsigned int depthTexture = 0;   // sampled by the object shader, one layer per cascade
+    unsigned int staticTexture = 0;  // static casters only
+    unsigned int fbo = 0, staticFBO = 0;
+    unsigned int program = 0;
+    GLint lightMatrixLoc = -1, modelLoc = -1;
+    PipelineState pipeline;
+    glm::mat4 lightView = glm::mat4(1.0f);
+    float distance = 0.0f;
+    ShadowCascade cascades[SHADOW_CASCADES];
+
+    std::vector<ShadowCaster> previous;
+    std::vector<int> framesStill;    // per caster; static at SHADOW_SETTLE_FRAMES
+    bool staticDirty = true;
+    ShadowStats stats;
+};
+
+// The object shader's shadowFactor(), for ShaderPermutations::shadowSource
+inline std::string shadowSamplingSource(const std::string& fileText) {
+    return "#define SHADOW_CASCADES " + std::to_string(SHADOW_CASCADES) + "\n" + fileText;
+}
+
+inline void allocateShadowArray(unsigned int texture, bool compare) {
+    bindTexture(SHADOW_TEXTURE_UNIT, GL_TEXTURE_2D_ARRAY, texture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, SHADOW_CASCADES,
+                 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, compare ? GL_LINEAR : GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, compare ? GL_LINEAR : GL_NEAREST);
+    // Outside the map counts as lit
+    const float border[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, border);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, compare ? GL_COMPARE_REF_TO_TEXTURE : GL_NONE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+}
+
+// Attach one layer as the only (depth) attachment of a framebuffer
+inline void attachShadowLayer(GLenum target, unsigned int fbo, unsigned int texture, int layer) {
+    glBindFramebuffer(target, fbo);
+    glFramebufferTextureLayer(target, GL_DEPTH_ATTACHMENT, texture, 0, layer);
+}
+
+// Take over a linked depth program (shader hot reload swaps in rebuilt ones);
+// the previous one is deleted
+inline void setShadowDepthProgram(ShadowMaps& s, unsigned int program) {
+    if (s.program != program)
+        glDeleteProgram(s.program);
+    s.program = program;
+    s.lightMatrixLoc = glGetUniformLocation(s.program, "lightMatrix");
+    s.modelLoc = glGetUniformLocation(s.program, "model");
+    s.pipeline.program = s.program;
+}
+
+inline void initShadowMaps(ShadowMaps& s, const char* depthVertexSrc, const char* depthFragmentSrc,
+                           unsigned int meshVAO, const glm::vec3& lightDir, float distance) {
+    s.distance = distance;
+    glm::vec3 dir = glm::normalize(lightDir);
+    glm::vec3 up = std::abs(dir.y) > 0.9f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    s.lightView = glm::lookAt(glm::vec3(0.0f), dir, up);
+
+    setShadowDepthProgram(s, createShaderProgram(depthVertexSrc, depthFragmentSrc));
+    s.pipeline.vao = meshVAO;
+
+    glGenTextures(1, &s.depthTexture);
+    glGenTextures(1, &s.staticTexture);
+    allocateShadowArray(s.depthTexture, true);
+    allocateShadowArray(s.staticTexture, false);
+
+    glGenFramebuffers(1, &s.fbo);
+    glGenFramebuffers(1, &s.staticFBO);
+    unsigned int fbos[2] = { s.fbo, s.staticFBO };
+    unsigned int textures[2] = { s.depthTexture, s.staticTexture };
+    for (int i = 0; i < 2; ++i) {
+        attachShadowLayer(GL_FRAMEBUFFER, fbos[i], textures[i], 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::SHADOW::FRAMEBUFFER_INCOMPLETE" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+inline bool isStaticCaster(const ShadowMaps& s, size_t i) {
+    return s.framesStill[i] >= SHADOW_SETTLE_FRAMES;
+}
+
+// Compare with last frame's list. New casters start out static; a static
+// caster that moves turns dynamic, a dynamic one that settles turns static.
+// Any change to the static set leaves the cached static depth out of date.
+inline void classifyShadowCasters(ShadowMaps& s, const std::vector<ShadowCaster>& casters) {
+    size_t previousCount = s.previous.size();
+    for (size_t i = casters.size(); i < previousCount; ++i)
+        s.staticDirty = s.staticDirty || isStaticCaster(s, i);
+    s.framesStill.resize(casters.size(), SHADOW_SETTLE_FRAMES);
+    for (size_t i = 0; i < casters.size(); ++i) {
+        if (i >= previousCount) {
+            s.staticDirty = true;
+            continue;
+        }
+        const ShadowCaster& a = casters[i];
+        const ShadowCaster& b = s.previous[i];
+        bool same = a.mesh.baseVertex == b.mesh.baseVertex && a.mesh.firstIndex == b.mesh.firstIndex &&
+                    a.mesh.indexCount == b.mesh.indexCount &&
+                    std::memcmp(&a.model, &b.model, sizeof(glm::mat4)) == 0;
+        bool wasStatic = isStaticCaster(s, i);
+        s.framesStill[i] = same ? std::min(s.framesStill[i] + 1, SHADOW_SETTLE_FRAMES) : 0;
+        if (wasStatic != isStaticCaster(s, i))
+            s.staticDirty = true;
+    }
+    s.previous = casters;
+}
+
+// Split distances of the practical scheme, a blend of uniform and logarithmic
+inline float cascadeSplit(int i, float nearPlane, float farPlane) {
+    float t = (float)i / SHADOW_CASCADES;
+    float logSplit = nearPlane * std::pow(farPlane / nearPlane, t);
+    float uniformSplit = nearPlane + (farPlane - nearPlane) * t;
+    return SHADOW_SPLIT_LAMBDA * logSplit + (1.0f - SHADOW_SPLIT_LAMBDA) * uniformSplit;
+}
+
+inline void fitShadowCascade(ShadowMaps& s, ShadowCascade& c, const glm::mat4& inverseView,
+                             float tanHalfFovY, float aspect, float sliceNear, float sliceFar) {
+    glm::vec3 corners[8];
+    glm::vec3 center(0.0f);
+    for (int i = 0; i < 8; ++i) {
+        float d = (i & 4) ? sliceFar : sliceNear;
+        float h = d * tanHalfFovY, w = h * aspect;
+        corners[i] = glm::vec3(inverseView * glm::vec4((i & 1) ? w : -w, (i & 2) ? h : -h, -d, 1.0f));
+        center += corners[i] / 8.0f;
+    }
+    float radius = 0.0f;
+    for (const glm::vec3& p : corners)
+        radius = std::max(radius, glm::length(p - center));
+    // Rounded up so float noise can't change it from frame to frame
+    radius = std::ceil(radius * 16.0f) / 16.0f;
+
+    float texel = 2.0f * radius / SHADOW_MAP_SIZE;
+    glm::vec3 lc = glm::vec3(s.lightView * glm::vec4(center, 1.0f));
+    lc = glm::floor(lc / texel) * texel;
+
+    // Light space looks down -z: the casters' side is +z
+    glm::mat4 projection = glm::ortho(lc.x - radius, lc.x + radius, lc.y - radius, lc.y + radius,
+                                      -(lc.z + radius + SHADOW_CASTER_MARGIN), -(lc.z - radius));
+    glm::mat4 lightMatrix = projection * s.lightView;
+    if (std::memcmp(&lightMatrix, &c.lightMatrix, sizeof(glm::mat4)) != 0)
+        c.staticValid = false;
+    c.lightMatrix = lightMatrix;
+    glm::mat4 bias = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.5f)), glm::vec3(0.5f));
+    c.shadowMatrix = bias * lightMatrix;
+    c.center = glm::vec2(lc);
+    c.radius = radius;
+    c.texelSize = texel;
+}
+
+inline bool casterInCascade(const ShadowMaps& s, const ShadowCascade& c, const ShadowCaster& caster) {
+    glm::vec2 p = glm::vec2(s.lightView * glm::vec4(caster.center, 1.0f));
+    glm::vec2 d = glm::abs(p - c.center);
+    return d.x <= c.radius + caster.radius && d.y <= c.radius + caster.radius;
+}
+
+inline void drawShadowCaster(ShadowMaps& s, const ShadowCaster& caster) {
+    glUniformMatrix4fv(s.modelLoc, 1, GL_FALSE, glm::value_ptr(caster.model));
+    glDrawElementsBaseVertex(GL_TRIANGLES, caster.mesh.indexCount, GL_UNSIGNED_INT,
+                             (void*)caster.mesh.indexOffset(), caster.mesh.baseVertex);
+}
+
+// Update the cascades for this frame's camera and casters. Restores the
+// framebuffer and viewport it found.
+inline void renderShadowMaps(ShadowMaps& s, const std::vector<ShadowCaster>& casters, const glm::mat4& view,
+                             float fovY, float aspect, float nearPlane) {
+    s.stats = ShadowStats();
+    classifyShadowCasters(s, casters);
+    if (s.staticDirty)
+        for (ShadowCascade& c : s.cascades)
+            c.staticValid = false;
+    s.staticDirty = false;
+
+    GLint previousFBO = 0, previousViewport[4];
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFBO);
+    glGetIntegerv(GL_VIEWPORT, previousViewport);
+
+    glm::mat4 inverseView = glm::inverse(view);
+    float tanHalfFovY = std::tan(fovY * 0.5f);
+    bool bound = false;
+    std::vector<const ShadowCaster*> dynamicCasters;
+    for (int i = 0; i < SHADOW_CASCADES; ++i) {
+        ShadowCascade& c = s.cascades[i];
+        fitShadowCascade(s, c, inverseView, tanHalfFovY, aspect,
+                         cascadeSplit(i, nearPlane, s.distance), cascadeSplit(i + 1, nearPlane, s.distance));
+        dynamicCasters.clear();
+        for (size_t k = 0; k < casters.size(); ++k)
+            if (!isStaticCaster(s, k) && casterInCascade(s, c, casters[k]))
+                dynamicCasters.push_back(&casters[k]);
+        if (c.staticValid && dynamicCasters.empty() && !c.hasDynamic)
+            continue;
+
+        if (!bound) {
+            bindPipeline(s.pipeline);
+            glViewport(0, 0, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE);
+            // Slope-scaled bias against acne; the sampling side adds a normal offset
+            glEnable(GL_POLYGON_OFFSET_FILL);
+            glPolygonOffset(2.0f, 4.0f);
+            bound = true;
+        }
+        glUniformMatrix4fv(s.lightMatrixLoc, 1, GL_FALSE, glm::value_ptr(c.lightMatrix));
+        if (!c.staticValid) {
+            attachShadowLayer(GL_FRAMEBUFFER, s.staticFBO, s.staticTexture, i);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            for (size_t k = 0; k < casters.size(); ++k)
+                if (isStaticCaster(s, k) && casterInCascade(s, c, casters[k])) {
+                    drawShadowCaster(s, casters[k]);
+                    s.stats.staticDraws++;
+                }
+            c.staticValid = true;
+            s.stats.staticRenders++;
+        }
+        attachShadowLayer(GL_READ_FRAMEBUFFER, s.staticFBO, s.staticTexture, i);
+        attachShadowLayer(GL_DRAW_FRAMEBUFFER, s.fbo, s.depthTexture, i);
+        glBlitFramebuffer(0, 0, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, 0, 0, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE,
+                          GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, s.fbo);
+        for (const ShadowCaster* caster : dynamicCasters)
+            drawShadowCaster(s, *caster);
+        s.stats.dynamicDraws += (int)dynamicCasters.size();
+        s.stats.cascadesUpdated++;
+        c.hasDynamic = !dynamicCasters.empty();
+    }
+    if (bound) {
+        glDisable(GL_POLYGON_OFFSET_FILL);
+        glBindFramebuffer(GL_FRAMEBUFFER, previousFBO);
+        glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+    }
+}
+
+// For programs built with SHADOWS; the program must be current
+inline void setShadowUniforms(unsigned int program, const ShadowMaps& s) {
+    glm::mat4 matrices[SHADOW_CASCADES];
+    float texelSizes[SHADOW_CASCADES];
+    for (int i = 0; i < SHADOW_CASCADES; ++i) {
+        matrices[i] = s.cascades[i].shadowMatrix;
+        texelSizes[i] = s.cascades[i].texelSize;
+    }
+    bindTexture(SHADOW_TEXTURE_UNIT, GL_TEXTURE_2D_ARRAY, s.depthTexture);
+    glUniform1i(glGetUniformLocation(program, "shadowMap"), SHADOW_TEXTURE_UNIT);
+    glUniformMatrix4fv(glGetUniformLocation(program, "shadowMatrices"), SHADOW_CASCADES, GL_FALSE,
+                       glm::value_ptr(matrices[0]));
+    glUniform1fv(glGetUniformLocation(program, "shadowTexelSizes"), SHADOW_CASCADES, texelSizes);
+}
+
+inline void destroyShadowMaps(ShadowMaps& s) {
+    glDeleteFramebuffers(1, &s.fbo);
+    glDeleteFramebuffers(1, &s.staticFBO);
+    glDeleteTextures(1, &s.depthTexture);
+    glDeleteTextures(1, &s.staticTexture);
+    glDeleteProgram(s.program);
+}
+
+#endif
@@ -0,0 +1,206 @@
+#ifndef SPHERE_GENERATOR_H
+#define SPHERE_GENERATOR_H
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define SPHERE_GEN_SSE 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SPHERE_GEN_NEON 1
+#endif
+
+// --------------------- Fast Sphere Generation ---------------------
+// Same vertices and indices as the original generateSphere(), built for large
+// meshes:
+//   - sin/cos are evaluated once per sector and once per stack, not per vertex
+//   - both output vectors are resized once and written in place
+//   - each vertex is two 4-wide multiply-adds of a per-sector table row with
+//     per-stack constants (SSE / NEON, scalar fallback)
+//   - stacks are split into contiguous bands, one thread per band
+//
+// Per-sector table (8 floats): c, s, 0, c | s, 0, u, 0
+// Per-stack constants:         r*cs, r*cs, 0, cs | cs, 0, 1, 0
+// plus offsets                 0, 0, r*ss, 0     | 0, ss, 0, t
+// gives                        x, y, z, nx       | ny, nz, u, t
+
+const unsigned int SPHERE_GEN_MIN_VERTICES_PER_THREAD = 16384;
+
+// Index count produced by stack rows [0, row)
+inline size_t sphereRowIndexStart(unsigned int row, unsigned int sectorCount, unsigned int stackCount) {
+    size_t count = 0;
+    for (unsigned int i = 0; i < row; ++i)
+        count += (size_t)sectorCount * ((i != 0 ? 3 : 0) + (i != stackCount - 1 ? 3 : 0));
+    return count;
+}
+
+inline void writeSphereVertexRows(float* out, const float* sectorTable, unsigned int firstRow, unsigned int lastRow,
+                                  float radius, unsigned int sectorCount, unsigned int stackCount) {
+    const float PI = 3.14159265359f;
+    for (unsigned int i = firstRow; i < lastRow; ++i) {
+        float stackAngle = PI / 2 - i * (PI / stackCount);
+        float cs = cosf(stackAngle);
+        float ss = sinf(stackAngle);
+        float t = (float)i / stackCount;
+        float* row = out + (size_t)i * (sectorCount + 1) * 8;
+#if SPHERE_GEN_SSE
+        __m128 scale0 = _mm_setr_ps(radius * cs, radius * cs, 0.0f, cs);
+        __m128 scale1 = _mm_setr_ps(cs, 0.0f, 1.0f, 0.0f);
+        __m128 bias0  = _mm_setr_ps(0.0f, 0.0f, radius * ss, 0.0f);
+        __m128 bias1  = _mm_setr_ps(0.0f, ss, 0.0f, t);
+        for (unsigned int j = 0; j <= sectorCount; ++j) {
+            const float* e = sectorTable + j * 8;
+            _mm_storeu_ps(row + j * 8,     _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(e),     scale0), bias0));
+            _mm_storeu_ps(row + j * 8 + 4, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(e + 4), scale1), bias1));
+        }
+#elif SPHERE_GEN_NEON
+        const float s0[4] = { radius * cs, radius * cs, 0.0f, cs };
+        const float s1[4] = { cs, 0.0f, 1.0f, 0.0f };
+        const float b0[4] = { 0.0f, 0.0f, radius * ss, 0.0f };
+        const float b1[4] = { 0.0f, ss, 0.0f, t };
+        float32x4_t scale0 = vld1q_f32(s0), scale1 = vld1q_f32(s1);
+        float32x4_t bias0 = vld1q_f32(b0), bias1 = vld1q_f32(b1);
+        for (unsigned int j = 0; j <= sectorCount; ++j) {
+            const float* e = sectorTable + j * 8;
+            vst1q_f32(row + j * 8,     vmlaq_f32(bias0, vld1q_f32(e),     scale0));
+            vst1q_f32(row + j * 8 + 4, vmlaq_f32(bias1, vld1q_f32(e + 4), scale1));
+        }
+#else
+        const float scale[8] = { radius * cs, radius * cs, 0.0f, cs,  cs, 0.0f, 1.0f, 0.0f };
+        const float bias[8]  = { 0.0f, 0.0f, radius * ss, 0.0f,  0.0f, ss, 0.0f, t };
+        for (unsigned int j = 0; j <= sectorCount; ++j) {
+            const float* e = sectorTable + j * 8;
+            for (int k = 0; k < 8; ++k)
+                row[j * 8 + k] = e[k] * scale[k] + bias[k];
+        }
+#endif
+    }
+}
+
+inline void writeSphereIndexRows(unsigned int* out, unsigned int firstRow, unsigned int lastRow,
+                                 unsigned int sectorCount, unsigned int stackCount) {
+    for (unsigned int i = firstRow; i < lastRow; ++i) {
+        unsigned int k1 = i * (sectorCount + 1);
+        unsigned int k2 = k1 + sectorCount + 1;
+        for (unsigned int j = 0; j < sectorCount; ++j, ++k1, ++k2) {
+            if (i != 0) {
+                *out++ = k1;
+                *out++ = k2;
+                *out++ = k1 + 1;
+            }
+            if (i != (stackCount - 1)) {
+                *out++ = k1 + 1;
+                *out++ = k2;
+                *out++ = k2 + 1;
+            }
+        }
+    }
+}
+
+// Appends to vertices/indices like generateSphere(). threadCount 0 = pick from
+// the mesh size and hardware_concurrency().
+inline void generateSphereFast(std::vector<float>& vertices, std::vector<unsigned int>& indices, float radius,
+                               unsigned int sectorCount, unsigned int stackCount, unsigned int threadCount = 0) {
+    const float PI = 3.14159265359f;
+    size_t vertexCount = (size_t)(stackCount + 1) * (sectorCount + 1);
+    size_t firstFloat = vertices.size();
+    size_t firstIndex = indices.size();
+    vertices.resize(firstFloat + vertexCount * 8);
+    indices.resize(firstIndex + sphereRowIndexStart(stackCount, sectorCount, stackCount));
+
+    std::vector<float> sectorTable((size_t)(sectorCount + 1) * 8);
+    for (unsigned int j = 0; j <= sectorCount; ++j) {
+        float sectorAngle = j * (2 * PI / sectorCount);
+        float c = cosf(sectorAngle);
+        float s = sinf(sectorAngle);
+        float u = (float)j / sectorCount;
+        float entry[8] = { c, s, 0.0f, c,  s, 0.0f, u, 0.0f };
+        std::copy(entry, entry + 8, sectorTable.begin() + j * 8);
+    }
+
+    if (threadCount == 0) {
+        unsigned int hw = std::max(1u, std::thread::hardware_concurrency());
+        threadCount = (unsigned int)std::min<size_t>(hw, vertexCount / SPHERE_GEN_MIN_VERTICES_PER_THREAD);
+    }
+    threadCount = std::max(1u, std::min(threadCount, stackCount + 1));
+
+    float* vertexOut = vertices.data() + firstFloat;
+    unsigned int* indexOut = indices.data() + firstIndex;
+    auto work = [&](unsigned int band) {
+        // Vertex rows 0..stackCount, index rows 0..stackCount-1
+        unsigned int first = (stackCount + 1) * band / threadCount;
+        unsigned int last  = (stackCount + 1) * (band + 1) / threadCount;
+        writeSphereVertexRows(vertexOut, sectorTable.data(), first, last, radius, sectorCount, stackCount);
+        unsigned int lastIndexRow = std::min(last, stackCount);
+        if (first < lastIndexRow)
+            writeSphereIndexRows(indexOut + sphereRowIndexStart(first, sectorCount, stackCount),
+                                 first, lastIndexRow, sectorCount, stackCount);
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int band = 1; band < threadCount; ++band)
+        threads.emplace_back(work, band);
+    work(0);
+    for (std::thread& t : threads)
+        t.join();
+}
+
+// --------------------- Sphere Generation Benchmark ---------------------
+// Reference is the original per-vertex trig + push_back generator. Each size
+// is repeated until ~200 ms have been spent on it; the best run is reported.
+inline void benchmarkSphereGeneration(void (*reference)(std::vector<float>&, std::vector<unsigned int>&, float, unsigned int, unsigned int)) {
+    using Clock = std::chrono::high_resolution_clock;
+    auto bestMs = [](auto&& fn) {
+        double best = 1e30, total = 0.0;
+        for (int run = 0; run < 100 && (run < 3 || total < 200.0); ++run) {
+            auto start = Clock::now();
+            fn();
+            double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            best = std::min(best, ms);
+            total += ms;
+        }
+        return best;
+    };
+
+    unsigned int hw = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "Sphere generation (best of N, ms) - " << hw << " hardware threads" << std::endl;
+    std::cout << std::setw(12) << "size" << std::setw(12) << "vertices" << std::setw(12) << "reference"
+              << std::setw(12) << "1 thread" << std::setw(12) << "threaded" << std::setw(10) << "speedup"
+              << std::setw(12) << "max error" << std::endl;
+
+    for (unsigned int sectors = 32; sectors <= 2048; sectors *= 2) {
+        unsigned int stacks = sectors / 2;
+        std::vector<float> refV, fastV;
+        std::vector<unsigned int> refI, fastI;
+
+        double refMs = bestMs([&] { refV.clear(); refI.clear(); reference(refV, refI, 0.5f, sectors, stacks); });
+        double oneMs = bestMs([&] { fastV.clear(); fastI.clear(); generateSphereFast(fastV, fastI, 0.5f, sectors, stacks, 1); });
+        double mtMs  = bestMs([&] { fastV.clear(); fastI.clear(); generateSphereFast(fastV, fastI, 0.5f, sectors, stacks, hw); });
+
+        float maxError = 0.0f;
+        bool sameShape = refV.size() == fastV.size() && refI == fastI;
+        for (size_t i = 0; sameShape && i < refV.size(); ++i)
+            maxError = std::max(maxError, std::fabs(refV[i] - fastV[i]));
+
+        std::cout << std::setw(12) << (std::to_string(sectors) + "x" + std::to_string(stacks))
+                  << std::setw(12) << fastV.size() / 8
+                  << std::fixed << std::setprecision(3)
+                  << std::setw(12) << refMs << std::setw(12) << oneMs << std::setw(12) << mtMs
+                  << std::setprecision(1) << std::setw(9) << refMs / mtMs << "x"
+                  << std::scientific << std::setprecision(1) << std::setw(12);
+        if (sameShape)
+            std::cout << maxError;
+        else
+            std::cout << "MISMATCH";
+        std::cout << std::defaultfloat << std::endl;
+    }
+}
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef SPHERE_LOD_H
+#define SPHERE_LOD_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <algorithm>
+
+#include "mesh_buffer.h"
+#include "procedural_mesh.h"
+
+// --------------------- Sphere Level of Detail ---------------------
+// Every detail level is a separate mesh in the shared mesh buffer, so
+// switching level only changes the index range and base vertex of the draw.
+// Levels come from the procedural mesh cache, so chains of the same radius
+// share their meshes.
+
+const int SPHERE_LOD_COUNT = 4;
+
+// Sector x stack resolution per level, finest first
+const unsigned int sphereLodSectors[SPHERE_LOD_COUNT] = { 64, 32, 16, 8 };
+const unsigned int sphereLodStacks[SPHERE_LOD_COUNT]  = { 32, 16,  8, 4 };
+
+// Minimum projected diameter (pixels) to use each level; the last level has none
+const float sphereLodThresholds[SPHERE_LOD_COUNT - 1] = { 160.0f, 60.0f, 20.0f };
+
+// Fraction a size must move past a threshold before the level changes,
+// so instances near a boundary don't flicker between levels
+const float SPHERE_LOD_HYSTERESIS = 0.15f;
+
+struct SphereLodChain {
+    float radius = 0.0f;
+    MeshHandle levels[SPHERE_LOD_COUNT];
+};
+
+inline void buildSphereLodChain(SphereLodChain& chain, MeshCache& cache, MeshBuffer& meshBuffer, float radius) {
+    chain.radius = radius;
+    for (int lod = 0; lod < SPHERE_LOD_COUNT; ++lod)
+        chain.levels[lod] = acquireProceduralMesh(cache, meshBuffer, sphereDesc(radius, sphereLodSectors[lod], sphereLodStacks[lod]));
+}
+
+inline void releaseSphereLodChain(SphereLodChain& chain, MeshCache& cache, MeshBuffer& meshBuffer) {
+    for (int lod = 0; lod < SPHERE_LOD_COUNT; ++lod)
+        releaseProceduralMesh(cache, meshBuffer, sphereDesc(chain.radius, sphereLodSectors[lod], sphereLodStacks[lod]));
+}
+
+// Projected diameter in pixels of a sphere of the given world radius.
+// projYScale is projection[1][1] (cot(fov/2)).
+inline float projectedSphereDiameter(float worldRadius, float distance, float projYScale, int viewportHeight) {
+    if (distance <= worldRadius)
+        return 1e30f;
+    return worldRadius * projYScale * (float)viewportHeight / distance;
+}
+
+// Pick a level for the given projected size. currentLod < 0 means no previous
+// choice. Thresholds are pushed outward by the hysteresis margin relative to
+// the current level, so a level only changes once the size clearly crosses it.
+inline int selectSphereLod(float screenDiameter, int currentLod) {
+    for (int i = 0; i < SPHERE_LOD_COUNT - 1; ++i) {
+        float threshold = sphereLodThresholds[i];
+        if (currentLod >= 0)
+            threshold *= (i < currentLod) ? (1.0f + SPHERE_LOD_HYSTERESIS) : (1.0f - SPHERE_LOD_HYSTERESIS);
+        if (screenDiameter >= threshold)
+            return i;
+    }
+    return SPHERE_LOD_COUNT - 1;
+}
+
+#endif
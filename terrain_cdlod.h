@@ -0,0 +1,372 @@
+#ifndef TERRAIN_CDLOD_H
+#define TERRAIN_CDLOD_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+#include "mesh_buffer.h"
+#include "frustum.h"
+#include "pipeline_state.h"
+
+// Defined in main.cpp
+unsigned int createShaderProgram(const char* vertexSrc, const char* fragmentSrc);
+
+// --------------------- CDLOD Heightmap Terrain ---------------------
+// Continuous distance-dependent LOD (Strugar 2009). The terrain is an
+// implicit quadtree over a heightmap; every selected node is drawn with the
+// same small grid mesh, scaled to the node and displaced by the heightmap in
+// the vertex shader. Each level covers a distance band around the camera,
+// and inside the last part of its band a node's odd grid vertices slide onto
+// the next coarser grid, so level changes are seamless without stitching.
+//
+// Selection walks the tree top-down with per-node height bounds, culling
+// against the view frustum. When only some children of a node are in range
+// for the finer level, the node draws just its remaining quadrants; the grid
+// mesh keeps each quadrant's triangles in one contiguous index range.
+//
+// The heightmap is generated (fractal value noise) and flattened around the
+// origin so the scene objects still stand on y = 0.
+
+const float TERRAIN_SIZE        = 4096.0f;  // world units per side, centred on the origin
+const float TERRAIN_HEIGHT      = 250.0f;
+const int   TERRAIN_HEIGHTMAP   = 1025;     // samples per side (2^n + 1)
+const int   TERRAIN_LOD_LEVELS  = 8;        // leaf nodes are TERRAIN_SIZE / 2^7 = 32 units
+const int   TERRAIN_GRID        = 32;       // quads per node side, must be even
+const float TERRAIN_LOD0_RANGE  = 80.0f;    // range doubles per level
+const float TERRAIN_MORPH_START = 0.66f;    // fraction of a band where morphing begins
+const float TERRAIN_FAR_PLANE   = 4000.0f;
+const float TERRAIN_FLAT_RADIUS = 60.0f;    // flat area around the scene objects
+
+struct TerrainNodeDraw {
+    glm::vec2 origin;   // min x/z corner
+    float size;
+    int level;
+    int quadrants;      // bit per quadrant to draw, 0xF = whole node
+};
+
+struct TerrainStats {
+    int nodes = 0;        // nodes drawn (whole or partial)
+    int culled = 0;       // nodes rejected by the frustum
+    long long triangles = 0;
+};
+
+struct TerrainRenderer {
+    unsigned int program = 0;
+    PipelineState pipeline;      // program + shared mesh buffer VAO, opaque depth state
+    unsigned int heightmapTex = 0;
+    MeshHandle grid;
+    GLsizei quadrantIndexCount = 0;
+    std::vector<float> heights;                      // TERRAIN_HEIGHTMAP^2, row-major in z
+    std::vector<std::vector<glm::vec2>> heightRange; // per level, min/max height per node
+    float ranges[TERRAIN_LOD_LEVELS];
+    std::vector<TerrainNodeDraw> selection;
+    TerrainStats stats;
+    GLint nodeOriginLoc = -1, nodeSizeLoc = -1, morphRangeLoc = -1;
+};
+
+const char* terrainVertexShaderSrc = R"(
+#version 330 core
+layout (location = 0) in vec3 aPos;   // grid position, x/z in [0, 1]
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoord;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 viewPos;
+uniform sampler2D heightmap;
+uniform float terrainSize;
+uniform float heightmapSize;
+uniform float gridDim;
+uniform vec2 nodeOrigin;
+uniform float nodeSize;
+uniform vec2 morphRange;   // distance where morphing starts / completes
+
+float heightAt(vec2 xz) {
+    vec2 uv = xz / terrainSize + 0.5;
+    uv = uv * (heightmapSize - 1.0) / heightmapSize + 0.5 / heightmapSize;
+    return textureLod(heightmap, uv, 0.0).r;
+}
+
+void main() {
+    vec2 grid = aPos.xz;
+    vec2 xz = nodeOrigin + grid * nodeSize;
+    float dist = distance(viewPos, vec3(xz.x, heightAt(xz), xz.y));
+    float morphK = clamp((dist - morphRange.x) / (morphRange.y - morphRange.x), 0.0, 1.0);
+
+    // Odd grid vertices slide onto the even ones, giving the parent's grid at morphK = 1
+    vec2 cell = floor(grid * gridDim + 0.5);
+    grid -= mod(cell, 2.0) / gridDim * morphK;
+    xz = nodeOrigin + grid * nodeSize;
+
+    float texel = terrainSize / (heightmapSize - 1.0);
+    float hl = heightAt(xz - vec2(texel, 0.0));
+    float hr = heightAt(xz + vec2(texel, 0.0));
+    float hd = heightAt(xz - vec2(0.0, texel));
+    float hu = heightAt(xz + vec2(0.0, texel));
+    Normal = normalize(vec3(hl - hr, 2.0 * texel, hd - hu));
+    FragPos = vec3(xz.x, heightAt(xz), xz.y);
+    TexCoord = xz * 0.5;   // same texture density as the ground quad
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
+)";
+
+// --------------------- Heightmap ---------------------
+inline float terrainHash(int x, int y) {
+    uint32_t h = (uint32_t)x * 374761393u + (uint32_t)y * 668265263u;
+    h = (h ^ (h >> 13)) * 1274126177u;
+    return (float)(h ^ (h >> 16)) / 4294967295.0f;
+}
+
+inline float terrainValueNoise(float x, float y) {
+    int ix = (int)std::floor(x), iy = (int)std::floor(y);
+    float fx = x - ix, fy = y - iy;
+    fx = fx * fx * (3.0f - 2.0f * fx);
+    fy = fy * fy * (3.0f - 2.0f * fy);
+    float a = terrainHash(ix, iy),     b = terrainHash(ix + 1, iy);
+    float c = terrainHash(ix, iy + 1), d = terrainHash(ix + 1, iy + 1);
+    return glm::mix(glm::mix(a, b, fx), glm::mix(c, d, fx), fy);
+}
+
+// Height in world units at world x/z, in [0, TERRAIN_HEIGHT]
+inline float terrainGenerateHeight(float x, float z) {
+    float sum = 0.0f, amplitude = 0.5f, frequency = 1.0f / 512.0f;
+    for (int octave = 0; octave < 7; ++octave) {
+        sum += amplitude * terrainValueNoise(x * frequency, z * frequency);
+        amplitude *= 0.5f;
+        frequency *= 2.0f;
+    }
+    float r = std::sqrt(x * x + z * z);
+    float t = glm::clamp((r - TERRAIN_FLAT_RADIUS) / (5.0f * TERRAIN_FLAT_RADIUS), 0.0f, 1.0f);
+    return sum * TERRAIN_HEIGHT * t * t * (3.0f - 2.0f * t);
+}
+
+// Min/max height per node, leaves from the heightmap samples they cover,
+// parents from their children
+inline void buildTerrainHeightRanges(TerrainRenderer& t) {
+    t.heightRange.assign(TERRAIN_LOD_LEVELS, {});
+    int leaves = 1 << (TERRAIN_LOD_LEVELS - 1);
+    int samplesPerLeaf = (TERRAIN_HEIGHTMAP - 1) / leaves;
+    std::vector<glm::vec2>& level0 = t.heightRange[0];
+    level0.resize((size_t)leaves * leaves);
+    for (int j = 0; j < leaves; ++j) {
+        for (int i = 0; i < leaves; ++i) {
+            glm::vec2 range(1e30f, -1e30f);
+            for (int z = j * samplesPerLeaf; z <= (j + 1) * samplesPerLeaf; ++z) {
+                for (int x = i * samplesPerLeaf; x <= (i + 1) * samplesPerLeaf; ++x) {
+                    float h = t.heights[(size_t)z * TERRAIN_HEIGHTMAP + x];
+                    range.x = std::min(range.x, h);
+                    range.y = std::max(range.y, h);
+                }
+            }
+            level0[(size_t)j * leaves + i] = range;
+        }
+    }
+    for (int level = 1; level < TERRAIN_LOD_LEVELS; ++level) {
+        int count = leaves >> level;
+        const std::vector<glm::vec2>& child = t.heightRange[level - 1];
+        std::vector<glm::vec2>& parent = t.heightRange[level];
+        parent.resize((size_t)count * count);
+        for (int j = 0; j < count; ++j) {
+            for (int i = 0; i < count; ++i) {
+                glm::vec2 range(1e30f, -1e30f);
+                for (int c = 0; c < 4; ++c) {
+                    glm::vec2 r = child[(size_t)(j * 2 + (c >> 1)) * (count * 2) + i * 2 + (c & 1)];
+                    range.x = std::min(range.x, r.x);
+                    range.y = std::max(range.y, r.y);
+                }
+                parent[(size_t)j * count + i] = range;
+            }
+        }
+    }
+}
+
+// Grid over [0, 1] with the indices of each quadrant contiguous:
+// quadrant q covers x half (q & 1) and z half (q >> 1)
+inline MeshHandle uploadTerrainGrid(MeshBuffer& mb, GLsizei& quadrantIndexCount) {
+    const int side = TERRAIN_GRID + 1;
+    const int half = TERRAIN_GRID / 2;
+    std::vector<float> vertices;
+    vertices.reserve((size_t)side * side * MESH_VERTEX_FLOATS);
+    for (int z = 0; z < side; ++z) {
+        for (int x = 0; x < side; ++x) {
+            float u = (float)x / TERRAIN_GRID, v = (float)z / TERRAIN_GRID;
+            float vertex[8] = { u, 0.0f, v,  0.0f, 1.0f, 0.0f,  u, v };
+            vertices.insert(vertices.end(), vertex, vertex + 8);
+        }
+    }
+    std::vector<unsigned int> indices;
+    for (int q = 0; q < 4; ++q) {
+        int x0 = (q & 1) * half, z0 = (q >> 1) * half;
+        for (int z = z0; z < z0 + half; ++z) {
+            for (int x = x0; x < x0 + half; ++x) {
+                unsigned int a = z * side + x, b = a + side;
+                unsigned int quad[6] = { a, b, a + 1,  a + 1, b, b + 1 };   // front faces up
+                indices.insert(indices.end(), quad, quad + 6);
+            }
+        }
+    }
+    quadrantIndexCount = (GLsizei)(indices.size() / 4);
+    return uploadMesh(mb, vertices.data(), (unsigned int)(vertices.size() / MESH_VERTEX_FLOATS),
+                      indices.data(), (unsigned int)indices.size());
+}
+
+// Take over a linked terrain program (shader hot reload swaps in rebuilt
+// ones); the previous one is deleted
+inline void setTerrainProgram(TerrainRenderer& t, unsigned int program) {
+    if (t.program != program)
+        glDeleteProgram(t.program);
+    t.program = program;
+    t.pipeline.program = program;
+    useProgram(t.program);
+    glUniform1i(glGetUniformLocation(t.program, "texture1"), 0);
+    glUniform1i(glGetUniformLocation(t.program, "heightmap"), 1);
+    glUniform1f(glGetUniformLocation(t.program, "terrainSize"), TERRAIN_SIZE);
+    glUniform1f(glGetUniformLocation(t.program, "heightmapSize"), (float)TERRAIN_HEIGHTMAP);
+    glUniform1f(glGetUniformLocation(t.program, "gridDim"), (float)TERRAIN_GRID);
+    t.nodeOriginLoc = glGetUniformLocation(t.program, "nodeOrigin");
+    t.nodeSizeLoc = glGetUniformLocation(t.program, "nodeSize");
+    t.morphRangeLoc = glGetUniformLocation(t.program, "morphRange");
+}
+
+// objFragSrc is a textured variant of the object fragment shader
+inline void initTerrainRenderer(TerrainRenderer& t, MeshBuffer& mb, const char* objFragSrc) {
+    unsigned int program = createShaderProgram(terrainVertexShaderSrc, objFragSrc);
+    t.grid = uploadTerrainGrid(mb, t.quadrantIndexCount);
+
+    t.heights.resize((size_t)TERRAIN_HEIGHTMAP * TERRAIN_HEIGHTMAP);
+    float spacing = TERRAIN_SIZE / (TERRAIN_HEIGHTMAP - 1);
+    for (int z = 0; z < TERRAIN_HEIGHTMAP; ++z)
+        for (int x = 0; x < TERRAIN_HEIGHTMAP; ++x)
+            t.heights[(size_t)z * TERRAIN_HEIGHTMAP + x] =
+                terrainGenerateHeight(x * spacing - TERRAIN_SIZE * 0.5f, z * spacing - TERRAIN_SIZE * 0.5f);
+    buildTerrainHeightRanges(t);
+
+    glGenTextures(1, &t.heightmapTex);
+    bindTexture(1, GL_TEXTURE_2D, t.heightmapTex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, TERRAIN_HEIGHTMAP, TERRAIN_HEIGHTMAP, 0, GL_RED, GL_FLOAT, t.heights.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    for (int level = 0; level < TERRAIN_LOD_LEVELS; ++level)
+        t.ranges[level] = TERRAIN_LOD0_RANGE * (float)(1 << level);
+
+    t.pipeline.vao = mb.vao;
+    setTerrainProgram(t, program);
+}
+
+// --------------------- Node Selection ---------------------
+inline bool sphereIntersectsAABB(const glm::vec3& center, float radius, const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    glm::vec3 d = center - glm::clamp(center, boxMin, boxMax);
+    return glm::dot(d, d) <= radius * radius;
+}
+
+inline void terrainNodeBounds(const TerrainRenderer& t, int level, int i, int j, glm::vec3& boxMin, glm::vec3& boxMax) {
+    float size = TERRAIN_SIZE / (float)(1 << (TERRAIN_LOD_LEVELS - 1 - level));
+    int count = 1 << (TERRAIN_LOD_LEVELS - 1 - level);
+    glm::vec2 range = t.heightRange[level][(size_t)j * count + i];
+    boxMin = glm::vec3(i * size - TERRAIN_SIZE * 0.5f, range.x, j * size - TERRAIN_SIZE * 0.5f);
+    boxMax = glm::vec3(boxMin.x + size, range.y, boxMin.z + size);
+}
+
+// Returns false if the node is outside its level's range, in which case the
+// parent covers its area
+inline bool selectTerrainNode(TerrainRenderer& t, const Frustum& frustum, const glm::vec3& eye, int level, int i, int j) {
+    glm::vec3 boxMin, boxMax;
+    terrainNodeBounds(t, level, i, j, boxMin, boxMax);
+    if (!sphereIntersectsAABB(eye, t.ranges[level], boxMin, boxMax))
+        return false;
+    if (!aabbInFrustum(frustum, boxMin, boxMax)) {
+        t.stats.culled++;
+        return true;
+    }
+
+    TerrainNodeDraw node{ glm::vec2(boxMin.x, boxMin.z), boxMax.x - boxMin.x, level, 0xF };
+    if (level == 0 || !sphereIntersectsAABB(eye, t.ranges[level - 1], boxMin, boxMax)) {
+        t.selection.push_back(node);
+        return true;
+    }
+
+    node.quadrants = 0;
+    for (int c = 0; c < 4; ++c) {
+        int ci = i * 2 + (c & 1), cj = j * 2 + (c >> 1);
+        if (selectTerrainNode(t, frustum, eye, level - 1, ci, cj))
+            continue;
+        glm::vec3 childMin, childMax;
+        terrainNodeBounds(t, level - 1, ci, cj, childMin, childMax);
+        if (aabbInFrustum(frustum, childMin, childMax))
+            node.quadrants |= 1 << c;
+    }
+    if (node.quadrants)
+        t.selection.push_back(node);
+    return true;
+}
+
+inline void selectTerrainNodes(TerrainRenderer& t, const glm::mat4& viewProjection, const glm::vec3& eye) {
+    t.selection.clear();
+    t.stats = TerrainStats();
+    Frustum frustum = extractFrustum(viewProjection);
+    int root = TERRAIN_LOD_LEVELS - 1;
+    if (!selectTerrainNode(t, frustum, eye, root, 0, 0)) {
+        // Camera beyond the coarsest range: draw the root as is
+        glm::vec3 boxMin, boxMax;
+        terrainNodeBounds(t, root, 0, 0, boxMin, boxMax);
+        if (aabbInFrustum(frustum, boxMin, boxMax))
+            t.selection.push_back(TerrainNodeDraw{ glm::vec2(boxMin.x, boxMin.z), TERRAIN_SIZE, root, 0xF });
+    }
+}
+
+// --------------------- Terrain Drawing ---------------------
+// Frame uniforms (view, projection, light, viewPos) are set by the caller.
+inline void drawTerrain(TerrainRenderer& t, unsigned int groundTexture) {
+    bindPipeline(t.pipeline);
+    bindTexture(1, GL_TEXTURE_2D, t.heightmapTex);
+    bindTexture(0, GL_TEXTURE_2D, groundTexture);
+
+    for (const TerrainNodeDraw& node : t.selection) {
+        float bandStart = node.level > 0 ? t.ranges[node.level - 1] : 0.0f;
+        float bandEnd = t.ranges[node.level];
+        glUniform2f(t.nodeOriginLoc, node.origin.x, node.origin.y);
+        glUniform1f(t.nodeSizeLoc, node.size);
+        glUniform2f(t.morphRangeLoc, glm::mix(bandStart, bandEnd, TERRAIN_MORPH_START), bandEnd);
+
+        if (node.quadrants == 0xF) {
+            glDrawElementsBaseVertex(GL_TRIANGLES, t.grid.indexCount, GL_UNSIGNED_INT,
+                                     (void*)t.grid.indexOffset(), t.grid.baseVertex);
+            t.stats.triangles += t.grid.indexCount / 3;
+        } else {
+            for (int q = 0; q < 4; ++q) {
+                if (!(node.quadrants & (1 << q)))
+                    continue;
+                size_t offset = t.grid.indexOffset() + (size_t)q * t.quadrantIndexCount * sizeof(unsigned int);
+                glDrawElementsBaseVertex(GL_TRIANGLES, t.quadrantIndexCount, GL_UNSIGNED_INT, (void*)offset, t.grid.baseVertex);
+                t.stats.triangles += t.quadrantIndexCount / 3;
+            }
+        }
+        t.stats.nodes++;
+    }
+}
+
+inline void printTerrainStats(const TerrainRenderer& t) {
+    std::cout << "Terrain: " << t.stats.nodes << " nodes, " << t.stats.culled << " culled, "
+              << t.stats.triangles << " triangles" << std::endl;
+}
+
+inline void destroyTerrainRenderer(TerrainRenderer& t, MeshBuffer& mb) {
+    releaseMesh(mb, t.grid);
+    glDeleteProgram(t.program);
+    glDeleteTextures(1, &t.heightmapTex);
+}
+
+#endif
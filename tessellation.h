@@ -0,0 +1,223 @@
+#ifndef TESSELLATION_H
+#define TESSELLATION_H
+
+#include <glad/glad.h>
+
+#include <iostream>
+#include <vector>
+#include <string>
+
+#include "gl_ext.h"
+#include "shader_cache.h"
+#include "pipeline_state.h"
+
+// --------------------- GPU Tessellation LOD ---------------------
+// Analytic primitives are submitted as a coarse grid of quad patches in their
+// parameter space. The control shader sizes every patch edge by its projected
+// length on screen, and the evaluation shader evaluates the surface exactly at
+// each generated vertex, so triangle density follows screen coverage with no
+// CPU work. Edge levels depend only on the edge's own endpoints, so patches
+// sharing an edge always agree and no cracks appear. Needs a GL 4.0 context;
+// without one the renderer keeps the discrete sphere LODs.
+
+const float TESS_PIXELS_PER_EDGE = 8.0f;   // target on-screen triangle edge length
+const int   TESS_SPHERE_SECTORS  = 16;     // patch grid over the sphere's (u, v) domain
+const int   TESS_SPHERE_STACKS   = 8;
+const int   TESS_GROUND_PATCHES  = 16;     // patches per side of the 100x100 ground
+
+struct TessellationRenderer {
+    unsigned int sphereProgram = 0;
+    unsigned int groundProgram = 0;
+    unsigned int sphereVAO = 0, sphereVBO = 0;
+    unsigned int groundVAO = 0, groundVBO = 0;
+    int sphereVertexCount = 0;
+    int groundVertexCount = 0;
+};
+
+// --------------------- Tessellation Shader Sources ---------------------
+// Each surface provides surfacePosition(); it is pasted into both the control
+// and the evaluation stage so they agree on the geometry.
+const char* tessSphereSurfaceSrc = R"(
+uniform float radius;
+// Same parameterisation as generateSphere(): u = sector, v = stack
+vec3 surfacePosition(vec2 p, out vec3 normal, out vec2 texCoord) {
+    const float PI = 3.14159265359;
+    float stackAngle = PI / 2.0 - p.y * PI;
+    float sectorAngle = p.x * 2.0 * PI;
+    normal = vec3(cos(stackAngle) * cos(sectorAngle), cos(stackAngle) * sin(sectorAngle), sin(stackAngle));
+    texCoord = p;
+    return radius * normal;
+}
+)";
+
+const char* tessGroundSurfaceSrc = R"(
+// Parameters are world x/z; UVs repeat 50 times over the 100 units like groundVertices
+vec3 surfacePosition(vec2 p, out vec3 normal, out vec2 texCoord) {
+    normal = vec3(0.0, 1.0, 0.0);
+    texCoord = (p + 50.0) * 0.5;
+    return vec3(p.x, 0.0, p.y);
+}
+)";
+
+const char* tessVertexShaderSrc = R"(
+#version 400 core
+layout (location = 0) in vec2 aParam;
+out vec2 vParam;
+void main() {
+    vParam = aParam;
+}
+)";
+
+const char* tessControlHeaderSrc = R"(
+#version 400 core
+layout (vertices = 4) out;
+in vec2 vParam[];
+out vec2 tcParam[];
+uniform mat4 model;
+uniform mat4 projection;
+uniform vec3 viewPos;
+uniform float viewportHeight;
+uniform float pixelsPerEdge;
+)";
+
+const char* tessControlMainSrc = R"(
+vec3 worldPosition(vec2 p) {
+    vec3 n;
+    vec2 uv;
+    return vec3(model * vec4(surfacePosition(p, n, uv), 1.0));
+}
+
+// Projected length of the edge, measured along a two-segment polyline through
+// its midpoint so curved edges are not under-estimated by their chord
+float edgeLevel(vec2 a, vec2 b) {
+    vec3 p0 = worldPosition(a);
+    vec3 pm = worldPosition((a + b) * 0.5);
+    vec3 p1 = worldPosition(b);
+    float len = distance(p0, pm) + distance(pm, p1);
+    float dist = max(distance(viewPos, pm), 1e-3);
+    float pixels = len * projection[1][1] * viewportHeight * 0.5 / dist;
+    return clamp(pixels / pixelsPerEdge, 1.0, 64.0);
+}
+
+void main() {
+    tcParam[gl_InvocationID] = vParam[gl_InvocationID];
+    if (gl_InvocationID == 0) {
+        // Quad domain edges: 0 = (u=0), 1 = (v=0), 2 = (u=1), 3 = (v=1)
+        gl_TessLevelOuter[0] = edgeLevel(vParam[0], vParam[3]);
+        gl_TessLevelOuter[1] = edgeLevel(vParam[0], vParam[1]);
+        gl_TessLevelOuter[2] = edgeLevel(vParam[1], vParam[2]);
+        gl_TessLevelOuter[3] = edgeLevel(vParam[3], vParam[2]);
+        gl_TessLevelInner[0] = max(gl_TessLevelOuter[1], gl_TessLevelOuter[3]);
+        gl_TessLevelInner[1] = max(gl_TessLevelOuter[0], gl_TessLevelOuter[2]);
+    }
+}
+)";
+
+const char* tessEvaluationHeaderSrc = R"(
+#version 400 core
+layout (quads, fractional_even_spacing, ccw) in;
+in vec2 tcParam[];
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoord;
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+)";
+
+// Outputs match objVertexShaderSrc, so the object fragment shader is reused
+const char* tessEvaluationMainSrc = R"(
+void main() {
+    vec2 p = mix(mix(tcParam[0], tcParam[1], gl_TessCoord.x),
+                 mix(tcParam[3], tcParam[2], gl_TessCoord.x), gl_TessCoord.y);
+    vec3 n;
+    vec2 uv;
+    vec3 pos = surfacePosition(p, n, uv);
+    FragPos = vec3(model * vec4(pos, 1.0));
+    Normal = mat3(transpose(inverse(model))) * n;
+    TexCoord = uv;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
+)";
+
+// --------------------- Tessellation Setup ---------------------
+inline std::string tessControlSource(const char* surfaceSrc) {
+    return std::string(tessControlHeaderSrc) + surfaceSrc + tessControlMainSrc;
+}
+
+inline std::string tessEvaluationSource(const char* surfaceSrc) {
+    return std::string(tessEvaluationHeaderSrc) + surfaceSrc + tessEvaluationMainSrc;
+}
+
+inline unsigned int createTessProgram(const char* surfaceSrc, const char* fragSrc) {
+    std::string control    = tessControlSource(surfaceSrc);
+    std::string evaluation = tessEvaluationSource(surfaceSrc);
+
+    ShaderStageSource stages[] = {
+        { GL_VERTEX_SHADER,          tessVertexShaderSrc },
+        { GL_TESS_CONTROL_SHADER,    control.c_str() },
+        { GL_TESS_EVALUATION_SHADER, evaluation.c_str() },
+        { GL_FRAGMENT_SHADER,        fragSrc }
+    };
+    return createCachedProgram(programCache, stages, 4);
+}
+
+// Quad patches covering [min, max] in parameter space, 4 vertices per patch
+inline std::vector<float> buildPatchGrid(float minU, float minV, float maxU, float maxV, int countU, int countV) {
+    std::vector<float> params;
+    params.reserve(countU * countV * 8);
+    for (int j = 0; j < countV; ++j) {
+        for (int i = 0; i < countU; ++i) {
+            float u0 = minU + (maxU - minU) * i / countU;
+            float u1 = minU + (maxU - minU) * (i + 1) / countU;
+            float v0 = minV + (maxV - minV) * j / countV;
+            float v1 = minV + (maxV - minV) * (j + 1) / countV;
+            float patch[8] = { u0, v0,  u1, v0,  u1, v1,  u0, v1 };
+            params.insert(params.end(), patch, patch + 8);
+        }
+    }
+    return params;
+}
+
+inline void uploadPatchGrid(unsigned int& vao, unsigned int& vbo, const std::vector<float>& params) {
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    bindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, params.size() * sizeof(float), params.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+}
+
+// The fragment sources are the object shader variants of the sphere and ground materials
+inline void initTessellationRenderer(TessellationRenderer& t, const char* sphereFragSrc, const char* groundFragSrc) {
+    t.sphereProgram = createTessProgram(tessSphereSurfaceSrc, sphereFragSrc);
+    t.groundProgram = createTessProgram(tessGroundSurfaceSrc, groundFragSrc);
+
+    std::vector<float> sphere = buildPatchGrid(0.0f, 0.0f, 1.0f, 1.0f, TESS_SPHERE_SECTORS, TESS_SPHERE_STACKS);
+    std::vector<float> ground = buildPatchGrid(-50.0f, -50.0f, 50.0f, 50.0f, TESS_GROUND_PATCHES, TESS_GROUND_PATCHES);
+    uploadPatchGrid(t.sphereVAO, t.sphereVBO, sphere);
+    uploadPatchGrid(t.groundVAO, t.groundVBO, ground);
+    t.sphereVertexCount = (int)sphere.size() / 2;
+    t.groundVertexCount = (int)ground.size() / 2;
+
+    glPatchParameteri(GL_PATCH_VERTICES, 4);
+}
+
+// Per-frame uniforms only the control stage needs; the rest are shared with the object shader.
+// The sphere program also needs its "radius" uniform set by the caller.
+inline void setTessellationUniforms(unsigned int program, float viewportHeight) {
+    glUniform1f(glGetUniformLocation(program, "viewportHeight"), viewportHeight);
+    glUniform1f(glGetUniformLocation(program, "pixelsPerEdge"), TESS_PIXELS_PER_EDGE);
+}
+
+inline void destroyTessellationRenderer(TessellationRenderer& t) {
+    glDeleteProgram(t.sphereProgram);
+    glDeleteProgram(t.groundProgram);
+    glDeleteVertexArrays(1, &t.sphereVAO);
+    glDeleteBuffers(1, &t.sphereVBO);
+    glDeleteVertexArrays(1, &t.groundVAO);
+    glDeleteBuffers(1, &t.groundVBO);
+}
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef VERTEX_PACKING_H
+#define VERTEX_PACKING_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+// --------------------- Packed Vertex Format ---------------------
+// 16-byte alternative to the 32-byte float layout:
+//
+//   bytes  0..7   position   3 x half float (+ 1 half padding)
+//   bytes  8..11  normal     GL_INT_2_10_10_10_REV, signed normalized
+//   bytes 12..15  texcoord   2 x half float
+//
+// Half positions keep 11 significant bits, i.e. ~0.03 units of error at the
+// ground's +-50 edge and well under 0.001 on unit-sized objects. Normals get
+// 10 bits per component. The vertex shaders see the same vec3/vec3/vec2
+// inputs as before, so no shader changes are needed.
+
+struct PackedVertex {
+    uint16_t position[4];
+    uint32_t normal;
+    uint16_t texCoord[2];
+};
+
+const int PACKED_VERTEX_STRIDE = sizeof(PackedVertex);
+
+// Round-to-nearest-even float -> IEEE half conversion
+inline uint16_t floatToHalf(float f) {
+    uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+    uint32_t sign = (x >> 16) & 0x8000;
+    uint32_t rawExponent = (x >> 23) & 0xFF;
+    uint32_t mantissa = x & 0x7FFFFF;
+
+    if (rawExponent == 0xFF)   // inf / NaN
+        return (uint16_t)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+    int exponent = (int)rawExponent - 127 + 15;
+    if (exponent >= 31)        // overflow -> inf
+        return (uint16_t)(sign | 0x7C00);
+
+    if (exponent <= 0) {       // half subnormal or zero
+        if (exponent < -10)
+            return (uint16_t)sign;
+        mantissa |= 0x800000;
+        uint32_t shift = (uint32_t)(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1)))
+            half++;
+        return (uint16_t)(sign | half);
+    }
+
+    uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1FFF;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+        half++;   // a carry into the exponent is the correct rounding
+    return (uint16_t)half;
+}
+
+// Unit vector -> signed 10:10:10:2 (w = 0)
+inline uint32_t packNormal2101010(float x, float y, float z) {
+    float len = std::sqrt(x * x + y * y + z * z);
+    if (len > 0.0f) {
+        x /= len;
+        y /= len;
+        z /= len;
+    }
+    auto component = [](float v) {
+        int i = (int)std::lround(std::max(-1.0f, std::min(1.0f, v)) * 511.0f);
+        return (uint32_t)i & 0x3FFu;
+    };
+    return component(x) | (component(y) << 10) | (component(z) << 20);
+}
+
+// 8-float vertices (position, normal, texcoord) -> packed
+inline void packVertices(const float* vertices, unsigned int vertexCount, std::vector<PackedVertex>& out) {
+    out.resize(vertexCount);
+    for (unsigned int i = 0; i < vertexCount; ++i) {
+        const float* v = vertices + (size_t)i * 8;
+        PackedVertex& p = out[i];
+        p.position[0] = floatToHalf(v[0]);
+        p.position[1] = floatToHalf(v[1]);
+        p.position[2] = floatToHalf(v[2]);
+        p.position[3] = 0;
+        p.normal = packNormal2101010(v[3], v[4], v[5]);
+        p.texCoord[0] = floatToHalf(v[6]);
+        p.texCoord[1] = floatToHalf(v[7]);
+    }
+}
+
+// Attributes 0-2 for the packed layout from the bound GL_ARRAY_BUFFER
+inline void setPackedVertexAttribs() {
+    glVertexAttribPointer(0, 3, GL_HALF_FLOAT, GL_FALSE, PACKED_VERTEX_STRIDE, (void*)offsetof(PackedVertex, position));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, PACKED_VERTEX_STRIDE, (void*)offsetof(PackedVertex, normal));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, PACKED_VERTEX_STRIDE, (void*)offsetof(PackedVertex, texCoord));
+    glEnableVertexAttribArray(2);
+}
+
+#endif